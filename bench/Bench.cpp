@@ -0,0 +1,66 @@
+#include "Bench.h"
+
+#include <sstream>
+
+namespace bench {
+    std::vector<std::pair<std::string, BenchmarkFn>>& registry() {
+        static std::vector<std::pair<std::string, BenchmarkFn>> benchmarks;
+        return benchmarks;
+    }
+
+    Registration::Registration(const char* name, BenchmarkFn fn) {
+        registry().emplace_back(name, fn);
+    }
+
+    bool Runner::matches(const std::string& name) const {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    Result& Runner::measure(const std::string& name, const std::function<void()>& body) {
+        using Clock = std::chrono::steady_clock;
+
+        // warm-up call, also catches benchmarks that take longer than minTime on their own
+        body();
+
+        uint64_t iterations = 0;
+        uint64_t batch = 1;
+        Clock::duration elapsed{};
+        while (elapsed < minTime) {
+            auto start = Clock::now();
+            for (uint64_t i = 0; i < batch; i++) {
+                body();
+            }
+            elapsed += Clock::now() - start;
+            iterations += batch;
+            batch *= 2;
+        }
+
+        double ns = std::chrono::duration<double, std::nano>(elapsed).count();
+        return report(name, iterations, ns / static_cast<double>(iterations));
+    }
+
+    Result& Runner::report(const std::string& name, uint64_t iterations, double nsPerIteration) {
+        results_.push_back({name, iterations, nsPerIteration, {}});
+        return results_.back();
+    }
+
+    void Runner::fail(const std::string& name, const std::string& reason) {
+        failures_.push_back(name + ": " + reason);
+    }
+
+    std::string toJson(const std::vector<Result>& results) {
+        std::ostringstream out;
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& result = results[i];
+            out << "    {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+                << ", \"ns_per_iteration\": " << result.nsPerIteration;
+            for (const auto& [key, value]: result.counters) {
+                out << ", \"" << key << "\": " << value;
+            }
+            out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+        return out.str();
+    }
+}
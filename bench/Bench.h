@@ -0,0 +1,74 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness for vulcan_bench. Benchmarks register themselves
+// with BENCHMARK(fn); each one calls measure() for every case it wants timed.
+namespace bench {
+    struct Result {
+        std::string name;
+        uint64_t iterations;
+        double nsPerIteration;
+        // extra per-case numbers (throughput, counts, ...)
+        std::map<std::string, double> counters;
+    };
+
+    class Runner {
+    public:
+        explicit Runner(std::chrono::milliseconds minTime) : minTime(minTime) {}
+
+        // Repeats `body` until minTime has elapsed and records the mean time per call.
+        Result& measure(const std::string& name, const std::function<void()>& body);
+
+        // Records a case timed by the benchmark itself.
+        Result& report(const std::string& name, uint64_t iterations, double nsPerIteration);
+
+        // Marks a case as failed: vulcan_bench reports it and exits non-zero,
+        // so checks that ride along with a benchmark can gate ctest.
+        void fail(const std::string& name, const std::string& reason);
+
+        [[nodiscard]] const std::vector<Result>& results() const { return results_; }
+        [[nodiscard]] const std::vector<std::string>& failures() const { return failures_; }
+
+        [[nodiscard]] bool matches(const std::string& name) const;
+
+        std::string filter;
+        // GPU benchmarks: device override (see DeviceOptions) and directory with compiled .spv files
+        std::string device;
+        std::string shaderDir = "build";
+
+    private:
+        std::chrono::milliseconds minTime;
+        std::vector<Result> results_;
+        std::vector<std::string> failures_;
+    };
+
+    using BenchmarkFn = void (*)(Runner&);
+
+    struct Registration {
+        Registration(const char* name, BenchmarkFn fn);
+    };
+
+    std::vector<std::pair<std::string, BenchmarkFn>>& registry();
+
+    std::string toJson(const std::vector<Result>& results);
+
+    // total calls to the global operator new so far (see AllocationCounter.cpp)
+    uint64_t heapAllocationCount();
+
+    // keeps the optimizer from discarding a computed value
+    template<typename T>
+    inline void doNotOptimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#define BENCHMARK(fn) static const bench::Registration fn##_registration(#fn, fn)
+
+#endif //BENCH_H
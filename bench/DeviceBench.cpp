@@ -0,0 +1,705 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/device.h"
+#include "../src/draw/DrawQueue.h"
+#include "../src/jobs/JobSystem.h"
+#include "../src/memory/DeletionQueue.h"
+#include "../src/memory/UniformRing.h"
+#include "../src/mesh/GpuMesh.h"
+#include "../src/mesh/MeshOptimizer.h"
+#include "../src/mesh/ObjLoader.h"
+#include "../src/files.h"
+#include "../src/shaders.h"
+#include "../src/pipeline/builders.h"
+#include "../src/scene/Bvh.h"
+#include "../src/scene/LodSelector.h"
+#include "../src/scene/Scene.h"
+
+namespace {
+    constexpr uint32_t targetSize = 256;
+    constexpr uint32_t steadyFrameEntities = 50000;
+    const std::string steadyFrameName = "frame/steady_state/entities:" + std::to_string(steadyFrameEntities);
+
+    // Headless device plus the minimum needed to draw: an offscreen color
+    // target, a render pass, the app's mesh shaders and a one-triangle mesh.
+    struct GpuFixture {
+        Device device;
+        DeletionQueue deletions;
+        GpuMesh triangle;
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkImage target = VK_NULL_HANDLE;
+        VkDeviceMemory targetMemory = VK_NULL_HANDLE;
+        VkImageView targetView = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        std::vector<char> vertexCode;
+        std::vector<char> fragmentCode;
+        VkShaderModule vertexShader = VK_NULL_HANDLE;
+        VkShaderModule fragmentShader = VK_NULL_HANDLE;
+
+        GpuFixture(DeviceOptions options, const std::string& shaderDir);
+        ~GpuFixture();
+
+        [[nodiscard]] bool hasShaders() const { return vertexShader != VK_NULL_HANDLE; }
+
+        [[nodiscard]] PipelineBuilder pipelineBuilder() const { return pipelineBuilder(triangle); }
+
+        [[nodiscard]] PipelineBuilder pipelineBuilder(const GpuMesh& mesh) const {
+            PipelineBuilder builder(targetSize, targetSize, renderPass, pipelineLayout);
+            builder.setVertexStage(VertexStageParamsBuilder().setShaderModule(vertexShader).build());
+            builder.setFragmentStage(FragmentStageParamsBuilder().setShaderModule(fragmentShader).build());
+            builder.setVertexInputState(
+                PipelineVertexInputStateBuilder().addMeshBinding(0, mesh.vertexStride, mesh.attributes).build());
+            return builder;
+        }
+
+        // Binds `mesh` and pushes its MeshConstants with an identity transform.
+        void bindMesh(VkCommandBuffer commandBuffer, const GpuMesh& mesh) const {
+            VkBuffer vertexBuffer = mesh.vertices.buffer.get();
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+            vkCmdBindIndexBuffer(commandBuffer, mesh.indices.buffer.get(), 0, mesh.indexType);
+            MeshConstants constants = mesh.constants(Mat4{});
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_ALL, MeshConstants::offset,
+                               sizeof(constants), &constants);
+        }
+    };
+
+    GpuFixture::GpuFixture(DeviceOptions options, const std::string& shaderDir)
+        : device(std::move(options)), deletions(device) {
+        VkDevice vkDevice = device.device();
+        triangle = uploadMesh(device, deletions,
+                              mesh_data::quantize(obj::parse("v 0 -0.5 0\nv 0.5 0.5 0\nv -0.5 0.5 0\nf 1 2 3\n")));
+
+        VkAttachmentDescription colorAttachment{};
+        colorAttachment.format = VK_FORMAT_R8G8B8A8_UNORM;
+        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        VkAttachmentReference colorReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = 1;
+        subpass.pColorAttachments = &colorReference;
+
+        VkRenderPassCreateInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        renderPassInfo.attachmentCount = 1;
+        renderPassInfo.pAttachments = &colorAttachment;
+        renderPassInfo.subpassCount = 1;
+        renderPassInfo.pSubpasses = &subpass;
+        if (vkCreateRenderPass(vkDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render pass!");
+        }
+
+        // the same push-constant range as BindlessTable's layout, for DrawQueue
+        VkPushConstantRange pushConstantRange{VK_SHADER_STAGE_ALL, 0, 128};
+        VkPipelineLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layoutInfo.pushConstantRangeCount = 1;
+        layoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(vkDevice, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        imageInfo.extent = {targetSize, targetSize, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target, targetMemory);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = target;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R8G8B8A8_UNORM;
+        viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        if (vkCreateImageView(vkDevice, &viewInfo, nullptr, &targetView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create image view!");
+        }
+
+        VkFramebufferCreateInfo framebufferInfo{};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = renderPass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &targetView;
+        framebufferInfo.width = targetSize;
+        framebufferInfo.height = targetSize;
+        framebufferInfo.layers = 1;
+        if (vkCreateFramebuffer(vkDevice, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create framebuffer!");
+        }
+
+        try {
+            vertexCode = utils::readFile(shaderDir + "/shader.vert.spv");
+            fragmentCode = utils::readFile(shaderDir + "/shader.frag.spv");
+        } catch (const std::exception&) {
+            std::cerr << "no compiled shaders in " << shaderDir << ", skipping pipeline and draw benchmarks\n";
+            return;
+        }
+        createShaderModule(vkDevice, vertexCode, vertexShader);
+        createShaderModule(vkDevice, fragmentCode, fragmentShader);
+    }
+
+    GpuFixture::~GpuFixture() {
+        VkDevice vkDevice = device.device();
+        vkDeviceWaitIdle(vkDevice);
+        vkDestroyShaderModule(vkDevice, vertexShader, nullptr);
+        vkDestroyShaderModule(vkDevice, fragmentShader, nullptr);
+        vkDestroyFramebuffer(vkDevice, framebuffer, nullptr);
+        vkDestroyImageView(vkDevice, targetView, nullptr);
+        vkDestroyImage(vkDevice, target, nullptr);
+        vkFreeMemory(vkDevice, targetMemory, nullptr);
+        vkDestroyPipelineLayout(vkDevice, pipelineLayout, nullptr);
+        vkDestroyRenderPass(vkDevice, renderPass, nullptr);
+    }
+
+    std::string sizeLabel(VkDeviceSize size) {
+        if (size >= (1u << 20)) {
+            return std::to_string(size >> 20) + "MiB";
+        }
+        return std::to_string(size >> 10) + "KiB";
+    }
+
+    void pipelineBench(bench::Runner& runner, GpuFixture& gpu) {
+        VkDevice vkDevice = gpu.device.device();
+        PipelineBuilder builder = gpu.pipelineBuilder();
+
+        // A fresh VkPipelineCache per build. Drivers with an on-disk cache (Mesa)
+        // can still hit it, so run with MESA_SHADER_CACHE_DISABLE=true for a true cold number.
+        if (runner.matches("pipeline/build_cold")) {
+            runner.measure("pipeline/build_cold", [&] {
+                VkPipelineCacheCreateInfo cacheInfo{};
+                cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+                VkPipelineCache cache;
+                vkCreatePipelineCache(vkDevice, &cacheInfo, nullptr, &cache);
+                vkDestroyPipeline(vkDevice, builder.build(vkDevice, cache), nullptr);
+                vkDestroyPipelineCache(vkDevice, cache, nullptr);
+            });
+        }
+
+        if (runner.matches("pipeline/build_warm")) {
+            VkPipelineCacheCreateInfo cacheInfo{};
+            cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            VkPipelineCache cache;
+            vkCreatePipelineCache(vkDevice, &cacheInfo, nullptr, &cache);
+            vkDestroyPipeline(vkDevice, builder.build(vkDevice, cache), nullptr);
+            runner.measure("pipeline/build_warm", [&] {
+                vkDestroyPipeline(vkDevice, builder.build(vkDevice, cache), nullptr);
+            });
+            vkDestroyPipelineCache(vkDevice, cache, nullptr);
+        }
+
+        if (runner.matches("shader/module_create")) {
+            auto& result = runner.measure("shader/module_create", [&] {
+                VkShaderModule module;
+                createShaderModule(vkDevice, gpu.vertexCode, module);
+                vkDestroyShaderModule(vkDevice, module, nullptr);
+            });
+            result.counters["spirv_bytes"] = static_cast<double>(gpu.vertexCode.size());
+        }
+    }
+
+    void bufferBench(bench::Runner& runner, GpuFixture& gpu) {
+        VkDevice vkDevice = gpu.device.device();
+        const VkDeviceSize sizes[] = {4u << 10, 256u << 10, 4u << 20, 64u << 20};
+
+        for (VkDeviceSize size: sizes) {
+            std::string name = "buffer/create/" + sizeLabel(size);
+            if (!runner.matches(name)) {
+                continue;
+            }
+            auto& result = runner.measure(name, [&] {
+                VkBuffer buffer;
+                VkDeviceMemory memory;
+                gpu.device.createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, memory);
+                vkDestroyBuffer(vkDevice, buffer, nullptr);
+                vkFreeMemory(vkDevice, memory, nullptr);
+            });
+            result.counters["buffers_per_s"] = 1e9 / result.nsPerIteration;
+        }
+
+        for (VkDeviceSize size: sizes) {
+            std::string name = "buffer/copy/" + sizeLabel(size);
+            if (!runner.matches(name)) {
+                continue;
+            }
+            VkBuffer src, dst;
+            VkDeviceMemory srcMemory, dstMemory;
+            gpu.device.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                    src, srcMemory);
+            gpu.device.createBuffer(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                    dst, dstMemory);
+            auto& result = runner.measure(name, [&] {
+                gpu.device.copyBuffer(src, dst, size);
+            });
+            // includes the submit and wait, as every copyBuffer caller pays them
+            result.counters["GB_per_s"] = static_cast<double>(size) / result.nsPerIteration;
+            vkDestroyBuffer(vkDevice, src, nullptr);
+            vkDestroyBuffer(vkDevice, dst, nullptr);
+            vkFreeMemory(vkDevice, srcMemory, nullptr);
+            vkFreeMemory(vkDevice, dstMemory, nullptr);
+        }
+
+        if (runner.matches("commands/single_time_roundtrip")) {
+            runner.measure("commands/single_time_roundtrip", [&] {
+                gpu.device.endSingleTimeCommands(gpu.device.beginSingleTimeCommands());
+            });
+        }
+    }
+
+    // Per-object uniform data for one frame: bump allocations in a mapped ring
+    // against a buffer created, written and destroyed per object.
+    void uniformBench(bench::Runner& runner, GpuFixture& gpu) {
+        struct ObjectData {
+            float model[16];
+            float color[4];
+        };
+        ObjectData data{};
+
+        constexpr uint32_t ringObjects = 10000;
+        std::string name = "uniforms/ring/objects:" + std::to_string(ringObjects);
+        if (runner.matches(name)) {
+            UniformRing ring(gpu.device, ringObjects * 256, 2, sizeof(ObjectData));
+            uint64_t frame = 0;
+            auto& result = runner.measure(name, [&] {
+                ring.beginFrame(frame++);
+                for (uint32_t i = 0; i < ringObjects; i++) {
+                    data.color[0] = static_cast<float>(i);
+                    bench::doNotOptimize(ring.push(data));
+                }
+            });
+            result.counters["ns_per_object"] = result.nsPerIteration / ringObjects;
+            result.counters["bytes_per_frame"] = static_cast<double>(ring.highWater());
+        }
+
+        constexpr uint32_t bufferObjects = 100;
+        name = "uniforms/buffer_per_object/objects:" + std::to_string(bufferObjects);
+        if (runner.matches(name)) {
+            VkDevice vkDevice = gpu.device.device();
+            auto& result = runner.measure(name, [&] {
+                for (uint32_t i = 0; i < bufferObjects; i++) {
+                    VkBuffer buffer;
+                    VkDeviceMemory memory;
+                    gpu.device.createBuffer(sizeof(ObjectData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                            buffer, memory);
+                    void* mapped;
+                    vkMapMemory(vkDevice, memory, 0, sizeof(ObjectData), 0, &mapped);
+                    std::memcpy(mapped, &data, sizeof(ObjectData));
+                    vkUnmapMemory(vkDevice, memory);
+                    vkDestroyBuffer(vkDevice, buffer, nullptr);
+                    vkFreeMemory(vkDevice, memory, nullptr);
+                }
+            });
+            result.counters["ns_per_object"] = result.nsPerIteration / bufferObjects;
+        }
+    }
+
+    // The engine's per-frame CPU path end to end: BVH cull, LOD selection,
+    // draw packets, a parallel key sort and recording. Once warm-up frames
+    // have grown every container, pool and scratch buffer to size, a frame
+    // must not reach the general heap at all; a single counted allocation
+    // fails the case.
+    void steadyFrameBench(bench::Runner& runner, GpuFixture& gpu, VkCommandBuffer commandBuffer,
+                          const std::vector<VkPipeline>& pipelines) {
+        constexpr uint32_t entityCount = steadyFrameEntities;
+        constexpr uint32_t warmupFrames = 2;
+        constexpr uint32_t checkedFrames = 16;
+        constexpr float fovY = 1.5707963f;
+        constexpr float farPlane = 500.0f;
+        const std::string name = steadyFrameName;
+        if (!runner.matches(name)) {
+            return;
+        }
+
+        // scattered ahead of a camera 20 m up looking down -Z, enough visible to split the sort
+        Scene scene;
+        scene.reserve(entityCount);
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> across(-200.0f, 200.0f);
+        std::uniform_real_distribution<float> ahead(-450.0f, -5.0f);
+        for (uint32_t i = 0; i < entityCount; i++) {
+            Transform local;
+            local.position = {across(rng), 0.0f, ahead(rng)};
+            scene.create(local, Bounds{{0.0f, 0.5f, 0.0f}, {0.5f, 0.5f, 0.5f}}, {0, i % 64});
+        }
+        scene.propagate();
+        Bvh bvh;
+        bvh.build(scene);
+        Frustum frustum = Frustum::fromViewProjection(Mat4::perspective(fovY, 1.0f, 0.1f, farPlane) *
+                                                      Mat4::translation({0.0f, -20.0f, 0.0f}));
+
+        LodSelector lodSelector;
+        lodSelector.setProjection(fovY, static_cast<float>(targetSize));
+        lodSelector.setMeshLods(0, gpu.triangle.lodErrors(), length(gpu.triangle.bounds.extents));
+
+        JobSystem jobs(JobSystem::Options{std::clamp(std::thread::hardware_concurrency(), 2u, 4u) - 1, false});
+        std::vector<DrawItem> visible;
+        DrawQueue queue;
+
+        auto frame = [&] {
+            visible.clear();
+            bvh.cull(scene, frustum, visible);
+            lodSelector.select(visible);
+
+            queue.clear();
+            for (const DrawItem& item: visible) {
+                auto pipelineIndex = static_cast<uint32_t>(item.render.material % pipelines.size());
+                DrawPacket packet = gpu.triangle.drawPacket(pipelines[pipelineIndex], item.lod);
+                packet.materialIndex = item.render.material;
+                queue.add(draw_key::make(DrawPass::Opaque, pipelineIndex, item.render.material,
+                                         draw_key::depthBucket(item.depth, farPlane)),
+                          packet);
+            }
+            queue.sort(&jobs);
+
+            VkCommandBufferBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+            vkBeginCommandBuffer(commandBuffer, &beginInfo);
+            VkClearValue clear{};
+            VkRenderPassBeginInfo passInfo{};
+            passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            passInfo.renderPass = gpu.renderPass;
+            passInfo.framebuffer = gpu.framebuffer;
+            passInfo.renderArea = {{0, 0}, {targetSize, targetSize}};
+            passInfo.clearValueCount = 1;
+            passInfo.pClearValues = &clear;
+            vkCmdBeginRenderPass(commandBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+            MeshConstants constants = gpu.triangle.constants(Mat4{});
+            vkCmdPushConstants(commandBuffer, gpu.pipelineLayout, VK_SHADER_STAGE_ALL, MeshConstants::offset,
+                               sizeof(constants), &constants);
+            queue.record(commandBuffer, gpu.pipelineLayout);
+            vkCmdEndRenderPass(commandBuffer);
+            vkEndCommandBuffer(commandBuffer);
+            vkResetCommandBuffer(commandBuffer, 0);
+        };
+
+        for (uint32_t i = 0; i < warmupFrames; i++) {
+            frame();
+        }
+        uint64_t allocationsBefore = bench::heapAllocationCount();
+        for (uint32_t i = 0; i < checkedFrames; i++) {
+            frame();
+        }
+        uint64_t allocations = bench::heapAllocationCount() - allocationsBefore;
+
+        auto& result = runner.measure(name, frame);
+        result.counters["draws"] = static_cast<double>(visible.size());
+        result.counters["heap_allocs_per_frame"] = static_cast<double>(allocations) / checkedFrames;
+        if (allocations > 0) {
+            runner.fail(name, std::to_string(allocations) + " heap allocations in " +
+                              std::to_string(checkedFrames) + " steady-state frames");
+        }
+    }
+
+    void frameBench(bench::Runner& runner, GpuFixture& gpu) {
+        VkDevice vkDevice = gpu.device.device();
+        VkPipeline pipeline = gpu.pipelineBuilder().build(vkDevice);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = gpu.device.getCommandPool();
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(vkDevice, &allocInfo, &commandBuffer);
+
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        vkCreateFence(vkDevice, &fenceInfo, nullptr, &fence);
+
+        for (uint32_t draws: {1u, 100u, 1000u, 10000u}) {
+            std::string name = "frame/draws:" + std::to_string(draws);
+            if (!runner.matches(name)) {
+                continue;
+            }
+            // record, submit and wait: the whole CPU + GPU cost of one steady-state frame
+            auto& result = runner.measure(name, [&] {
+                VkCommandBufferBeginInfo beginInfo{};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+                VkClearValue clear{};
+                VkRenderPassBeginInfo passInfo{};
+                passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                passInfo.renderPass = gpu.renderPass;
+                passInfo.framebuffer = gpu.framebuffer;
+                passInfo.renderArea = {{0, 0}, {targetSize, targetSize}};
+                passInfo.clearValueCount = 1;
+                passInfo.pClearValues = &clear;
+                vkCmdBeginRenderPass(commandBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                gpu.bindMesh(commandBuffer, gpu.triangle);
+                for (uint32_t i = 0; i < draws; i++) {
+                    vkCmdDrawIndexed(commandBuffer, 3, 1, 0, 0, i);
+                }
+                vkCmdEndRenderPass(commandBuffer);
+                vkEndCommandBuffer(commandBuffer);
+
+                VkSubmitInfo submitInfo{};
+                submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfo.commandBufferCount = 1;
+                submitInfo.pCommandBuffers = &commandBuffer;
+                {
+                    std::lock_guard lock(gpu.device.queueMutex(gpu.device.graphicsQueue()));
+                    vkQueueSubmit(gpu.device.graphicsQueue(), 1, &submitInfo, fence);
+                }
+                vkWaitForFences(vkDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+                vkResetFences(vkDevice, 1, &fence);
+                vkResetCommandBuffer(commandBuffer, 0);
+            });
+            result.counters["draws"] = draws;
+            result.counters["ns_per_draw"] = result.nsPerIteration / draws;
+        }
+
+        // Draws spread over a few pipelines and materials, recorded through a
+        // DrawQueue in submission order and in sort key order. Recording only:
+        // bind savings show up on the CPU side first.
+        constexpr uint32_t queueDraws = 10000;
+        std::vector<VkPipeline> statePipelines(8);
+        for (VkPipeline& statePipeline: statePipelines) {
+            statePipeline = gpu.pipelineBuilder().build(vkDevice);
+        }
+        std::mt19937 rng(42);
+        std::vector<std::pair<uint32_t, uint32_t>> drawStates(queueDraws);
+        for (auto& [pipelineIndex, material]: drawStates) {
+            pipelineIndex = rng() % statePipelines.size();
+            material = rng() % 64;
+        }
+        DrawQueue queue;
+        for (bool sorted: {false, true}) {
+            std::string name = "frame/draw_queue:" + std::to_string(queueDraws) + (sorted ? "/sorted" : "/unsorted");
+            if (!runner.matches(name)) {
+                continue;
+            }
+            auto& result = runner.measure(name, [&] {
+                queue.clear();
+                for (uint32_t i = 0; i < queueDraws; i++) {
+                    auto [pipelineIndex, material] = drawStates[i];
+                    DrawPacket packet;
+                    packet.pipeline = statePipelines[pipelineIndex];
+                    packet.vertexBuffer = gpu.triangle.vertices.buffer.get();
+                    packet.indexBuffer = gpu.triangle.indices.buffer.get();
+                    packet.count = 3;
+                    packet.firstInstance = i;
+                    packet.materialIndex = material;
+                    queue.add(draw_key::make(DrawPass::Opaque, pipelineIndex, material, 0), packet);
+                }
+                if (sorted) {
+                    queue.sort();
+                }
+
+                VkCommandBufferBeginInfo beginInfo{};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                vkBeginCommandBuffer(commandBuffer, &beginInfo);
+                VkClearValue clear{};
+                VkRenderPassBeginInfo passInfo{};
+                passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                passInfo.renderPass = gpu.renderPass;
+                passInfo.framebuffer = gpu.framebuffer;
+                passInfo.renderArea = {{0, 0}, {targetSize, targetSize}};
+                passInfo.clearValueCount = 1;
+                passInfo.pClearValues = &clear;
+                vkCmdBeginRenderPass(commandBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+                MeshConstants constants = gpu.triangle.constants(Mat4{});
+                vkCmdPushConstants(commandBuffer, gpu.pipelineLayout, VK_SHADER_STAGE_ALL, MeshConstants::offset,
+                                   sizeof(constants), &constants);
+                queue.record(commandBuffer, gpu.pipelineLayout);
+                vkCmdEndRenderPass(commandBuffer);
+                vkEndCommandBuffer(commandBuffer);
+                vkResetCommandBuffer(commandBuffer, 0);
+            });
+            const DrawQueue::Stats& stats = queue.stats();
+            result.counters["ns_per_draw"] = result.nsPerIteration / queueDraws;
+            result.counters["pipeline_binds"] = stats.pipelineBinds;
+            result.counters["constant_pushes"] = stats.constantPushes;
+            result.counters["binds_saved"] = stats.bindsSaved();
+        }
+        steadyFrameBench(runner, gpu, commandBuffer, statePipelines);
+        for (VkPipeline statePipeline: statePipelines) {
+            vkDestroyPipeline(vkDevice, statePipeline, nullptr);
+        }
+
+        vkDestroyFence(vkDevice, fence, nullptr);
+        vkFreeCommandBuffers(vkDevice, gpu.device.getCommandPool(), 1, &commandBuffer);
+        vkDestroyPipeline(vkDevice, pipeline, nullptr);
+    }
+
+    // A grid of quads filling the target, as OBJ text.
+    std::string gridObj(uint32_t size) {
+        std::string text;
+        for (uint32_t y = 0; y <= size; y++) {
+            for (uint32_t x = 0; x <= size; x++) {
+                float u = static_cast<float>(x) / static_cast<float>(size);
+                float v = static_cast<float>(y) / static_cast<float>(size);
+                text += "v " + std::to_string(u * 2.0f - 1.0f) + ' ' + std::to_string(v * 2.0f - 1.0f) + " 0.5\n";
+                text += "vt " + std::to_string(u) + ' ' + std::to_string(v) + '\n';
+            }
+        }
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                auto corner = [&](uint32_t cx, uint32_t cy) {
+                    std::string index = std::to_string(cy * (size + 1) + cx + 1);
+                    return index + '/' + index;
+                };
+                text += "f " + corner(x, y) + ' ' + corner(x + 1, y) + ' ' + corner(x + 1, y + 1) + ' ' +
+                        corner(x, y + 1) + '\n';
+            }
+        }
+        return text;
+    }
+
+    // The same optimized mesh drawn from the float and the quantized vertex
+    // layout: vertex fetch bandwidth and the normal decode are the only
+    // differences between the cases.
+    void meshFetchBench(bench::Runner& runner, GpuFixture& gpu) {
+        constexpr uint32_t gridSize = 256;
+        constexpr uint32_t drawsPerFrame = 16;
+        const std::string suffix = "/grid:" + std::to_string(gridSize) + "/draws:" + std::to_string(drawsPerFrame);
+        if (!runner.matches("mesh_fetch/float" + suffix) && !runner.matches("mesh_fetch/quantized" + suffix)) {
+            return;
+        }
+        VkDevice vkDevice = gpu.device.device();
+
+        MeshData standard = obj::parse(gridObj(gridSize));
+        mesh_optimizer::optimize(standard);
+        MeshData quantized = mesh_data::quantize(standard);
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = gpu.device.getCommandPool();
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer commandBuffer;
+        vkAllocateCommandBuffers(vkDevice, &allocInfo, &commandBuffer);
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        vkCreateFence(vkDevice, &fenceInfo, nullptr, &fence);
+
+        for (const auto& [label, data]: {std::pair<const char*, const MeshData*>{"float", &standard},
+                                         std::pair<const char*, const MeshData*>{"quantized", &quantized}}) {
+            std::string name = std::string("mesh_fetch/") + label + suffix;
+            if (!runner.matches(name)) {
+                continue;
+            }
+            GpuMesh mesh = uploadMesh(gpu.device, gpu.deletions, *data);
+            VkPipeline pipeline = gpu.pipelineBuilder(mesh).build(vkDevice);
+
+            auto& result = runner.measure(name, [&] {
+                VkCommandBufferBeginInfo beginInfo{};
+                beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+                vkBeginCommandBuffer(commandBuffer, &beginInfo);
+                VkClearValue clear{};
+                VkRenderPassBeginInfo passInfo{};
+                passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+                passInfo.renderPass = gpu.renderPass;
+                passInfo.framebuffer = gpu.framebuffer;
+                passInfo.renderArea = {{0, 0}, {targetSize, targetSize}};
+                passInfo.clearValueCount = 1;
+                passInfo.pClearValues = &clear;
+                vkCmdBeginRenderPass(commandBuffer, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+                gpu.bindMesh(commandBuffer, mesh);
+                for (uint32_t i = 0; i < drawsPerFrame; i++) {
+                    vkCmdDrawIndexed(commandBuffer, mesh.indexCount, 1, 0, 0, 0);
+                }
+                vkCmdEndRenderPass(commandBuffer);
+                vkEndCommandBuffer(commandBuffer);
+
+                VkSubmitInfo submitInfo{};
+                submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+                submitInfo.commandBufferCount = 1;
+                submitInfo.pCommandBuffers = &commandBuffer;
+                {
+                    std::lock_guard lock(gpu.device.queueMutex(gpu.device.graphicsQueue()));
+                    vkQueueSubmit(gpu.device.graphicsQueue(), 1, &submitInfo, fence);
+                }
+                vkWaitForFences(vkDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+                vkResetFences(vkDevice, 1, &fence);
+                vkResetCommandBuffer(commandBuffer, 0);
+            });
+            result.counters["bytes_per_vertex"] = data->vertexStride;
+            result.counters["vertex_MB_per_frame"] =
+                static_cast<double>(data->vertices.size()) * drawsPerFrame / (1 << 20);
+            result.counters["acmr"] = mesh_optimizer::analyzeVertexCache(data->indices, data->vertexCount).acmr;
+            vkDestroyPipeline(vkDevice, pipeline, nullptr);
+        }
+
+        vkDeviceWaitIdle(vkDevice);
+        vkDestroyFence(vkDevice, fence, nullptr);
+        vkFreeCommandBuffers(vkDevice, gpu.device.getCommandPool(), 1, &commandBuffer);
+    }
+
+    void deviceBench(bench::Runner& runner) {
+        // bringing up a device is slow, so only do it when the filter can select a GPU case
+        const char* gpuGroups[] = {"pipeline/", "shader/", "buffer/", "commands/", "frame/", "uniforms/",
+                                   "mesh_fetch/"};
+        bool anyMatches = false;
+        for (const char* group: gpuGroups) {
+            anyMatches = anyMatches || runner.matches(group) || runner.filter.starts_with(group);
+        }
+        if (!anyMatches) {
+            return;
+        }
+
+        DeviceOptions options;
+        if (const char* env = std::getenv("VULCAN_DEVICE")) {
+            options.preferredDevice = env;
+        }
+        if (!runner.device.empty()) {
+            options.preferredDevice = runner.device;
+        }
+
+        std::unique_ptr<GpuFixture> gpu;
+        try {
+            gpu = std::make_unique<GpuFixture>(std::move(options), runner.shaderDir);
+        } catch (const std::exception& e) {
+            std::cerr << "skipping GPU benchmarks: " << e.what() << '\n';
+            return;
+        }
+
+        bufferBench(runner, *gpu);
+        uniformBench(runner, *gpu);
+        if (gpu->hasShaders()) {
+            pipelineBench(runner, *gpu);
+            frameBench(runner, *gpu);
+            meshFetchBench(runner, *gpu);
+        } else if (!runner.filter.empty() && runner.matches(steadyFrameName)) {
+            // the allocation check is a gate; asked for by name it must not pass by not running
+            runner.fail(steadyFrameName, "no compiled shaders in " + runner.shaderDir);
+        }
+    }
+}
+
+BENCHMARK(deviceBench);
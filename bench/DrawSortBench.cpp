@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/draw/DrawQueue.h"
+#include "../src/jobs/JobSystem.h"
+#include "../src/jobs/RadixSort.h"
+
+namespace {
+    // A frame's worth of keys: mostly opaque draws over a few dozen pipelines
+    // and a few thousand materials, a tenth of them transparent.
+    std::vector<RadixSortEntry> frameKeys(uint32_t count) {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<uint32_t> pipeline(0, 31);
+        std::uniform_int_distribution<uint32_t> material(0, 4095);
+        std::uniform_real_distribution<float> depth(0.0f, 500.0f);
+        std::vector<RadixSortEntry> entries(count);
+        for (uint32_t i = 0; i < count; i++) {
+            DrawPass pass = i % 10 == 0 ? DrawPass::Transparent : DrawPass::Opaque;
+            entries[i] = {draw_key::make(pass, pipeline(rng), material(rng), draw_key::depthBucket(depth(rng), 500.0f)),
+                          i};
+        }
+        return entries;
+    }
+
+    void drawSortBench(bench::Runner& runner) {
+        uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+        for (uint32_t count: {10'000u, 100'000u, 1'000'000u}) {
+            std::string suffix = "/draws:" + std::to_string(count);
+            std::vector<RadixSortEntry> keys;
+            std::vector<RadixSortEntry> entries(count);
+            RadixSortScratch scratch;
+            auto ensureKeys = [&] {
+                if (keys.empty()) {
+                    keys = frameKeys(count);
+                }
+            };
+
+            std::string name = "draws/sort/std_sort" + suffix;
+            if (runner.matches(name)) {
+                ensureKeys();
+                auto& result = runner.measure(name, [&] {
+                    entries = keys;
+                    std::sort(entries.begin(), entries.end(),
+                              [](const RadixSortEntry& a, const RadixSortEntry& b) { return a.key < b.key; });
+                });
+                result.counters["ns_per_draw"] = result.nsPerIteration / count;
+            }
+
+            for (uint32_t threads = 1; threads <= hardwareThreads; threads *= 2) {
+                name = "draws/sort/radix" + suffix + "/threads:" + std::to_string(threads);
+                if (!runner.matches(name)) {
+                    continue;
+                }
+                ensureKeys();
+                JobSystem jobs(JobSystem::Options{threads - 1, false});
+                JobSystem* pool = threads > 1 ? &jobs : nullptr;
+                // includes the copy, like the std::sort case
+                auto& result = runner.measure(name, [&] {
+                    entries = keys;
+                    radixSort(entries, scratch, pool);
+                });
+                result.counters["ns_per_draw"] = result.nsPerIteration / count;
+            }
+        }
+    }
+}
+
+BENCHMARK(drawSortBench);
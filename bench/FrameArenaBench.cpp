@@ -0,0 +1,83 @@
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/memory/FrameArena.h"
+
+namespace {
+    struct DrawPacket {
+        uint64_t sortKey;
+        uint32_t pipeline;
+        uint32_t mesh;
+        float transform[16];
+    };
+
+    // the kind of throwaway data a frame builds: a draw list, a few debug labels
+    // and a barrier list that grows as passes are recorded
+    uint64_t simulateFrame(std::pmr::memory_resource* memory, uint32_t draws) {
+        std::pmr::vector<DrawPacket> packets(memory);
+        std::pmr::vector<std::pmr::string> labels(memory);
+        std::pmr::vector<uint32_t> barriers(memory);
+
+        for (uint32_t i = 0; i < draws; i++) {
+            packets.push_back({static_cast<uint64_t>(i) * 2654435761u, i % 7, i % 31, {}});
+            if (i % 64 == 0) {
+                labels.emplace_back("draw batch with a label longer than the small string buffer");
+                barriers.push_back(i);
+            }
+        }
+
+        uint64_t checksum = 0;
+        for (const DrawPacket& packet: packets) {
+            checksum += packet.sortKey ^ packet.mesh;
+        }
+        return checksum + labels.size() + barriers.size();
+    }
+
+    void frameArenaBench(bench::Runner& runner) {
+        constexpr uint32_t draws = 4096;
+
+        if (runner.matches("frame_arena/heap")) {
+            uint64_t allocationsBefore = 0;
+            uint64_t allocationsAfter = 0;
+            uint64_t frames = 0;
+            auto& result = runner.measure("frame_arena/heap", [&] {
+                if (frames == 0) {
+                    allocationsBefore = bench::heapAllocationCount();
+                }
+                bench::doNotOptimize(simulateFrame(std::pmr::new_delete_resource(), draws));
+                frames++;
+                allocationsAfter = bench::heapAllocationCount();
+            });
+            result.counters["heap_allocs_per_frame"] =
+                static_cast<double>(allocationsAfter - allocationsBefore) / frames;
+        }
+
+        if (runner.matches("frame_arena/arena")) {
+            FrameArena arena;
+            // warm-up frame lets the arena grow to its steady-state size
+            simulateFrame(&arena, draws);
+            arena.reset();
+
+            uint64_t allocationsBefore = 0;
+            uint64_t allocationsAfter = 0;
+            uint64_t frames = 0;
+            auto& result = runner.measure("frame_arena/arena", [&] {
+                if (frames == 0) {
+                    allocationsBefore = bench::heapAllocationCount();
+                }
+                bench::doNotOptimize(simulateFrame(&arena, draws));
+                arena.reset();
+                frames++;
+                allocationsAfter = bench::heapAllocationCount();
+            });
+            // both ends are sampled inside the loop so the harness's own allocations are not counted
+            result.counters["heap_allocs_per_frame"] =
+                static_cast<double>(allocationsAfter - allocationsBefore) / frames;
+            result.counters["arena_kib"] = static_cast<double>(arena.capacity()) / 1024.0;
+        }
+    }
+}
+
+BENCHMARK(frameArenaBench);
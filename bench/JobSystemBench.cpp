@@ -0,0 +1,56 @@
+#include <atomic>
+#include <thread>
+
+#include "Bench.h"
+#include "../src/jobs/JobSystem.h"
+
+namespace {
+    // a small fixed amount of arithmetic standing in for real per-item work
+    uint64_t spin(uint64_t seed, int rounds) {
+        for (int i = 0; i < rounds; i++) {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        return seed;
+    }
+
+    void jobSystemBench(bench::Runner& runner) {
+        uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+        if (runner.matches("jobs/empty_job_overhead")) {
+            JobSystem jobs;
+            constexpr uint32_t batch = 1024;
+            auto& result = runner.measure("jobs/empty_job_overhead", [&] {
+                JobCounter counter;
+                for (uint32_t i = 0; i < batch; i++) {
+                    jobs.run([] {}, &counter);
+                }
+                jobs.wait(counter);
+            });
+            result.counters["ns_per_job"] = result.nsPerIteration / batch;
+        }
+
+        // fixed total work split over a growing number of threads
+        constexpr uint32_t items = 1 << 16;
+        for (uint32_t threads = 1; threads <= hardwareThreads; threads *= 2) {
+            std::string name = "jobs/parallel_for/threads:" + std::to_string(threads);
+            if (!runner.matches(name)) {
+                continue;
+            }
+            JobSystem jobs(JobSystem::Options{threads - 1, false});
+            std::atomic<uint64_t> sink{0};
+            auto& result = runner.measure(name, [&] {
+                jobs.parallelFor(items, 256, [&](uint32_t begin, uint32_t end) {
+                    uint64_t local = 0;
+                    for (uint32_t i = begin; i < end; i++) {
+                        local += spin(i, 64);
+                    }
+                    sink.fetch_add(local, std::memory_order_relaxed);
+                });
+            });
+            result.counters["threads"] = threads;
+            result.counters["ns_per_item"] = result.nsPerIteration / items;
+        }
+    }
+}
+
+BENCHMARK(jobSystemBench);
@@ -0,0 +1,137 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/math/Kernels.h"
+
+namespace {
+    constexpr uint32_t objectCount = 1'000'000;
+
+    // Flat SoA storage for the kernel inputs, filled like a scattered scene
+    // with every fourth object parented to the one before it. Stored depth
+    // sorted, so the roots come first and the children, which stand near
+    // their parents, follow from `rootCount` on.
+    struct Columns {
+        uint32_t rootCount;
+        std::vector<float> local[10];
+        std::vector<uint32_t> parent;
+        std::vector<float> world[12];
+        std::vector<float> localBounds[6];
+        std::vector<float> worldBounds[6];
+        std::vector<float> radius;
+
+        explicit Columns(uint32_t count) : rootCount(count - count / 4) {
+            std::mt19937 rng(42);
+            std::uniform_real_distribution<float> ground(-1000.0f, 1000.0f);
+            std::uniform_real_distribution<float> nearby(-5.0f, 5.0f);
+            std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+            for (auto& column: local) column.resize(count);
+            for (auto& column: world) column.resize(count);
+            for (auto& column: localBounds) column.resize(count);
+            for (auto& column: worldBounds) column.resize(count);
+            parent.resize(count);
+            radius.resize(count);
+
+            for (uint32_t i = 0; i < count; i++) {
+                bool root = i < rootCount;
+                float half = angle(rng) * 0.5f;
+                local[0][i] = root ? ground(rng) : nearby(rng);
+                local[2][i] = root ? ground(rng) : nearby(rng);
+                local[4][i] = std::sin(half);
+                local[6][i] = std::cos(half);
+                local[7][i] = local[8][i] = local[9][i] = 1.0f;
+                localBounds[1][i] = 0.5f;
+                localBounds[3][i] = localBounds[4][i] = localBounds[5][i] = 0.5f;
+                // child k is object 4k + 3 of the scene, whose parent 4k + 2 is root 3k + 2
+                parent[i] = root ? kernels::noParent : (i - rootCount) * 3 + 2;
+            }
+        }
+
+        kernels::TransformSoA localSoA() const {
+            return {local[0].data(), local[1].data(), local[2].data(), local[3].data(), local[4].data(),
+                    local[5].data(), local[6].data(), local[7].data(), local[8].data(), local[9].data()};
+        }
+
+        kernels::AffineSoA worldSoA() {
+            kernels::AffineSoA soa{};
+            for (uint32_t element = 0; element < 12; element++) {
+                soa.m[element] = world[element].data();
+            }
+            return soa;
+        }
+
+        static kernels::BoundsSoA boundsSoA(std::vector<float> (&columns)[6]) {
+            return {columns[0].data(), columns[1].data(), columns[2].data(),
+                    columns[3].data(), columns[4].data(), columns[5].data()};
+        }
+    };
+
+    // Each kernel once per supported instruction set over the same data, so the
+    // scalar case is the baseline for the others.
+    void mathBench(bench::Runner& runner) {
+        const kernels::Isa detected = kernels::isa();
+        const kernels::Isa all[] = {kernels::Isa::Scalar, kernels::Isa::Sse2, kernels::Isa::Avx2};
+        auto caseName = [](const char* kernel, kernels::Isa isa) {
+            return std::string("math/") + kernel + "/" + kernels::name(isa) + "/objects:1M";
+        };
+
+        bool wanted = false;
+        for (kernels::Isa isa: all) {
+            for (const char* kernel: {"compose_world", "transform_bounds", "cull_spheres"}) {
+                wanted = wanted || runner.matches(caseName(kernel, isa));
+            }
+        }
+        if (!wanted) {
+            return;
+        }
+
+        Columns columns(objectCount);
+        Frustum frustum = Frustum::fromViewProjection(Mat4::perspective(1.5707963f, 1.0f, 0.1f, 500.0f) *
+                                                      Mat4::translation({0.0f, -20.0f, 0.0f}));
+        std::vector<uint32_t> visible(objectCount);
+        std::map<std::string, double> scalarNs;
+
+        auto record = [&](const char* kernel, kernels::Isa isa, const std::function<void()>& body) {
+            std::string name = caseName(kernel, isa);
+            if (!runner.matches(name)) {
+                return;
+            }
+            auto& result = runner.measure(name, body);
+            result.counters["ns_per_object"] = result.nsPerIteration / objectCount;
+            if (isa == kernels::Isa::Scalar) {
+                scalarNs[kernel] = result.nsPerIteration;
+            } else if (scalarNs.count(kernel)) {
+                result.counters["speedup_vs_scalar"] = scalarNs[kernel] / result.nsPerIteration;
+            }
+        };
+
+        for (kernels::Isa isa: all) {
+            if (!kernels::supported(isa)) {
+                continue;
+            }
+            kernels::setIsa(isa);
+
+            kernels::AffineSoA world = columns.worldSoA();
+            // one level at a time, as the parents must be composed first
+            record("compose_world", isa, [&] {
+                kernels::composeWorld(columns.localSoA(), columns.parent.data(), world, 0, columns.rootCount);
+                kernels::composeWorld(columns.localSoA(), columns.parent.data(), world, columns.rootCount,
+                                      objectCount);
+            });
+            record("transform_bounds", isa, [&] {
+                kernels::transformBounds(world, Columns::boundsSoA(columns.localBounds),
+                                         Columns::boundsSoA(columns.worldBounds), columns.radius.data(),
+                                         0, objectCount);
+            });
+            kernels::SphereSoA spheres{columns.worldBounds[0].data(), columns.worldBounds[1].data(),
+                                       columns.worldBounds[2].data(), columns.radius.data()};
+            record("cull_spheres", isa, [&] {
+                bench::doNotOptimize(kernels::cullSpheres(spheres, frustum, 0, objectCount, visible.data()));
+            });
+        }
+        kernels::setIsa(detected);
+    }
+}
+
+BENCHMARK(mathBench);
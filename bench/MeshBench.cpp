@@ -0,0 +1,129 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/mesh/MeshFile.h"
+#include "../src/mesh/MeshOptimizer.h"
+#include "../src/mesh/MeshSimplifier.h"
+#include "../src/mesh/ObjLoader.h"
+
+namespace {
+    constexpr uint32_t gridSize = 256;
+
+    // A gridSize x gridSize quad heightfield with normals and texture
+    // coordinates, about 66k vertices and 130k triangles.
+    void writeGridObj(const std::string& filename) {
+        std::ofstream out(filename);
+        for (uint32_t z = 0; z <= gridSize; z++) {
+            for (uint32_t x = 0; x <= gridSize; x++) {
+                float height = 0.25f * static_cast<float>((x * 7 + z * 13) % 17) / 17.0f;
+                out << "v " << x * 0.1f << ' ' << height << ' ' << z * 0.1f << '\n';
+                out << "vt " << static_cast<float>(x) / gridSize << ' ' << static_cast<float>(z) / gridSize << '\n';
+                out << "vn 0 1 0\n";
+            }
+        }
+        auto corner = [](uint32_t x, uint32_t z) {
+            std::string index = std::to_string(z * (gridSize + 1) + x + 1);
+            return index + '/' + index + '/' + index;
+        };
+        for (uint32_t z = 0; z < gridSize; z++) {
+            for (uint32_t x = 0; x < gridSize; x++) {
+                out << "f " << corner(x, z) << ' ' << corner(x, z + 1) << ' ' << corner(x + 1, z + 1) << ' '
+                    << corner(x + 1, z) << '\n';
+            }
+        }
+    }
+
+    void meshBench(bench::Runner& runner) {
+        const std::string objName = "mesh/load/obj/grid:256";
+        const std::string packedName = "mesh/load/packed/grid:256";
+        const std::string optimizeName = "mesh/optimize/grid:256";
+        const std::string simplifyName = "mesh/simplify/grid:256";
+        if (!runner.matches(objName) && !runner.matches(packedName) && !runner.matches(optimizeName) &&
+            !runner.matches(simplifyName)) {
+            return;
+        }
+
+        std::filesystem::path dir = std::filesystem::temp_directory_path() / "vulcan_mesh_bench";
+        std::filesystem::create_directories(dir);
+        std::string objPath = (dir / "grid.obj").string();
+        std::string packedPath = (dir / "grid.vmesh").string();
+        writeGridObj(objPath);
+        MeshFile::write(packedPath, obj::load(objPath));
+
+        auto throughput = [](bench::Result& result, const std::string& path) {
+            double bytes = static_cast<double>(std::filesystem::file_size(path));
+            result.counters["ms"] = result.nsPerIteration / 1e6;
+            result.counters["MB_per_s"] = bytes / result.nsPerIteration * 1e3;
+        };
+
+        // both paths end with the vertex and index bytes in a staging-sized buffer
+        std::vector<std::byte> staging;
+        if (runner.matches(objName)) {
+            auto& result = runner.measure(objName, [&] {
+                MeshData mesh = obj::load(objPath);
+                staging.resize(mesh.vertices.size() + mesh.indices.size() * sizeof(uint32_t));
+                std::memcpy(staging.data(), mesh.vertices.data(), mesh.vertices.size());
+                std::memcpy(staging.data() + mesh.vertices.size(), mesh.indices.data(),
+                            mesh.indices.size() * sizeof(uint32_t));
+                bench::doNotOptimize(staging.data());
+            });
+            throughput(result, objPath);
+        }
+        if (runner.matches(packedName)) {
+            auto& result = runner.measure(packedName, [&] {
+                MeshFile file(packedPath);
+                staging.resize(file.vertexData().size() + file.indexData().size());
+                std::memcpy(staging.data(), file.vertexData().data(), file.vertexData().size());
+                std::memcpy(staging.data() + file.vertexData().size(), file.indexData().data(),
+                            file.indexData().size());
+                bench::doNotOptimize(staging.data());
+            });
+            throughput(result, packedPath);
+        }
+
+        // the OBJ is already in row order, which is cache friendly; the import
+        // passes have to match or beat it, and quantization halves the vertex
+        if (runner.matches(optimizeName)) {
+            MeshData source = obj::load(objPath);
+            MeshData optimized;
+            auto& result = runner.measure(optimizeName, [&] {
+                optimized = source;
+                mesh_optimizer::optimize(optimized);
+            });
+            MeshData quantized = mesh_data::quantize(optimized);
+            result.counters["acmr_before"] =
+                mesh_optimizer::analyzeVertexCache(source.indices, source.vertexCount).acmr;
+            result.counters["acmr_after"] =
+                mesh_optimizer::analyzeVertexCache(optimized.indices, optimized.vertexCount).acmr;
+            result.counters["bytes_per_vertex_before"] = source.vertexStride;
+            result.counters["bytes_per_vertex_after"] = quantized.vertexStride;
+        }
+
+        // the meshpack default chain; the ridged heightfield keeps the
+        // simplifier from collapsing it to a couple of flat triangles
+        if (runner.matches(simplifyName)) {
+            MeshData source = obj::load(objPath);
+            MeshData simplified;
+            const float ratios[] = {0.5f, 0.25f, 0.125f, 0.0625f};
+            auto& result = runner.measure(simplifyName, [&] {
+                simplified = source;
+                mesh_simplifier::generateLods(simplified, ratios);
+            });
+            result.counters["ms"] = result.nsPerIteration / 1e6;
+            std::vector<mesh_format::Lod> lods = mesh_data::lods(simplified);
+            for (size_t lod = 0; lod < lods.size(); lod++) {
+                std::string suffix = "_lod" + std::to_string(lod);
+                result.counters["triangles" + suffix] = lods[lod].indexCount / 3;
+                result.counters["error" + suffix] = lods[lod].error;
+            }
+        }
+
+        std::filesystem::remove_all(dir);
+    }
+}
+
+BENCHMARK(meshBench);
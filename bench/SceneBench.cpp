@@ -0,0 +1,186 @@
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Bench.h"
+#include "../src/jobs/JobSystem.h"
+#include "../src/scene/Bvh.h"
+#include "../src/scene/LodSelector.h"
+#include "../src/scene/Scene.h"
+
+namespace {
+    constexpr uint32_t entityCount = 1'000'000;
+    // every root carries this many children one level down
+    constexpr uint32_t childrenPerRoot = 7;
+    // distinct RenderHandle::mesh values
+    constexpr uint32_t meshCount = 64;
+
+    // A LOD chain like meshpack's default for a 1 m object: triangles and
+    // object-space error per level, finest first.
+    constexpr uint32_t lodTriangles[] = {8192, 4096, 2048, 1024, 512};
+    constexpr float lodErrors[] = {0.0f, 0.002f, 0.005f, 0.012f, 0.03f};
+    // of the populate() bounds
+    constexpr float lodRadius = 0.8660254f;
+
+    // Objects scattered over a 2 km square around the origin, a third of them
+    // parented to a nearby root, drawing meshCount meshes in turn.
+    void populate(Scene& scene, bool hierarchy) {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> ground(-1000.0f, 1000.0f);
+        std::uniform_real_distribution<float> offset(-4.0f, 4.0f);
+        std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+        scene.reserve(entityCount);
+        Entity root;
+        for (uint32_t i = 0; i < entityCount; i++) {
+            float half = angle(rng) * 0.5f;
+            Transform local;
+            local.rotation = {0.0f, std::sin(half), 0.0f, std::cos(half)};
+            Bounds bounds{{0.0f, 0.5f, 0.0f}, {0.5f, 0.5f, 0.5f}};
+
+            bool child = hierarchy && i % (childrenPerRoot + 1) != 0 && i % 3 == 0;
+            if (child) {
+                local.position = {offset(rng), 0.0f, offset(rng)};
+                scene.setParent(scene.create(local, bounds, {i % meshCount, 0}), root);
+            } else {
+                local.position = {ground(rng), 0.0f, ground(rng)};
+                Entity entity = scene.create(local, bounds, {i % meshCount, 0});
+                if (i % (childrenPerRoot + 1) == 0) {
+                    root = entity;
+                }
+            }
+        }
+    }
+
+    // camera 20 m up at the origin looking down -Z, 90 degree fov, Vulkan clip space
+    constexpr float benchFovY = 1.5707963f;
+
+    Frustum benchFrustum() {
+        Mat4 viewProjection = Mat4::perspective(benchFovY, 1.0f, 0.1f, 500.0f) * Mat4::translation({0.0f, -20.0f, 0.0f});
+        return Frustum::fromViewProjection(viewProjection);
+    }
+
+    void sceneBench(bench::Runner& runner) {
+        uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+        auto caseName = [](const char* pass, const std::string& shape, uint32_t threads) {
+            return std::string("scene/") + pass + "/" + shape + "/entities:1M/threads:" + std::to_string(threads);
+        };
+        // the BVH passes are single threaded; compare bvh_cull against cull/threads:1
+        auto bvhCaseName = [](const char* pass, const std::string& shape) {
+            return std::string("scene/") + pass + "/" + shape + "/entities:1M";
+        };
+        const char* bvhPasses[] = {"bvh_build", "bvh_refit", "bvh_cull", "bvh_raycast", "lod_select"};
+
+        for (bool hierarchy: {false, true}) {
+            std::string shape = hierarchy ? "hierarchy" : "flat";
+            // building a million entities takes a while, so only for shapes the filter wants
+            bool wanted = false;
+            for (uint32_t threads = 1; threads <= hardwareThreads; threads *= 2) {
+                wanted = wanted || runner.matches(caseName("propagate", shape, threads)) ||
+                         runner.matches(caseName("cull", shape, threads));
+            }
+            for (const char* pass: bvhPasses) {
+                wanted = wanted || runner.matches(bvhCaseName(pass, shape));
+            }
+            if (!wanted) {
+                continue;
+            }
+
+            Scene scene;
+            populate(scene, hierarchy);
+            scene.propagate();
+
+            for (uint32_t threads = 1; threads <= hardwareThreads; threads *= 2) {
+                JobSystem jobs(JobSystem::Options{threads - 1, false});
+                JobSystem* pool = threads > 1 ? &jobs : nullptr;
+
+                std::string name = caseName("propagate", shape, threads);
+                if (runner.matches(name)) {
+                    auto& result = runner.measure(name, [&] { scene.propagate(pool); });
+                    result.counters["ms"] = result.nsPerIteration / 1e6;
+                    result.counters["ns_per_entity"] = result.nsPerIteration / entityCount;
+                }
+
+                name = caseName("cull", shape, threads);
+                if (runner.matches(name)) {
+                    Frustum frustum = benchFrustum();
+                    std::vector<uint32_t> visible;
+                    auto& result = runner.measure(name, [&] { scene.cull(frustum, visible, pool); });
+                    result.counters["ms"] = result.nsPerIteration / 1e6;
+                    result.counters["ns_per_entity"] = result.nsPerIteration / entityCount;
+                    result.counters["visible"] = static_cast<double>(visible.size());
+                }
+            }
+
+            Bvh bvh;
+            bvh.build(scene);
+            std::string name = bvhCaseName("bvh_build", shape);
+            if (runner.matches(name)) {
+                auto& result = runner.measure(name, [&] { bvh.build(scene); });
+                result.counters["ms"] = result.nsPerIteration / 1e6;
+                result.counters["nodes"] = static_cast<double>(bvh.nodes().size());
+                result.counters["sah_cost"] = bvh.cost();
+            }
+            name = bvhCaseName("bvh_refit", shape);
+            if (runner.matches(name)) {
+                auto& result = runner.measure(name, [&] { bvh.refit(scene); });
+                result.counters["ms"] = result.nsPerIteration / 1e6;
+            }
+            name = bvhCaseName("bvh_cull", shape);
+            if (runner.matches(name)) {
+                Frustum frustum = benchFrustum();
+                std::vector<DrawItem> visible;
+                auto& result = runner.measure(name, [&] {
+                    visible.clear();
+                    bvh.cull(scene, frustum, visible);
+                });
+                result.counters["ms"] = result.nsPerIteration / 1e6;
+                result.counters["visible"] = static_cast<double>(visible.size());
+            }
+            name = bvhCaseName("bvh_raycast", shape);
+            if (runner.matches(name)) {
+                // picking rays straight down onto the scattered objects
+                constexpr uint32_t rayCount = 1024;
+                std::mt19937 rng(7);
+                std::uniform_real_distribution<float> ground(-1000.0f, 1000.0f);
+                std::vector<Ray> rays(rayCount);
+                for (Ray& ray: rays) {
+                    ray.origin = {ground(rng), 100.0f, ground(rng)};
+                    ray.direction = {0.0f, -1.0f, 0.0f};
+                }
+                uint32_t hits = 0;
+                auto& result = runner.measure(name, [&] {
+                    hits = 0;
+                    for (const Ray& ray: rays) {
+                        hits += bvh.raycast(ray).has_value();
+                    }
+                });
+                result.counters["ns_per_ray"] = result.nsPerIteration / rayCount;
+                result.counters["hits"] = hits;
+            }
+            name = bvhCaseName("lod_select", shape);
+            if (runner.matches(name)) {
+                // the visible set of bvh_cull at 1080 lines; triangles_lod0 is
+                // what drawing everything at full detail would submit
+                LodSelector selector;
+                selector.setProjection(benchFovY, 1080.0f);
+                for (uint32_t mesh = 0; mesh < meshCount; mesh++) {
+                    selector.setMeshLods(mesh, lodErrors, lodRadius);
+                }
+                std::vector<DrawItem> visible;
+                bvh.cull(scene, benchFrustum(), visible);
+                auto& result = runner.measure(name, [&] { selector.select(visible); });
+                double selected = 0.0;
+                for (const DrawItem& item: visible) {
+                    selected += lodTriangles[item.lod];
+                }
+                result.counters["ns_per_item"] = result.nsPerIteration / static_cast<double>(visible.size());
+                result.counters["triangles_lod0"] = static_cast<double>(visible.size()) * lodTriangles[0];
+                result.counters["triangles_selected"] = selected;
+            }
+        }
+    }
+}
+
+BENCHMARK(sceneBench);
@@ -0,0 +1,60 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "Bench.h"
+
+// usage: vulcan_bench [--filter=substring] [--json=path] [--min-time-ms=N]
+//                     [--device=<index|name>] [--shaders=dir]
+// Runs headless, so `vulcan_bench --device=llvmpipe` works on lavapipe without a display.
+int main(int argc, char** argv) {
+    std::string jsonPath;
+    long minTimeMs = 200;
+    std::string filter;
+    std::string device;
+    std::string shaderDir = "build";
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--json=", 7) == 0) {
+            jsonPath = argv[i] + 7;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--min-time-ms=", 14) == 0) {
+            minTimeMs = strtol(argv[i] + 14, nullptr, 10);
+        } else if (strncmp(argv[i], "--device=", 9) == 0) {
+            device = argv[i] + 9;
+        } else if (strncmp(argv[i], "--shaders=", 10) == 0) {
+            shaderDir = argv[i] + 10;
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << '\n';
+            return 1;
+        }
+    }
+
+    bench::Runner runner{std::chrono::milliseconds(minTimeMs)};
+    runner.filter = filter;
+    runner.device = device;
+    runner.shaderDir = shaderDir;
+    for (const auto& [name, fn]: bench::registry()) {
+        fn(runner);
+    }
+
+    for (const auto& result: runner.results()) {
+        std::printf("%-48s %12.1f ns %10llu iters", result.name.c_str(), result.nsPerIteration,
+                    static_cast<unsigned long long>(result.iterations));
+        for (const auto& [key, value]: result.counters) {
+            std::printf("  %s=%g", key.c_str(), value);
+        }
+        std::printf("\n");
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream(jsonPath) << bench::toJson(runner.results());
+    }
+
+    for (const std::string& failure: runner.failures()) {
+        std::cerr << "FAILED " << failure << '\n';
+    }
+    return runner.failures().empty() ? 0 : 1;
+}
@@ -1,14 +1,20 @@
 import os
+import subprocess
+import sys
 
+# usage: compile-shaders.py [source_dir] [output_dir]
+# Defaults to the repo's src/ and build/, where the app looks for them.
 dir_path = os.path.dirname(os.path.realpath(__file__))
-build_dir = dir_path + "/../build"
+source_dir = sys.argv[1] if len(sys.argv) > 1 else dir_path + "/../src"
+build_dir = sys.argv[2] if len(sys.argv) > 2 else dir_path + "/../build"
 
 os.makedirs(build_dir, exist_ok=True)
 
-for file in os.listdir(dir_path + "/../"):
+for file in os.listdir(source_dir):
     if file.endswith(".frag") or file.endswith(".vert"):
         compiled_file = f"{build_dir}/{file}.spv"
-        source_file = f"{dir_path}/../{file}"
+        source_file = f"{source_dir}/{file}"
         if not os.path.exists(compiled_file) or os.path.getmtime(source_file) > os.path.getmtime(compiled_file):
-            os.system(f"glslc {dir_path}/../{file} -o {build_dir}/{file}.spv")
-            print(f"Compiled {file}")
\ No newline at end of file
+            if subprocess.call(["glslc", source_file, "-o", compiled_file]) != 0:
+                sys.exit(f"failed to compile {file}")
+            print(f"Compiled {file}")
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <string>
+
+#include "../src/mesh/MeshFile.h"
+#include "../src/mesh/MeshOptimizer.h"
+#include "../src/mesh/MeshSimplifier.h"
+#include "../src/mesh/ObjLoader.h"
+
+namespace {
+    // of LOD 0, the level drawn up close
+    void printCacheStats(const char* label, const MeshData& mesh) {
+        mesh_format::Lod lod = mesh_data::lods(mesh).front();
+        std::span<const uint32_t> indices(mesh.indices.data() + lod.firstIndex, lod.indexCount);
+        mesh_optimizer::CacheStats stats = mesh_optimizer::analyzeVertexCache(indices, mesh.vertexCount);
+        std::printf("  %-9s %2u bytes/vertex  ACMR %.3f  ATVR %.3f\n", label, mesh.vertexStride, stats.acmr, stats.atvr);
+    }
+}
+
+// usage: meshpack <input.obj> [output.vmesh] [--float] [--no-optimize] [--lods=N] [--lod-error=E]
+// Converts a mesh into the packed format MeshFile maps at load time: up to N
+// simplified LODs (default 4, each half the triangles of the previous one,
+// within a relative error E, default 0.02), indices reordered for the vertex
+// cache and overdraw, vertices in fetch order and quantized (QuantizedVertex)
+// unless --float is given. The output defaults to the input path with a
+// .vmesh extension.
+int main(int argc, char** argv) {
+    std::filesystem::path input;
+    std::filesystem::path output;
+    bool quantize = true;
+    bool optimize = true;
+    long lodCount = 4;
+    float lodError = 0.02f;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--lods=", 7) == 0) {
+            lodCount = std::clamp(std::strtol(argv[i] + 7, nullptr, 10), 0L, 16L);
+        } else if (std::strncmp(argv[i], "--lod-error=", 12) == 0) {
+            lodError = std::strtof(argv[i] + 12, nullptr);
+        } else if (std::strcmp(argv[i], "--float") == 0) {
+            quantize = false;
+        } else if (std::strcmp(argv[i], "--no-optimize") == 0) {
+            optimize = false;
+        } else if (argv[i][0] != '-' && input.empty()) {
+            input = argv[i];
+        } else if (argv[i][0] != '-' && output.empty()) {
+            output = argv[i];
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << '\n';
+            return 1;
+        }
+    }
+    if (input.empty()) {
+        std::cerr << "usage: meshpack <input.obj> [output.vmesh] [--float] [--no-optimize] [--lods=N] [--lod-error=E]\n";
+        return 1;
+    }
+    if (output.empty()) {
+        output = std::filesystem::path(input).replace_extension(".vmesh");
+    }
+    std::string extension = input.extension().string();
+    if (extension == ".gltf" || extension == ".glb") {
+        std::cerr << "glTF input is not supported yet; export " << input.string() << " as OBJ\n";
+        return 1;
+    }
+    if (extension != ".obj") {
+        std::cerr << "unknown mesh type: " << input.string() << '\n';
+        return 1;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        MeshData mesh = obj::load(input.string());
+        MeshData original = mesh;
+        std::vector<float> ratios;
+        for (long lod = 1; lod <= lodCount; lod++) {
+            ratios.push_back(std::ldexp(1.0f, static_cast<int>(-lod)));
+        }
+        mesh_simplifier::generateLods(mesh, ratios, lodError);
+        if (optimize) {
+            mesh_optimizer::optimize(mesh);
+        }
+        if (quantize) {
+            mesh = mesh_data::quantize(mesh);
+        }
+        MeshFile::write(output.string(), mesh);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        MeshFile packed(output.string());
+        std::printf("%s -> %s in %.1f ms\n", input.string().c_str(), output.string().c_str(), ms);
+        printCacheStats("before", original);
+        printCacheStats("after", mesh);
+        std::printf("  %u vertices, %u indices (%s), %u submeshes\n", mesh.vertexCount, packed.header().indexCount,
+                    packed.indexType() == VK_INDEX_TYPE_UINT16 ? "16-bit" : "32-bit", packed.header().submeshCount);
+        for (size_t lod = 0; lod < packed.lods().size(); lod++) {
+            std::printf("  LOD %zu: %8u triangles  error %g\n", lod, packed.lods()[lod].indexCount / 3,
+                        packed.lods()[lod].error);
+        }
+        std::printf("  %ju bytes, was %ju\n", static_cast<uintmax_t>(std::filesystem::file_size(output)),
+                    static_cast<uintmax_t>(std::filesystem::file_size(input)));
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "../src/device.h"
+#include "../src/capture/CaptureReplayer.h"
+
+namespace {
+    double percentile(std::vector<double> sorted, double p) {
+        std::sort(sorted.begin(), sorted.end());
+        size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+// usage: vulcan_replay <capture> [--device=<index|name>] [--loops=N] [--json=path]
+// Replays a capture written by CaptureRecorder on a headless device, as fast as
+// the GPU allows, and reports per-frame times.
+int main(int argc, char** argv) {
+    std::string capturePath;
+    std::string jsonPath;
+    long loops = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--json=", 7) == 0) {
+            jsonPath = argv[i] + 7;
+        } else if (strncmp(argv[i], "--loops=", 8) == 0) {
+            loops = std::max(1L, strtol(argv[i] + 8, nullptr, 10));
+        } else if (strncmp(argv[i], "--device=", 9) == 0) {
+            // picked up by DeviceOptions::fromCommandLine
+        } else if (argv[i][0] != '-' && capturePath.empty()) {
+            capturePath = argv[i];
+        } else {
+            std::cerr << "unknown argument: " << argv[i] << '\n';
+            return 1;
+        }
+    }
+    if (capturePath.empty()) {
+        std::cerr << "usage: vulcan_replay <capture> [--device=<index|name>] [--loops=N] [--json=path]\n";
+        return 1;
+    }
+
+    try {
+        Device device(DeviceOptions::fromCommandLine(argc, argv));
+        CaptureReplayer replayer(device, capturePath);
+        if (replayer.frameCount() == 0) {
+            std::cerr << capturePath << " contains no complete frames\n";
+            return 1;
+        }
+
+        std::vector<double> frameTimes;
+        for (long loop = 0; loop < loops; loop++) {
+            std::vector<double> times = replayer.replayFrames();
+            frameTimes.insert(frameTimes.end(), times.begin(), times.end());
+        }
+
+        double mean = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0) / static_cast<double>(frameTimes.size());
+        double p50 = percentile(frameTimes, 0.5);
+        double p99 = percentile(frameTimes, 0.99);
+
+        for (size_t i = 0; i < frameTimes.size(); i++) {
+            std::printf("frame %-6zu %10.3f ms\n", i, frameTimes[i]);
+        }
+        std::printf("%zu frames  mean %.3f ms  p50 %.3f ms  p99 %.3f ms\n", frameTimes.size(), mean, p50, p99);
+
+        if (!jsonPath.empty()) {
+            std::ofstream json(jsonPath);
+            json << "{\n  \"capture\": \"" << capturePath << "\",\n  \"frames_ms\": [";
+            for (size_t i = 0; i < frameTimes.size(); i++) {
+                json << (i ? ", " : "") << frameTimes[i];
+            }
+            json << "],\n  \"mean_ms\": " << mean << ",\n  \"p50_ms\": " << p50
+                 << ",\n  \"p99_ms\": " << p99 << "\n}\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
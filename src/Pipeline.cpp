@@ -7,6 +7,7 @@ Pipeline::Pipeline(Device& device, VkPipeline pipeline, VkShaderModule vertexSha
 }
 
 Pipeline::~Pipeline() {
-    vkDestroyPipeline(device.device(), pipeline, nullptr);
-    vkDestroyShaderModule(device.device(), vertexShaderModule, nullptr);
+    // a frame still in flight may have the pipeline bound
+    device.deletionQueue().enqueue(pipeline);
+    device.deletionQueue().enqueue(vertexShaderModule);
 }
@@ -0,0 +1,18 @@
+// Shared declarations for the bindless resource table (see descriptors/BindlessTable.h).
+// Include after the #version line of any shader built against BindlessTable::pipelineLayout().
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout (set = 0, binding = 0) uniform sampler2D bindlessTextures[];
+
+layout (set = 0, binding = 1) readonly buffer BindlessBuffer {
+    uint words[];
+} bindlessBuffers[];
+
+layout (push_constant) uniform DrawConstants {
+    uint materialIndex;
+    uint bufferIndex;
+} draw;
+
+vec4 sampleBindless(uint textureIndex, vec2 uv) {
+    return texture(bindlessTextures[nonuniformEXT(textureIndex)], uv);
+}
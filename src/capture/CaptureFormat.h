@@ -0,0 +1,162 @@
+#ifndef CAPTURE_FORMAT_H
+#define CAPTURE_FORMAT_H
+
+#include <cstdint>
+#include <type_traits>
+
+#include "../pipeline/PipelineState.h"
+
+// On-disk layout of a command stream capture: a FileHeader followed by
+// records, each a RecordHeader and `size` bytes of payload. A payload is one
+// of the structs below, optionally followed by trailing bytes (buffer
+// contents, SPIR-V, push constants, vertex input descriptions). Objects are
+// referred to by capture ids that start at 1; handles never reach the file.
+//
+// Payloads are written as raw host-endian structs, so bump `version` whenever
+// one of them (or PipelineStateDesc) changes layout.
+namespace capture {
+    constexpr uint32_t magic = 0x50414356; // "VCAP"
+    constexpr uint32_t version = 2;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    enum class Op : uint16_t {
+        BeginFrame = 1,
+        EndFrame,
+        CreateBuffer,
+        UploadBuffer,
+        CopyBuffer,
+        CreateShaderModule,
+        CreateRenderTarget,
+        CreatePipeline,
+        BeginPass,
+        EndPass,
+        BindPipeline,
+        BindVertexBuffer,
+        BindIndexBuffer,
+        PushConstants,
+        Draw,
+        DrawIndexed,
+    };
+
+    struct RecordHeader {
+        Op op;
+        uint16_t reserved;
+        uint32_t size;
+    };
+
+    struct BeginFrame {
+        uint64_t frame;
+    };
+
+    struct CreateBuffer {
+        uint32_t id;
+        uint32_t usage;
+        uint32_t memoryProperties;
+        uint32_t reserved;
+        uint64_t size;
+    };
+
+    // followed by the uploaded bytes
+    struct UploadBuffer {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t offset;
+    };
+
+    struct CopyBuffer {
+        uint32_t src;
+        uint32_t dst;
+        uint64_t size;
+    };
+
+    // followed by the SPIR-V
+    struct CreateShaderModule {
+        uint32_t id;
+        uint32_t stage;
+    };
+
+    // Replayed as an offscreen color target with a single-subpass render pass.
+    struct CreateRenderTarget {
+        uint32_t id;
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;
+    };
+
+    // followed by bindingCount VertexBindings, then attributeCount VertexAttributes
+    struct CreatePipeline {
+        uint32_t id;
+        uint32_t target;
+        uint32_t vertexShader;
+        uint32_t fragmentShader;
+        uint32_t bindingCount;
+        uint32_t attributeCount;
+        PipelineStateDesc state;
+    };
+
+    struct VertexBinding {
+        uint32_t binding;
+        uint32_t stride;
+        uint32_t inputRate;
+    };
+
+    struct VertexAttribute {
+        uint32_t location;
+        uint32_t binding;
+        uint32_t format;
+        uint32_t offset;
+    };
+
+    struct BeginPass {
+        uint32_t target;
+        float clearColor[4];
+    };
+
+    struct BindPipeline {
+        uint32_t id;
+    };
+
+    struct BindVertexBuffer {
+        uint32_t binding;
+        uint32_t buffer;
+        uint64_t offset;
+    };
+
+    struct BindIndexBuffer {
+        uint32_t buffer;
+        uint32_t indexType;
+        uint64_t offset;
+    };
+
+    // followed by the constant bytes
+    struct PushConstants {
+        uint32_t stages;
+        uint32_t offset;
+    };
+
+    struct Draw {
+        uint32_t vertexCount;
+        uint32_t instanceCount;
+        uint32_t firstVertex;
+        uint32_t firstInstance;
+    };
+
+    struct DrawIndexed {
+        uint32_t indexCount;
+        uint32_t instanceCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t firstInstance;
+    };
+
+    // Replay pipelines share one layout with this much push constant space.
+    constexpr uint32_t pushConstantSize = 128;
+
+    static_assert(std::is_trivially_copyable_v<PipelineStateDesc>);
+}
+
+#endif //CAPTURE_FORMAT_H
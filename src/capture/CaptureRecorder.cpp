@@ -0,0 +1,152 @@
+#include "CaptureRecorder.h"
+
+#include <stdexcept>
+
+#include "../device.h"
+#include "../shaders.h"
+#include "../pipeline/PipelineBuilder.h"
+
+CaptureRecorder::CaptureRecorder(const std::string& path) : out(path, std::ios::binary | std::ios::trunc) {
+    if (!out.is_open()) {
+        throw std::runtime_error("failed to open capture file " + path);
+    }
+    capture::FileHeader header{capture::magic, capture::version};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    written = sizeof(header);
+}
+
+void CaptureRecorder::write(capture::Op op) {
+    capture::RecordHeader header{op, 0, 0};
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    written += sizeof(header);
+}
+
+void CaptureRecorder::createBuffer(Device& device, VkDeviceSize size, VkBufferUsageFlags usage,
+                                   VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+    device.createBuffer(size, usage, properties, buffer, bufferMemory);
+    write(capture::Op::CreateBuffer, capture::CreateBuffer{assignId(buffer), usage, properties, 0, size});
+}
+
+void CaptureRecorder::uploadBuffer(Device& device, VkBuffer buffer, VkDeviceSize offset,
+                                   std::span<const std::byte> data) {
+    uint32_t id = idOf(buffer, "buffer");
+    device.uploadBuffer(buffer, offset, data.data(), data.size());
+    write(capture::Op::UploadBuffer, capture::UploadBuffer{id, 0, offset}, data);
+}
+
+void CaptureRecorder::copyBuffer(Device& device, VkBuffer src, VkBuffer dst, VkDeviceSize size) {
+    capture::CopyBuffer copy{idOf(src, "buffer"), idOf(dst, "buffer"), size};
+    device.copyBuffer(src, dst, size);
+    write(capture::Op::CopyBuffer, copy);
+}
+
+void CaptureRecorder::createShaderModule(VkDevice device, const std::vector<char>& code, VkShaderStageFlagBits stage,
+                                         VkShaderModule& shaderModule) {
+    ::createShaderModule(device, code, shaderModule);
+    write(capture::Op::CreateShaderModule, capture::CreateShaderModule{assignId(shaderModule), stage},
+          std::as_bytes(std::span(code)));
+}
+
+void CaptureRecorder::registerRenderTarget(VkRenderPass renderPass, uint32_t width, uint32_t height, VkFormat format) {
+    write(capture::Op::CreateRenderTarget,
+          capture::CreateRenderTarget{assignId(renderPass), width, height, static_cast<uint32_t>(format)});
+}
+
+VkPipeline CaptureRecorder::buildPipeline(const PipelineBuilder& builder, VkDevice device, VkPipelineCache cache) {
+    uint32_t target = idOf(builder.getRenderPass(), "pipeline render pass");
+    uint32_t vertexShader = idOf(builder.getVertexStage().module, "vertex shader module");
+    uint32_t fragmentShader = idOf(builder.getFragmentStage().module, "fragment shader module");
+
+    const auto& bindings = builder.getVertexBindings();
+    const auto& attributes = builder.getVertexAttributes();
+    std::vector<std::byte> vertexInput;
+    vertexInput.reserve(bindings.size() * sizeof(capture::VertexBinding) +
+                        attributes.size() * sizeof(capture::VertexAttribute));
+    auto append = [&vertexInput](const auto& description) {
+        auto bytes = std::as_bytes(std::span(&description, 1));
+        vertexInput.insert(vertexInput.end(), bytes.begin(), bytes.end());
+    };
+    for (const VkVertexInputBindingDescription& binding: bindings) {
+        append(capture::VertexBinding{binding.binding, binding.stride, static_cast<uint32_t>(binding.inputRate)});
+    }
+    for (const VkVertexInputAttributeDescription& attribute: attributes) {
+        append(capture::VertexAttribute{attribute.location, attribute.binding, static_cast<uint32_t>(attribute.format),
+                                        attribute.offset});
+    }
+
+    VkPipeline pipeline = builder.build(device, cache);
+    write(capture::Op::CreatePipeline,
+          capture::CreatePipeline{assignId(pipeline), target, vertexShader, fragmentShader,
+                                  static_cast<uint32_t>(bindings.size()), static_cast<uint32_t>(attributes.size()),
+                                  builder.effectiveState()},
+          vertexInput);
+    return pipeline;
+}
+
+void CaptureRecorder::beginFrame() {
+    write(capture::Op::BeginFrame, capture::BeginFrame{frame++});
+}
+
+void CaptureRecorder::endFrame() {
+    write(capture::Op::EndFrame);
+    out.flush();
+}
+
+void CaptureRecorder::beginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo& beginInfo) {
+    capture::BeginPass pass{idOf(beginInfo.renderPass, "render pass"), {0.0f, 0.0f, 0.0f, 0.0f}};
+    if (beginInfo.clearValueCount > 0) {
+        for (int i = 0; i < 4; i++) {
+            pass.clearColor[i] = beginInfo.pClearValues[0].color.float32[i];
+        }
+    }
+
+    vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    write(capture::Op::BeginPass, pass);
+}
+
+void CaptureRecorder::endRenderPass(VkCommandBuffer commandBuffer) {
+    vkCmdEndRenderPass(commandBuffer);
+    write(capture::Op::EndPass);
+}
+
+void CaptureRecorder::bindPipeline(VkCommandBuffer commandBuffer, VkPipeline pipeline) {
+    uint32_t id = idOf(pipeline, "pipeline");
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    write(capture::Op::BindPipeline, capture::BindPipeline{id});
+}
+
+void CaptureRecorder::bindVertexBuffer(VkCommandBuffer commandBuffer, uint32_t binding, VkBuffer buffer,
+                                       VkDeviceSize offset) {
+    uint32_t id = idOf(buffer, "vertex buffer");
+    vkCmdBindVertexBuffers(commandBuffer, binding, 1, &buffer, &offset);
+    write(capture::Op::BindVertexBuffer, capture::BindVertexBuffer{binding, id, offset});
+}
+
+void CaptureRecorder::bindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset,
+                                      VkIndexType indexType) {
+    uint32_t id = idOf(buffer, "index buffer");
+    vkCmdBindIndexBuffer(commandBuffer, buffer, offset, indexType);
+    write(capture::Op::BindIndexBuffer, capture::BindIndexBuffer{id, static_cast<uint32_t>(indexType), offset});
+}
+
+void CaptureRecorder::pushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stages,
+                                    uint32_t offset, std::span<const std::byte> data) {
+    if (offset + data.size() > capture::pushConstantSize) {
+        throw std::runtime_error("captured push constants must fit in capture::pushConstantSize bytes");
+    }
+    vkCmdPushConstants(commandBuffer, layout, stages, offset, static_cast<uint32_t>(data.size()), data.data());
+    write(capture::Op::PushConstants, capture::PushConstants{stages, offset}, data);
+}
+
+void CaptureRecorder::draw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount,
+                           uint32_t firstVertex, uint32_t firstInstance) {
+    vkCmdDraw(commandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    write(capture::Op::Draw, capture::Draw{vertexCount, instanceCount, firstVertex, firstInstance});
+}
+
+void CaptureRecorder::drawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount,
+                                  uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    write(capture::Op::DrawIndexed,
+          capture::DrawIndexed{indexCount, instanceCount, firstIndex, vertexOffset, firstInstance});
+}
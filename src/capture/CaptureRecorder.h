@@ -0,0 +1,111 @@
+#ifndef CAPTURE_RECORDER_H
+#define CAPTURE_RECORDER_H
+
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "CaptureFormat.h"
+
+class Device;
+class PipelineBuilder;
+
+// Thin layer over Device, PipelineBuilder and vkCmd* that performs each call
+// and appends it to a capture file (see CaptureFormat.h) for vulcan_replay.
+// Only work that goes through the recorder is captured; descriptor sets and
+// raw Vulkan calls made elsewhere are not.
+class CaptureRecorder {
+public:
+    explicit CaptureRecorder(const std::string& path);
+
+    CaptureRecorder(const CaptureRecorder&) = delete;
+    CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+    void createBuffer(Device& device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties,
+                      VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    void uploadBuffer(Device& device, VkBuffer buffer, VkDeviceSize offset, std::span<const std::byte> data);
+    void copyBuffer(Device& device, VkBuffer src, VkBuffer dst, VkDeviceSize size);
+
+    void createShaderModule(VkDevice device, const std::vector<char>& code, VkShaderStageFlagBits stage,
+                            VkShaderModule& shaderModule);
+
+    // Declares the render pass pipelines and passes will target. Replay draws
+    // into an offscreen image of this size and format instead.
+    void registerRenderTarget(VkRenderPass renderPass, uint32_t width, uint32_t height, VkFormat format);
+
+    // Shader modules and the render pass must have gone through the recorder.
+    VkPipeline buildPipeline(const PipelineBuilder& builder, VkDevice device, VkPipelineCache cache = VK_NULL_HANDLE);
+
+    void beginFrame();
+    void endFrame();
+
+    void beginRenderPass(VkCommandBuffer commandBuffer, const VkRenderPassBeginInfo& beginInfo);
+    void endRenderPass(VkCommandBuffer commandBuffer);
+    void bindPipeline(VkCommandBuffer commandBuffer, VkPipeline pipeline);
+    void bindVertexBuffer(VkCommandBuffer commandBuffer, uint32_t binding, VkBuffer buffer, VkDeviceSize offset);
+    void bindIndexBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+    void pushConstants(VkCommandBuffer commandBuffer, VkPipelineLayout layout, VkShaderStageFlags stages,
+                       uint32_t offset, std::span<const std::byte> data);
+    void draw(VkCommandBuffer commandBuffer, uint32_t vertexCount, uint32_t instanceCount,
+              uint32_t firstVertex, uint32_t firstInstance);
+    void drawIndexed(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t instanceCount,
+                     uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+
+    [[nodiscard]] uint64_t bytesWritten() const { return written; }
+
+private:
+    std::ofstream out;
+    uint64_t written = 0;
+    uint64_t frame = 0;
+    uint32_t nextId = 1;
+    // Vulkan handle -> capture id, for every object created through the recorder
+    std::unordered_map<uint64_t, uint32_t> ids;
+
+    template<typename Handle>
+    static uint64_t key(Handle handle) {
+        if constexpr (std::is_pointer_v<Handle>) {
+            return reinterpret_cast<uintptr_t>(handle);
+        } else {
+            return static_cast<uint64_t>(handle);
+        }
+    }
+
+    template<typename Handle>
+    uint32_t assignId(Handle handle) {
+        uint32_t id = nextId++;
+        ids[key(handle)] = id;
+        return id;
+    }
+
+    // Throws for handles the recorder never saw; writing id 0 would leave a
+    // capture that only fails, far from the cause, at replay.
+    template<typename Handle>
+    uint32_t idOf(Handle handle, const char* what) const {
+        auto it = ids.find(key(handle));
+        if (it == ids.end()) {
+            throw std::runtime_error(std::string("captured ") + what + " was not created through the recorder");
+        }
+        return it->second;
+    }
+
+    // records without a payload
+    void write(capture::Op op);
+
+    template<typename Payload>
+    void write(capture::Op op, const Payload& payload, std::span<const std::byte> trailing = {}) {
+        static_assert(std::is_trivially_copyable_v<Payload>);
+        capture::RecordHeader header{op, 0, static_cast<uint32_t>(sizeof(Payload) + trailing.size())};
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(&payload), sizeof(Payload));
+        out.write(reinterpret_cast<const char*>(trailing.data()), static_cast<std::streamsize>(trailing.size()));
+        written += sizeof(header) + header.size;
+    }
+};
+
+#endif //CAPTURE_RECORDER_H
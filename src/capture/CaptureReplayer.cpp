@@ -0,0 +1,394 @@
+#include "CaptureReplayer.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include "../device.h"
+#include "../files.h"
+#include "../shaders.h"
+#include "../pipeline/builders.h"
+
+namespace {
+    // Objects that are never recreated under the same id; they are built once
+    // at load wherever they were recorded, so replay loops neither leak them nor
+    // time their compiles.
+    bool createdOnce(capture::Op op) {
+        return op == capture::Op::CreateShaderModule || op == capture::Op::CreateRenderTarget ||
+               op == capture::Op::CreatePipeline;
+    }
+}
+
+template<typename Payload>
+Payload CaptureReplayer::read(const Record& record) {
+    if (record.size < sizeof(Payload)) {
+        throw std::runtime_error("truncated capture record");
+    }
+    Payload payload;
+    std::memcpy(&payload, record.payload, sizeof(Payload));
+    return payload;
+}
+
+CaptureReplayer::CaptureReplayer(Device& device, const std::string& path)
+    : device(device), file(utils::readFile(path)) {
+    parse();
+
+    VkPushConstantRange pushRange{VK_SHADER_STAGE_ALL, 0, capture::pushConstantSize};
+    VkPipelineLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushRange;
+    if (vkCreatePipelineLayout(device.device(), &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create replay pipeline layout!");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = device.getCommandPool();
+    allocInfo.commandBufferCount = 1;
+    vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    vkCreateFence(device.device(), &fenceInfo, nullptr, &fence);
+
+    for (const Record& record: setup) {
+        execute(record, VK_NULL_HANDLE);
+    }
+}
+
+CaptureReplayer::~CaptureReplayer() {
+    VkDevice vkDevice = device.device();
+    vkDeviceWaitIdle(vkDevice);
+
+    for (const auto& [id, pipeline]: pipelines) {
+        vkDestroyPipeline(vkDevice, pipeline, nullptr);
+    }
+    for (const auto& [id, module]: shaderModules) {
+        vkDestroyShaderModule(vkDevice, module, nullptr);
+    }
+    for (const auto& [id, target]: targets) {
+        vkDestroyFramebuffer(vkDevice, target.framebuffer, nullptr);
+        vkDestroyImageView(vkDevice, target.view, nullptr);
+        vkDestroyImage(vkDevice, target.image, nullptr);
+        vkFreeMemory(vkDevice, target.memory, nullptr);
+        vkDestroyRenderPass(vkDevice, target.renderPass, nullptr);
+    }
+    for (const auto& [id, buffer]: buffers) {
+        vkDestroyBuffer(vkDevice, buffer.buffer, nullptr);
+        vkFreeMemory(vkDevice, buffer.memory, nullptr);
+    }
+    vkDestroyFence(vkDevice, fence, nullptr);
+    vkFreeCommandBuffers(vkDevice, device.getCommandPool(), 1, &commandBuffer);
+    vkDestroyPipelineLayout(vkDevice, pipelineLayout, nullptr);
+}
+
+void CaptureReplayer::parse() {
+    capture::FileHeader header{};
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("not a capture file");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != capture::magic) {
+        throw std::runtime_error("not a capture file");
+    }
+    if (header.version != capture::version) {
+        throw std::runtime_error("capture version " + std::to_string(header.version) + " is not supported");
+    }
+
+    // resource records between frames are carried into the frame that follows
+    std::vector<Record> pending;
+    bool inFrame = false;
+    size_t offset = sizeof(header);
+    while (offset < file.size()) {
+        capture::RecordHeader recordHeader{};
+        if (file.size() - offset < sizeof(recordHeader)) {
+            throw std::runtime_error("truncated capture record");
+        }
+        std::memcpy(&recordHeader, file.data() + offset, sizeof(recordHeader));
+        offset += sizeof(recordHeader);
+        if (file.size() - offset < recordHeader.size) {
+            throw std::runtime_error("truncated capture record");
+        }
+
+        Record record{recordHeader.op, reinterpret_cast<const std::byte*>(file.data() + offset), recordHeader.size};
+        offset += recordHeader.size;
+
+        if (record.op == capture::Op::BeginFrame) {
+            frames.push_back(std::move(pending));
+            pending.clear();
+            inFrame = true;
+        } else if (record.op == capture::Op::EndFrame) {
+            inFrame = false;
+        } else if (createdOnce(record.op)) {
+            setup.push_back(record);
+        } else if (inFrame) {
+            frames.back().push_back(record);
+        } else if (frames.empty()) {
+            setup.push_back(record);
+        } else {
+            pending.push_back(record);
+        }
+    }
+
+    // a capture cut off mid-frame drops the partial frame
+    if (inFrame) {
+        frames.pop_back();
+    }
+}
+
+void CaptureReplayer::destroyBuffer(uint32_t id) {
+    auto it = buffers.find(id);
+    if (it != buffers.end()) {
+        vkDestroyBuffer(device.device(), it->second.buffer, nullptr);
+        vkFreeMemory(device.device(), it->second.memory, nullptr);
+        buffers.erase(it);
+    }
+}
+
+void CaptureReplayer::createTarget(const capture::CreateRenderTarget& info) {
+    VkDevice vkDevice = device.device();
+    auto format = static_cast<VkFormat>(info.format);
+    Target target{info.width, info.height};
+
+    VkAttachmentDescription colorAttachment{};
+    colorAttachment.format = format;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference colorReference{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorReference;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &colorAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    if (vkCreateRenderPass(vkDevice, &renderPassInfo, nullptr, &target.renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create replay render pass!");
+    }
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {info.width, info.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, target.image, target.memory);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = target.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    if (vkCreateImageView(vkDevice, &viewInfo, nullptr, &target.view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create replay image view!");
+    }
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = target.renderPass;
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = &target.view;
+    framebufferInfo.width = info.width;
+    framebufferInfo.height = info.height;
+    framebufferInfo.layers = 1;
+    if (vkCreateFramebuffer(vkDevice, &framebufferInfo, nullptr, &target.framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create replay framebuffer!");
+    }
+
+    targets[info.id] = target;
+}
+
+void CaptureReplayer::execute(const Record& record, VkCommandBuffer recording) {
+    VkDevice vkDevice = device.device();
+
+    switch (record.op) {
+        case capture::Op::CreateBuffer: {
+            auto info = read<capture::CreateBuffer>(record);
+            destroyBuffer(info.id);
+            Buffer buffer{};
+            // replay uploads through staging, so every buffer must accept transfers
+            device.createBuffer(info.size, info.usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                info.memoryProperties, buffer.buffer, buffer.memory);
+            buffers[info.id] = buffer;
+            break;
+        }
+        case capture::Op::UploadBuffer: {
+            auto info = read<capture::UploadBuffer>(record);
+            device.uploadBuffer(buffers.at(info.id).buffer, info.offset, record.payload + sizeof(info),
+                                record.size - sizeof(info));
+            break;
+        }
+        case capture::Op::CopyBuffer: {
+            auto info = read<capture::CopyBuffer>(record);
+            device.copyBuffer(buffers.at(info.src).buffer, buffers.at(info.dst).buffer, info.size);
+            break;
+        }
+        case capture::Op::CreateShaderModule: {
+            auto info = read<capture::CreateShaderModule>(record);
+            std::vector<char> code(record.size - sizeof(info));
+            std::memcpy(code.data(), record.payload + sizeof(info), code.size());
+            VkShaderModule module;
+            createShaderModule(vkDevice, code, module);
+            shaderModules[info.id] = module;
+            break;
+        }
+        case capture::Op::CreateRenderTarget:
+            createTarget(read<capture::CreateRenderTarget>(record));
+            break;
+        case capture::Op::CreatePipeline: {
+            auto info = read<capture::CreatePipeline>(record);
+            const Target& target = targets.at(info.target);
+            PipelineBuilder builder(static_cast<float>(target.width), static_cast<float>(target.height),
+                                    target.renderPass, pipelineLayout);
+            builder.setState(info.state);
+
+            const std::byte* descriptions = record.payload + sizeof(info);
+            size_t vertexInputSize = info.bindingCount * sizeof(capture::VertexBinding) +
+                                     info.attributeCount * sizeof(capture::VertexAttribute);
+            if (record.size - sizeof(info) < vertexInputSize) {
+                throw std::runtime_error("truncated capture record");
+            }
+            std::vector<VkVertexInputBindingDescription> bindings(info.bindingCount);
+            for (VkVertexInputBindingDescription& binding: bindings) {
+                capture::VertexBinding stored;
+                std::memcpy(&stored, descriptions, sizeof(stored));
+                descriptions += sizeof(stored);
+                binding = {stored.binding, stored.stride, static_cast<VkVertexInputRate>(stored.inputRate)};
+            }
+            std::vector<VkVertexInputAttributeDescription> attributes(info.attributeCount);
+            for (VkVertexInputAttributeDescription& attribute: attributes) {
+                capture::VertexAttribute stored;
+                std::memcpy(&stored, descriptions, sizeof(stored));
+                descriptions += sizeof(stored);
+                attribute = {stored.location, stored.binding, static_cast<VkFormat>(stored.format), stored.offset};
+            }
+            VkPipelineVertexInputStateCreateInfo vertexInput{};
+            vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+            vertexInput.vertexBindingDescriptionCount = info.bindingCount;
+            vertexInput.pVertexBindingDescriptions = bindings.data();
+            vertexInput.vertexAttributeDescriptionCount = info.attributeCount;
+            vertexInput.pVertexAttributeDescriptions = attributes.data();
+            builder.setVertexInputState(vertexInput);
+
+            builder.setVertexStage(VertexStageParamsBuilder().setShaderModule(shaderModules.at(info.vertexShader)).build());
+            builder.setFragmentStage(
+                FragmentStageParamsBuilder().setShaderModule(shaderModules.at(info.fragmentShader)).build());
+            pipelines[info.id] = builder.build(vkDevice);
+            break;
+        }
+        case capture::Op::BeginPass: {
+            auto info = read<capture::BeginPass>(record);
+            const Target& target = targets.at(info.target);
+            VkClearValue clear{};
+            std::memcpy(clear.color.float32, info.clearColor, sizeof(info.clearColor));
+            VkRenderPassBeginInfo passInfo{};
+            passInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            passInfo.renderPass = target.renderPass;
+            passInfo.framebuffer = target.framebuffer;
+            passInfo.renderArea = {{0, 0}, {target.width, target.height}};
+            passInfo.clearValueCount = 1;
+            passInfo.pClearValues = &clear;
+            vkCmdBeginRenderPass(recording, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+            break;
+        }
+        case capture::Op::EndPass:
+            vkCmdEndRenderPass(recording);
+            break;
+        case capture::Op::BindPipeline:
+            vkCmdBindPipeline(recording, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              pipelines.at(read<capture::BindPipeline>(record).id));
+            break;
+        case capture::Op::BindVertexBuffer: {
+            auto info = read<capture::BindVertexBuffer>(record);
+            VkBuffer buffer = buffers.at(info.buffer).buffer;
+            VkDeviceSize offset = info.offset;
+            vkCmdBindVertexBuffers(recording, info.binding, 1, &buffer, &offset);
+            break;
+        }
+        case capture::Op::BindIndexBuffer: {
+            auto info = read<capture::BindIndexBuffer>(record);
+            vkCmdBindIndexBuffer(recording, buffers.at(info.buffer).buffer, info.offset,
+                                 static_cast<VkIndexType>(info.indexType));
+            break;
+        }
+        case capture::Op::PushConstants: {
+            auto info = read<capture::PushConstants>(record);
+            // the layout's single range covers every stage, and pushes must name exactly its stages
+            vkCmdPushConstants(recording, pipelineLayout, VK_SHADER_STAGE_ALL, info.offset,
+                               static_cast<uint32_t>(record.size - sizeof(info)), record.payload + sizeof(info));
+            break;
+        }
+        case capture::Op::Draw: {
+            auto info = read<capture::Draw>(record);
+            vkCmdDraw(recording, info.vertexCount, info.instanceCount, info.firstVertex, info.firstInstance);
+            break;
+        }
+        case capture::Op::DrawIndexed: {
+            auto info = read<capture::DrawIndexed>(record);
+            vkCmdDrawIndexed(recording, info.indexCount, info.instanceCount, info.firstIndex, info.vertexOffset,
+                             info.firstInstance);
+            break;
+        }
+        case capture::Op::BeginFrame:
+        case capture::Op::EndFrame:
+            break;
+        default:
+            throw std::runtime_error("unknown capture record");
+    }
+}
+
+std::vector<double> CaptureReplayer::replayFrames() {
+    using Clock = std::chrono::steady_clock;
+    VkDevice vkDevice = device.device();
+    std::vector<double> frameTimes;
+    frameTimes.reserve(frames.size());
+
+    for (const std::vector<Record>& frame: frames) {
+        auto start = Clock::now();
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        for (const Record& record: frame) {
+            execute(record, commandBuffer);
+        }
+        vkEndCommandBuffer(commandBuffer);
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &commandBuffer;
+        {
+            std::lock_guard lock(device.queueMutex(device.graphicsQueue()));
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit replayed frame!");
+            }
+        }
+        vkWaitForFences(vkDevice, 1, &fence, VK_TRUE, UINT64_MAX);
+        vkResetFences(vkDevice, 1, &fence);
+        vkResetCommandBuffer(commandBuffer, 0);
+
+        frameTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    return frameTimes;
+}
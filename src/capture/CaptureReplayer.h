@@ -0,0 +1,78 @@
+#ifndef CAPTURE_REPLAYER_H
+#define CAPTURE_REPLAYER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "CaptureFormat.h"
+
+class Device;
+
+// Loads a capture written by CaptureRecorder and re-executes it on `device`
+// (normally headless). Everything before the first frame, and every shader
+// module, render target and pipeline wherever it was recorded, is created once
+// at load; replayFrames() then runs the frames back to back with no pacing,
+// submitting and waiting per frame.
+class CaptureReplayer {
+public:
+    CaptureReplayer(Device& device, const std::string& path);
+    ~CaptureReplayer();
+
+    CaptureReplayer(const CaptureReplayer&) = delete;
+    CaptureReplayer& operator=(const CaptureReplayer&) = delete;
+
+    // Milliseconds per frame, from the start of recording to fence completion.
+    std::vector<double> replayFrames();
+
+    [[nodiscard]] size_t frameCount() const { return frames.size(); }
+
+private:
+    struct Record {
+        capture::Op op;
+        const std::byte* payload;
+        uint32_t size;
+    };
+
+    struct Buffer {
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+    };
+
+    struct Target {
+        uint32_t width;
+        uint32_t height;
+        VkRenderPass renderPass;
+        VkImage image;
+        VkDeviceMemory memory;
+        VkImageView view;
+        VkFramebuffer framebuffer;
+    };
+
+    Device& device;
+    std::vector<char> file;
+    std::vector<Record> setup;
+    std::vector<std::vector<Record>> frames;
+
+    std::unordered_map<uint32_t, Buffer> buffers;
+    std::unordered_map<uint32_t, VkShaderModule> shaderModules;
+    std::unordered_map<uint32_t, Target> targets;
+    std::unordered_map<uint32_t, VkPipeline> pipelines;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    void parse();
+    // `recording` is null outside a frame
+    void execute(const Record& record, VkCommandBuffer recording);
+    void createTarget(const capture::CreateRenderTarget& info);
+    void destroyBuffer(uint32_t id);
+
+    template<typename Payload>
+    static Payload read(const Record& record);
+};
+
+#endif //CAPTURE_REPLAYER_H
@@ -0,0 +1,244 @@
+#include "AsyncCompute.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../device.h"
+
+AsyncCompute::AsyncCompute(Device& device) : device(device) {
+    QueueFamilyIndices indices = device.findPhysicalQueueFamilies();
+    computeFamily = indices.computeFamily;
+    graphicsFamily = indices.graphicsFamily;
+    queue = device.computeQueue();
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = computeFamily;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute command pool!");
+    }
+
+    computeTimeline = createTimeline();
+    graphicsTimeline = createTimeline();
+}
+
+AsyncCompute::~AsyncCompute() {
+    // Graphics batches that acquired our results wait on computeTimeline and
+    // signal graphicsTimeline; both must be idle before the semaphores go.
+    VkSemaphore semaphores[] = {computeTimeline, graphicsTimeline};
+    uint64_t values[] = {nextValue - 1, lastGraphicsValue};
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 2;
+    waitInfo.pSemaphores = semaphores;
+    waitInfo.pValues = values;
+    vkWaitSemaphores(device.device(), &waitInfo, UINT64_MAX);
+
+    // anything still keyed to our timelines would otherwise be polled after they are gone
+    device.deletionQueue().flush(computeTimeline);
+    device.deletionQueue().flush(graphicsTimeline);
+    vkDestroyCommandPool(device.device(), commandPool, nullptr);
+    vkDestroySemaphore(device.device(), computeTimeline, nullptr);
+    vkDestroySemaphore(device.device(), graphicsTimeline, nullptr);
+}
+
+VkSemaphore AsyncCompute::createTimeline() {
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    VkSemaphore semaphore;
+    if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+    return semaphore;
+}
+
+void AsyncCompute::recordTransfers(VkCommandBuffer commandBuffer, std::span<const QueueTransfer> transfers,
+                                   bool toCompute, bool release) {
+    std::vector<VkBufferMemoryBarrier2> bufferBarriers;
+    std::vector<VkImageMemoryBarrier2> imageBarriers;
+
+    for (const QueueTransfer& transfer: transfers) {
+        VkPipelineStageFlags2 srcStages = toCompute ? transfer.graphicsStages : transfer.computeStages;
+        VkAccessFlags2 srcAccess = toCompute ? transfer.graphicsAccess : transfer.computeAccess;
+        VkPipelineStageFlags2 dstStages = toCompute ? transfer.computeStages : transfer.graphicsStages;
+        VkAccessFlags2 dstAccess = toCompute ? transfer.computeAccess : transfer.graphicsAccess;
+        VkImageLayout oldLayout = toCompute ? transfer.graphicsLayout : transfer.computeLayout;
+        VkImageLayout newLayout = toCompute ? transfer.computeLayout : transfer.graphicsLayout;
+
+        // Without a dedicated family there is no ownership to move; the semaphore
+        // already orders the queues, so only a layout change needs a barrier.
+        if (!dedicated() && (release || transfer.buffer != VK_NULL_HANDLE || oldLayout == newLayout)) {
+            continue;
+        }
+
+        // The release half only makes writes available; the acquire half waits on
+        // the stages the semaphore was waited at, which are its own dst stages.
+        VkPipelineStageFlags2 barrierSrcStages = release ? srcStages : dstStages;
+        VkAccessFlags2 barrierSrcAccess = release ? srcAccess : VK_ACCESS_2_NONE;
+        VkPipelineStageFlags2 barrierDstStages = release ? VK_PIPELINE_STAGE_2_NONE : dstStages;
+        VkAccessFlags2 barrierDstAccess = release ? VK_ACCESS_2_NONE : dstAccess;
+        uint32_t srcFamily = dedicated() ? (toCompute ? graphicsFamily : computeFamily) : VK_QUEUE_FAMILY_IGNORED;
+        uint32_t dstFamily = dedicated() ? (toCompute ? computeFamily : graphicsFamily) : VK_QUEUE_FAMILY_IGNORED;
+
+        if (transfer.buffer != VK_NULL_HANDLE) {
+            VkBufferMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+            barrier.srcStageMask = barrierSrcStages;
+            barrier.srcAccessMask = barrierSrcAccess;
+            barrier.dstStageMask = barrierDstStages;
+            barrier.dstAccessMask = barrierDstAccess;
+            barrier.srcQueueFamilyIndex = srcFamily;
+            barrier.dstQueueFamilyIndex = dstFamily;
+            barrier.buffer = transfer.buffer;
+            barrier.offset = transfer.offset;
+            barrier.size = transfer.size;
+            bufferBarriers.push_back(barrier);
+        } else {
+            VkImageMemoryBarrier2 barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            barrier.srcStageMask = barrierSrcStages;
+            barrier.srcAccessMask = barrierSrcAccess;
+            barrier.dstStageMask = barrierDstStages;
+            barrier.dstAccessMask = barrierDstAccess;
+            barrier.oldLayout = oldLayout;
+            barrier.newLayout = newLayout;
+            barrier.srcQueueFamilyIndex = srcFamily;
+            barrier.dstQueueFamilyIndex = dstFamily;
+            barrier.image = transfer.image;
+            barrier.subresourceRange = transfer.range;
+            imageBarriers.push_back(barrier);
+        }
+    }
+
+    if (bufferBarriers.empty() && imageBarriers.empty()) {
+        return;
+    }
+    VkDependencyInfo dependencyInfo{};
+    dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+    dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+    vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+}
+
+uint64_t AsyncCompute::submit(const ComputeJob& job) {
+    VkCommandBuffer commandBuffer;
+    if (!freeCommandBuffers.empty()) {
+        commandBuffer = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate compute command buffer!");
+        }
+    }
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    recordTransfers(commandBuffer, job.fromGraphics, true, false);
+    job.record(commandBuffer);
+    recordTransfers(commandBuffer, job.toGraphics, false, true);
+
+    vkEndCommandBuffer(commandBuffer);
+
+    uint64_t value = nextValue++;
+
+    VkCommandBufferSubmitInfo commandInfo{};
+    commandInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+    commandInfo.commandBuffer = commandBuffer;
+
+    VkSemaphoreSubmitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    waitInfo.semaphore = graphicsTimeline;
+    waitInfo.value = job.waitGraphicsValue;
+    waitInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkSemaphoreSubmitInfo signalInfo{};
+    signalInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    signalInfo.semaphore = computeTimeline;
+    signalInfo.value = value;
+    signalInfo.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+
+    VkSubmitInfo2 submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+    submitInfo.waitSemaphoreInfoCount = job.waitGraphicsValue > 0 ? 1 : 0;
+    submitInfo.pWaitSemaphoreInfos = &waitInfo;
+    submitInfo.commandBufferInfoCount = 1;
+    submitInfo.pCommandBufferInfos = &commandInfo;
+    submitInfo.signalSemaphoreInfoCount = 1;
+    submitInfo.pSignalSemaphoreInfos = &signalInfo;
+
+    {
+        std::lock_guard lock(device.queueMutex(queue));
+        if (vkQueueSubmit2(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit compute work!");
+        }
+    }
+
+    inFlight.push_back({value, commandBuffer});
+    if (!job.toGraphics.empty()) {
+        pendingAcquires.push_back({value, job.toGraphics});
+    }
+    return value;
+}
+
+void AsyncCompute::releaseToCompute(VkCommandBuffer graphicsCommands, std::span<const QueueTransfer> transfers) {
+    recordTransfers(graphicsCommands, transfers, true, true);
+}
+
+void AsyncCompute::acquireFromCompute(VkCommandBuffer graphicsCommands, uint64_t computeValue) {
+    while (!pendingAcquires.empty() && pendingAcquires.front().value <= computeValue) {
+        recordTransfers(graphicsCommands, pendingAcquires.front().toGraphics, false, false);
+        pendingAcquires.pop_front();
+    }
+}
+
+VkSemaphoreSubmitInfo AsyncCompute::waitForCompute(uint64_t computeValue, VkPipelineStageFlags2 stages) const {
+    VkSemaphoreSubmitInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    info.semaphore = computeTimeline;
+    info.value = computeValue;
+    info.stageMask = stages;
+    return info;
+}
+
+VkSemaphoreSubmitInfo AsyncCompute::signalGraphics(uint64_t graphicsValue) {
+    lastGraphicsValue = std::max(lastGraphicsValue, graphicsValue);
+    VkSemaphoreSubmitInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+    info.semaphore = graphicsTimeline;
+    info.value = graphicsValue;
+    info.stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    return info;
+}
+
+uint64_t AsyncCompute::completedValue() const {
+    uint64_t value = 0;
+    vkGetSemaphoreCounterValue(device.device(), computeTimeline, &value);
+    return value;
+}
+
+void AsyncCompute::collect() {
+    uint64_t completed = completedValue();
+    while (!inFlight.empty() && inFlight.front().value <= completed) {
+        vkResetCommandBuffer(inFlight.front().commandBuffer, 0);
+        freeCommandBuffers.push_back(inFlight.front().commandBuffer);
+        inFlight.pop_front();
+    }
+}
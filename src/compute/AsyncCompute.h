@@ -0,0 +1,117 @@
+#ifndef ASYNC_COMPUTE_H
+#define ASYNC_COMPUTE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+class Device;
+
+// A buffer range or image handed between the compute and graphics queues.
+// Set either `buffer` or `image`. The stage/access pairs describe how each
+// side uses the resource; they become the release and acquire halves of the
+// queue family ownership transfer.
+struct QueueTransfer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = VK_WHOLE_SIZE;
+
+    VkImage image = VK_NULL_HANDLE;
+    VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    VkImageLayout computeLayout = VK_IMAGE_LAYOUT_GENERAL;
+    VkImageLayout graphicsLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkPipelineStageFlags2 computeStages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+    VkAccessFlags2 computeAccess = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+    VkPipelineStageFlags2 graphicsStages = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT;
+    VkAccessFlags2 graphicsAccess = VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+};
+
+struct ComputeJob {
+    std::function<void(VkCommandBuffer)> record;
+    // Produced by graphics, consumed here. Graphics must have recorded
+    // releaseToCompute() for these and signaled waitGraphicsValue.
+    std::vector<QueueTransfer> fromGraphics;
+    // Produced here, consumed by graphics after acquireFromCompute().
+    std::vector<QueueTransfer> toGraphics;
+    // graphics timeline value to wait for before the job starts; 0 for none
+    uint64_t waitGraphicsValue = 0;
+};
+
+// Runs compute work on the device's compute queue and keeps it in step with
+// graphics through two timeline semaphores, one per queue. On devices without
+// a dedicated compute family the same code path runs on a second graphics
+// queue and the ownership transfers collapse into plain layout transitions.
+//
+// To overlap with shadow and depth-only passes, submit those in their own
+// graphics batch with no compute wait, then wait for the compute value only in
+// the batch that consumes the results:
+//
+//     uint64_t culled = compute.submit(cullingJob);
+//     submit(shadowAndDepthPasses);                   // runs alongside culling
+//     compute.acquireFromCompute(mainCmd, culled);
+//     submit(mainCmd, wait = compute.waitForCompute(culled, VERTEX_SHADER | DRAW_INDIRECT),
+//            signal = compute.signalGraphics(frameValue));
+class AsyncCompute {
+public:
+    explicit AsyncCompute(Device& device);
+    ~AsyncCompute();
+
+    AsyncCompute(const AsyncCompute&) = delete;
+    AsyncCompute& operator=(const AsyncCompute&) = delete;
+
+    // Records and submits `job`; returns the compute timeline value it signals.
+    uint64_t submit(const ComputeJob& job);
+
+    // Graphics side of the handoffs: record into the graphics command buffer
+    // that writes (release) or first reads (acquire) the resources.
+    void releaseToCompute(VkCommandBuffer graphicsCommands, std::span<const QueueTransfer> transfers);
+    void acquireFromCompute(VkCommandBuffer graphicsCommands, uint64_t computeValue);
+
+    // Semaphore infos for the graphics vkQueueSubmit2 call. The destructor waits
+    // for the highest value handed out by signalGraphics, so submit every one.
+    [[nodiscard]] VkSemaphoreSubmitInfo waitForCompute(uint64_t computeValue, VkPipelineStageFlags2 stages) const;
+    [[nodiscard]] VkSemaphoreSubmitInfo signalGraphics(uint64_t graphicsValue);
+
+    // Recycles command buffers of finished jobs, acquired or not; call once per frame.
+    void collect();
+
+    [[nodiscard]] bool dedicated() const { return computeFamily != graphicsFamily; }
+    [[nodiscard]] uint64_t completedValue() const;
+
+private:
+    struct InFlight {
+        uint64_t value;
+        VkCommandBuffer commandBuffer;
+    };
+
+    // Handoffs graphics has yet to acquire; independent of the command buffer,
+    // which can be recycled as soon as the compute side has finished.
+    struct PendingAcquire {
+        uint64_t value;
+        std::vector<QueueTransfer> toGraphics;
+    };
+
+    Device& device;
+    VkQueue queue;
+    uint32_t computeFamily;
+    uint32_t graphicsFamily;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkSemaphore computeTimeline = VK_NULL_HANDLE;
+    VkSemaphore graphicsTimeline = VK_NULL_HANDLE;
+    uint64_t nextValue = 1;
+    uint64_t lastGraphicsValue = 0;
+
+    std::deque<InFlight> inFlight;
+    std::deque<PendingAcquire> pendingAcquires;
+    std::vector<VkCommandBuffer> freeCommandBuffers;
+
+    VkSemaphore createTimeline();
+    void recordTransfers(VkCommandBuffer commandBuffer, std::span<const QueueTransfer> transfers,
+                         bool toCompute, bool release);
+};
+
+#endif //ASYNC_COMPUTE_H
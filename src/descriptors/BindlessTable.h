@@ -0,0 +1,61 @@
+#ifndef BINDLESS_TABLE_H
+#define BINDLESS_TABLE_H
+
+#include <vulkan/vulkan.h>
+
+#include "IndexFreeList.h"
+
+class Device;
+
+// One update-after-bind descriptor set holding every sampled texture and storage
+// buffer the renderer knows about. Resources are addressed by the stable index
+// returned from add*(), so draws only push an integer instead of binding sets.
+// The set and the push-constant range live in pipelineLayout(), which is the
+// layout every PipelineBuilder should be given.
+class BindlessTable {
+public:
+    static constexpr uint32_t textureBinding = 0;
+    static constexpr uint32_t bufferBinding = 1;
+    static constexpr uint32_t pushConstantSize = 128;
+
+    BindlessTable(Device& device, uint32_t maxTextures, uint32_t maxBuffers);
+    ~BindlessTable();
+
+    BindlessTable(const BindlessTable&) = delete;
+    BindlessTable& operator=(const BindlessTable&) = delete;
+
+    [[nodiscard]] uint32_t addTexture(VkImageView view, VkSampler sampler,
+                                      VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void updateTexture(uint32_t index, VkImageView view, VkSampler sampler,
+                       VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    [[nodiscard]] uint32_t addBuffer(VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+    void updateBuffer(uint32_t index, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize range = VK_WHOLE_SIZE);
+
+    // The slot becomes reusable immediately; callers must not release an index
+    // that is still referenced by work in flight.
+    void removeTexture(uint32_t index);
+    void removeBuffer(uint32_t index);
+
+    void bind(VkCommandBuffer commandBuffer, VkPipelineBindPoint bindPoint) const;
+
+    [[nodiscard]] VkDescriptorSetLayout setLayout() const { return descriptorSetLayout; }
+    [[nodiscard]] VkPipelineLayout pipelineLayout() const { return sharedLayout; }
+    [[nodiscard]] VkDescriptorSet descriptorSet() const { return set; }
+
+private:
+    Device& device;
+    IndexFreeList textureSlots;
+    IndexFreeList bufferSlots;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkPipelineLayout sharedLayout = VK_NULL_HANDLE;
+
+    void createSetLayout();
+    void createPool();
+    void allocateSet();
+    void createPipelineLayout();
+};
+
+#endif //BINDLESS_TABLE_H
@@ -0,0 +1,33 @@
+#include "IndexFreeList.h"
+
+#include <stdexcept>
+
+IndexFreeList::IndexFreeList(uint32_t capacity) : capacity_(capacity) {
+    freed.reserve(capacity);
+    live.resize(capacity);
+}
+
+uint32_t IndexFreeList::allocate() {
+    if (!freed.empty()) {
+        uint32_t index = freed.back();
+        freed.pop_back();
+        live[index] = true;
+        return index;
+    }
+    if (next == capacity_) {
+        throw std::runtime_error("bindless index space exhausted!");
+    }
+    live[next] = true;
+    return next++;
+}
+
+void IndexFreeList::release(uint32_t index) {
+    if (index >= next) {
+        throw std::runtime_error("released index was never allocated!");
+    }
+    if (!live[index]) {
+        throw std::runtime_error("released index is already free!");
+    }
+    live[index] = false;
+    freed.push_back(index);
+}
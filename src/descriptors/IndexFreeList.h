@@ -0,0 +1,27 @@
+#ifndef INDEX_FREE_LIST_H
+#define INDEX_FREE_LIST_H
+
+#include <cstdint>
+#include <vector>
+
+// Hands out stable slot indices in [0, capacity). Released slots are reused
+// before fresh ones so the live range of a bindless array stays compact.
+class IndexFreeList {
+public:
+    explicit IndexFreeList(uint32_t capacity);
+
+    [[nodiscard]] uint32_t allocate();
+    void release(uint32_t index);
+
+    [[nodiscard]] uint32_t capacity() const { return capacity_; }
+    [[nodiscard]] uint32_t liveCount() const { return next - static_cast<uint32_t>(freed.size()); }
+
+private:
+    uint32_t capacity_;
+    uint32_t next = 0;
+    std::vector<uint32_t> freed;
+    // catches double releases, which would hand the same slot to two owners
+    std::vector<bool> live;
+};
+
+#endif //INDEX_FREE_LIST_H
@@ -1,21 +1,20 @@
 #include "device.h"
 
+#include "log/Log.h"
+#include "startup/StartupTimeline.h"
+
 // std headers
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory_resource>
 #include <set>
+#include <string>
+#include <string_view>
 #include <unordered_set>
 
-static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(
-    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
-    VkDebugUtilsMessageTypeFlagsEXT messageType,
-    const VkDebugUtilsMessengerCallbackDataEXT *pCallbackData,
-    void *pUserData) {
-    std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
-
-    return VK_FALSE;
-}
-
 VkResult CreateDebugUtilsMessengerEXT(
     VkInstance instance,
     const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo,
@@ -43,17 +42,64 @@ void DestroyDebugUtilsMessengerEXT(
     }
 }
 
+DeviceOptions DeviceOptions::fromCommandLine(int argc, char **argv) {
+    DeviceOptions options;
+    if (const char *env = std::getenv("VULCAN_DEVICE")) {
+        options.preferredDevice = env;
+    }
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--device=", 9) == 0) {
+            options.preferredDevice = argv[i] + 9;
+        }
+    }
+    return options;
+}
+
+static bool containsIgnoreCase(std::string_view text, std::string_view pattern) {
+    auto it = std::search(text.begin(), text.end(), pattern.begin(), pattern.end(), [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    });
+    return it != text.end();
+}
+
 // class member functions
-Device::Device(Window &window) : window{window} {
-    createInstance();
-    setupDebugMessenger();
-    createSurface();
-    pickPhysicalDevice();
-    createLogicalDevice();
-    createCommandPool();
+Device::Device(Window &window, DeviceOptions options) : Device(&window, std::move(options)) {
+}
+
+Device::Device(DeviceOptions options) : Device(nullptr, std::move(options)) {
+}
+
+Device::Device(Window *window, DeviceOptions options) : window{window}, options(std::move(options)) {
+    if (headless()) {
+        deviceExtensions.clear();
+    }
+
+    // each step depends on the previous one; the caller overlaps file I/O with the whole chain
+    StartupTimeline *timeline = this->options.timeline;
+    {
+        auto scope = startupScope(timeline, "create instance");
+        createInstance();
+        setupDebugMessenger();
+    }
+    {
+        auto scope = startupScope(timeline, "create surface");
+        createSurface();
+    }
+    {
+        auto scope = startupScope(timeline, "pick physical device");
+        pickPhysicalDevice();
+    }
+    {
+        auto scope = startupScope(timeline, "create logical device");
+        createLogicalDevice();
+        createCommandPool();
+    }
 }
 
 Device::~Device() {
+    vkDeviceWaitIdle(device_);
+    deletionQueue_.flush();
+
     vkDestroyCommandPool(device_, commandPool, nullptr);
     vkDestroyDevice(device_, nullptr);
 
@@ -76,7 +122,7 @@ void Device::createInstance() {
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_3;
 
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -111,53 +157,131 @@ void Device::pickPhysicalDevice() {
     if (deviceCount == 0) {
         throw std::runtime_error("failed to find GPUs with Vulkan support!");
     }
-    std::cout << "Device count: " << deviceCount << std::endl;
+    bool verbose = logging::enabled(LogLevel::Verbose);
+    if (verbose) {
+        std::cout << "Device count: " << deviceCount << '\n';
+    }
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
 
-    for (const auto &device: devices) {
-        if (isDeviceSuitable(device)) {
-            physicalDevice = device;
-            break;
+    uint64_t bestScore = 0;
+    for (uint32_t i = 0; i < deviceCount; i++) {
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(devices[i], &deviceProperties);
+        uint64_t score = scorePhysicalDevice(devices[i]);
+        if (verbose) {
+            std::cout << "  [" << i << "] " << deviceProperties.deviceName << " score " << score << '\n';
+        }
+
+        if (!options.preferredDevice.empty()) {
+            bool matches = options.preferredDevice == std::to_string(i) ||
+                           containsIgnoreCase(deviceProperties.deviceName, options.preferredDevice);
+            if (matches && score > 0 && physicalDevice == VK_NULL_HANDLE) {
+                physicalDevice = devices[i];
+            }
+        } else if (score > bestScore) {
+            bestScore = score;
+            physicalDevice = devices[i];
         }
     }
 
+    if (physicalDevice == VK_NULL_HANDLE && !options.preferredDevice.empty()) {
+        throw std::runtime_error("no suitable GPU matches device override '" + options.preferredDevice + "'");
+    }
     if (physicalDevice == VK_NULL_HANDLE) {
         throw std::runtime_error("failed to find a suitable GPU!");
     }
 
     vkGetPhysicalDeviceProperties(physicalDevice, &properties);
-    std::cout << "physical device: " << properties.deviceName << std::endl;
+
+    descriptorIndexingProperties = {};
+    descriptorIndexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &descriptorIndexingProperties;
+    vkGetPhysicalDeviceProperties2(physicalDevice, &properties2);
+
+    if (logging::enabled(LogLevel::Info)) {
+        std::cout << "physical device: " << properties.deviceName << '\n';
+    }
 }
 
 void Device::createLogicalDevice() {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
-    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    std::set<uint32_t> uniqueQueueFamilies = {
+        indices.graphicsFamily, indices.presentFamily, indices.computeFamily, indices.transferFamily
+    };
 
-    float queuePriority = 1.0f;
+    // every family gets as many queues as it offers, up to the configured cap
+    std::vector<uint32_t> familyQueueCounts(queueFamilyCount, 0);
+    std::vector<float> queuePriorities(std::max(options.maxQueuesPerFamily, 1u), 1.0f);
+    std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     for (uint32_t queueFamily: uniqueQueueFamilies) {
+        familyQueueCounts[queueFamily] = std::clamp(queueFamilies[queueFamily].queueCount, 1u,
+                                                    static_cast<uint32_t>(queuePriorities.size()));
         VkDeviceQueueCreateInfo queueCreateInfo = {};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = queueFamily;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfo.queueCount = familyQueueCounts[queueFamily];
+        queueCreateInfo.pQueuePriorities = queuePriorities.data();
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    VkPhysicalDeviceFeatures deviceFeatures = {};
-    deviceFeatures.samplerAnisotropy = VK_TRUE;
+    // descriptor indexing backs the bindless resource table
+    VkPhysicalDeviceVulkan12Features features12 = {};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.descriptorIndexing = VK_TRUE;
+    features12.runtimeDescriptorArray = VK_TRUE;
+    features12.descriptorBindingPartiallyBound = VK_TRUE;
+    features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    features12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
+
+    // async compute and graphics are kept in step with timeline semaphores
+    features12.timelineSemaphore = VK_TRUE;
+
+    // the render graph records all of its barriers through vkCmdPipelineBarrier2
+    VkPhysicalDeviceVulkan13Features features13 = {};
+    features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    features13.synchronization2 = VK_TRUE;
+    features12.pNext = &features13;
+
+    VkPhysicalDeviceFeatures2 deviceFeatures = {};
+    deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    deviceFeatures.pNext = &features12;
+    deviceFeatures.features.samplerAnisotropy = VK_TRUE;
 
     VkDeviceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &deviceFeatures;
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-    createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    createInfo.pEnabledFeatures = nullptr;
+
+    std::vector<const char *> enabledExtensions = deviceExtensions;
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+    for (const auto &extension: availableExtensions) {
+        if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            memoryBudgetEnabled = true;
+        }
+    }
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     // might not really be necessary anymore because device specific validation layers
     // have been deprecated
@@ -174,6 +298,65 @@ void Device::createLogicalDevice() {
 
     vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+    // Graphics and present use queue 0 of their families. The other queues of a
+    // family are split between the roles on it, compute first; a role that
+    // finds none left reuses the family's last queue.
+    std::vector<uint32_t> nextQueue(queueFamilyCount, 0);
+    nextQueue[indices.graphicsFamily] = 1;
+    nextQueue[indices.presentFamily] = 1;
+    const std::pair<QueueType, uint32_t> roles[] = {
+        {QueueType::Compute, indices.computeFamily},
+        {QueueType::Transfer, indices.transferFamily},
+    };
+    for (size_t role = 0; role < std::size(roles); role++) {
+        auto [type, family] = roles[role];
+        auto rolesLeft = static_cast<uint32_t>(std::count_if(
+            roles + role, std::end(roles), [family](const auto& other) { return other.second == family; }));
+        uint32_t available = familyQueueCounts[family] - std::min(nextQueue[family], familyQueueCounts[family]);
+        uint32_t first = available > 0 ? nextQueue[family] : familyQueueCounts[family] - 1;
+        uint32_t count = available > 0 ? (available + rolesLeft - 1) / rolesLeft : 1;
+        for (uint32_t i = first; i < first + count; i++) {
+            VkQueue queue;
+            vkGetDeviceQueue(device_, family, i, &queue);
+            queues[static_cast<uint32_t>(type)].push_back(queue);
+        }
+        nextQueue[family] = first + count;
+    }
+    queues[static_cast<uint32_t>(QueueType::Graphics)] = {graphicsQueue_};
+    queues[static_cast<uint32_t>(QueueType::Present)] = {presentQueue_};
+
+    for (const std::vector<VkQueue>& roleQueues: queues) {
+        for (VkQueue queue: roleQueues) {
+            bool known = std::any_of(queueMutexes.begin(), queueMutexes.end(),
+                                     [queue](const auto& entry) { return entry.first == queue; });
+            if (!known) {
+                queueMutexes.emplace_back(queue, std::make_unique<std::mutex>());
+            }
+        }
+    }
+
+    if (logging::enabled(LogLevel::Verbose)) {
+        auto describe = [&](QueueType type, bool dedicated) {
+            const std::vector<VkQueue>& roleQueues = queues[static_cast<uint32_t>(type)];
+            bool shared = false;
+            for (uint32_t other = 0; other < queueTypeCount; other++) {
+                if (other == static_cast<uint32_t>(type) || static_cast<QueueType>(other) == QueueType::Present) {
+                    continue;
+                }
+                for (VkQueue queue: queues[other]) {
+                    shared = shared || std::find(roleQueues.begin(), roleQueues.end(), queue) != roleQueues.end();
+                }
+            }
+            return std::string(dedicated ? " (dedicated)" : "") + (shared ? " (shared)" : "") + " x" +
+                   std::to_string(roleQueues.size());
+        };
+        std::cout << "queues: graphics family " << indices.graphicsFamily
+                  << ", compute family " << indices.computeFamily
+                  << describe(QueueType::Compute, indices.dedicatedCompute)
+                  << ", transfer family " << indices.transferFamily
+                  << describe(QueueType::Transfer, indices.dedicatedTransfer) << '\n';
+    }
 }
 
 void Device::createCommandPool() {
@@ -190,15 +373,19 @@ void Device::createCommandPool() {
     }
 }
 
-void Device::createSurface() { window.createWindowSurface(instance, &surface_); }
+void Device::createSurface() {
+    if (!headless()) {
+        window->createWindowSurface(instance, &surface_);
+    }
+}
 
 bool Device::isDeviceSuitable(VkPhysicalDevice device) {
     QueueFamilyIndices indices = findQueueFamilies(device);
 
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
+    bool swapChainAdequate = headless();
+    if (extensionsSupported && !headless()) {
         SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
@@ -207,7 +394,35 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device) {
     vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
     return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-           supportedFeatures.samplerAnisotropy;
+           supportedFeatures.samplerAnisotropy && checkRequiredFeatureSupport(device);
+}
+
+bool Device::checkRequiredFeatureSupport(VkPhysicalDevice device) {
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(device, &deviceProperties);
+    if (deviceProperties.apiVersion < VK_API_VERSION_1_3) {
+        return false;
+    }
+
+    VkPhysicalDeviceVulkan13Features features13{};
+    features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.pNext = &features13;
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(device, &features2);
+
+    return features12.descriptorIndexing && features12.runtimeDescriptorArray &&
+           features12.descriptorBindingPartiallyBound &&
+           features12.descriptorBindingSampledImageUpdateAfterBind &&
+           features12.descriptorBindingStorageBufferUpdateAfterBind &&
+           features12.descriptorBindingUpdateUnusedWhilePending &&
+           features12.shaderSampledImageArrayNonUniformIndexing &&
+           features12.shaderStorageBufferArrayNonUniformIndexing &&
+           features12.timelineSemaphore &&
+           features13.synchronization2;
 }
 
 void Device::populateDebugMessengerCreateInfo(
@@ -219,8 +434,8 @@ void Device::populateDebugMessengerCreateInfo(
     createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT |
                              VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT |
                              VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
-    createInfo.pfnUserCallback = debugCallback;
-    createInfo.pUserData = nullptr; // Optional
+    createInfo.pfnUserCallback = ValidationLog::callback;
+    createInfo.pUserData = &validationLog_;
 }
 
 void Device::setupDebugMessenger() {
@@ -258,11 +473,13 @@ bool Device::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> Device::getRequiredExtensions() {
-    uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-    std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    std::vector<const char *> extensions;
+    if (!headless()) {
+        uint32_t glfwExtensionCount = 0;
+        const char **glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -272,22 +489,28 @@ std::vector<const char *> Device::getRequiredExtensions() {
 }
 
 void Device::hasGflwRequiredInstanceExtensions() {
+    // vkCreateInstance already fails on a missing extension; enumerating and
+    // printing them all is only worth its startup cost when asked for
+    if (!logging::enabled(LogLevel::Verbose)) {
+        return;
+    }
+
     uint32_t extensionCount = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
     std::vector<VkExtensionProperties> extensions(extensionCount);
     vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
 
-    std::cout << "available extensions:" << std::endl;
+    std::cout << "available extensions:\n";
     std::unordered_set<std::string> available;
     for (const auto &extension: extensions) {
-        std::cout << "\t" << extension.extensionName << std::endl;
+        std::cout << '\t' << extension.extensionName << '\n';
         available.insert(extension.extensionName);
     }
 
-    std::cout << "required extensions:" << std::endl;
+    std::cout << "required extensions:\n";
     auto requiredExtensions = getRequiredExtensions();
     for (const auto &required: requiredExtensions) {
-        std::cout << "\t" << required << std::endl;
+        std::cout << '\t' << required << '\n';
         if (available.find(required) == available.end()) {
             throw std::runtime_error("Missing required glfw extension");
         }
@@ -298,17 +521,26 @@ bool Device::checkDeviceExtensionSupport(VkPhysicalDevice device) {
     uint32_t extensionCount;
     vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
-    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    // scratch only lives for this call, so bump-allocate it all and drop it at once
+    std::pmr::monotonic_buffer_resource scratch(extensionCount * sizeof(VkExtensionProperties) + 1024);
+
+    std::pmr::vector<VkExtensionProperties> availableExtensions(extensionCount, &scratch);
     vkEnumerateDeviceExtensionProperties(
         device,
         nullptr,
         &extensionCount,
         availableExtensions.data());
 
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+    std::pmr::set<std::pmr::string, std::less<>> requiredExtensions(&scratch);
+    for (const char *extension: deviceExtensions) {
+        requiredExtensions.emplace(extension);
+    }
 
     for (const auto &extension: availableExtensions) {
-        requiredExtensions.erase(extension.extensionName);
+        auto required = requiredExtensions.find(std::string_view(extension.extensionName));
+        if (required != requiredExtensions.end()) {
+            requiredExtensions.erase(required);
+        }
     }
 
     return requiredExtensions.empty();
@@ -323,30 +555,110 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-    int i = 0;
-    for (const auto &queueFamily: queueFamilies) {
-        if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+    for (uint32_t i = 0; i < queueFamilyCount; i++) {
+        const VkQueueFamilyProperties &queueFamily = queueFamilies[i];
+        if (queueFamily.queueCount == 0) {
+            continue;
+        }
+
+        bool graphics = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT;
+        VkBool32 presentSupport = false;
+        if (headless()) {
+            // nothing is presented; let the graphics family stand in
+            presentSupport = graphics;
+        } else {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+        }
+
+        // prefer a single family that can both draw and present
+        bool upgradesGraphics = graphics && (!indices.graphicsFamilyHasValue ||
+                                             (presentSupport && indices.graphicsFamily != indices.presentFamily));
+        if (upgradesGraphics) {
             indices.graphicsFamily = i;
             indices.graphicsFamilyHasValue = true;
         }
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-        if (queueFamily.queueCount > 0 && presentSupport) {
+        if (presentSupport && (!indices.presentFamilyHasValue || upgradesGraphics)) {
             indices.presentFamily = i;
             indices.presentFamilyHasValue = true;
         }
-        if (indices.isComplete()) {
-            break;
+
+        if (!graphics && (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !indices.dedicatedCompute) {
+            indices.computeFamily = i;
+            indices.dedicatedCompute = true;
+        }
+        // a transfer-only family maps to the DMA engines; it wins over any other candidate
+        bool transferOnly = (queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0 &&
+                            (queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT);
+        if (transferOnly && !indices.dedicatedTransfer) {
+            indices.transferFamily = i;
+            indices.dedicatedTransfer = true;
         }
+    }
 
-        i++;
+    if (!indices.dedicatedCompute) {
+        indices.computeFamily = indices.graphicsFamily;
+    }
+    if (!indices.dedicatedTransfer) {
+        indices.transferFamily = indices.computeFamily;
     }
 
     return indices;
 }
 
-SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device) {
-    SwapChainSupportDetails details;
+uint64_t Device::scorePhysicalDevice(VkPhysicalDevice device) {
+    if (!isDeviceSuitable(device)) {
+        return 0;
+    }
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(device, &deviceProperties);
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+
+    // device type dominates; a software rasterizer only wins when it is the only option
+    uint64_t score = 1;
+    switch (deviceProperties.deviceType) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            score += 1'000'000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+            score += 500'000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            score += 250'000;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:
+            score += 1'000;
+            break;
+        default:
+            break;
+    }
+
+    // then the largest device-local heap, in MiB
+    VkDeviceSize largestHeap = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+        if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            largestHeap = std::max(largestHeap, memoryProperties.memoryHeaps[i].size);
+        }
+    }
+    score += std::min<VkDeviceSize>(largestHeap >> 20, 64 * 1024);
+
+    // limits that matter to the renderer, as tie-breakers
+    score += deviceProperties.limits.maxImageDimension2D / 1024;
+    score += std::min(deviceProperties.limits.maxPerStageDescriptorSampledImages, 1u << 20) / 4096;
+
+    QueueFamilyIndices indices = findQueueFamilies(device);
+    if (indices.dedicatedCompute) {
+        score += 100;
+    }
+    if (indices.dedicatedTransfer) {
+        score += 50;
+    }
+    return score;
+}
+
+SwapChainSupportDetails Device::querySwapChainSupport(VkPhysicalDevice device, std::pmr::memory_resource *memory) {
+    SwapChainSupportDetails details(memory);
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface_, &details.capabilities);
 
     uint32_t formatCount;
@@ -400,6 +712,74 @@ uint32_t Device::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags prope
     throw std::runtime_error("failed to find suitable memory type!");
 }
 
+bool Device::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) &&
+            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return true;
+        }
+    }
+    return false;
+}
+
+VkSampleCountFlagBits Device::maxUsableSampleCount(VkSampleCountFlagBits requested) {
+    VkSampleCountFlags counts = properties.limits.framebufferColorSampleCounts &
+                                properties.limits.framebufferDepthSampleCounts;
+    for (auto count = static_cast<uint32_t>(requested); count > VK_SAMPLE_COUNT_1_BIT; count >>= 1) {
+        if (counts & count) {
+            return static_cast<VkSampleCountFlagBits>(count);
+        }
+    }
+    return VK_SAMPLE_COUNT_1_BIT;
+}
+
+uint32_t Device::memoryHeapIndex(uint32_t memoryTypeIndex) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    return memProperties.memoryTypes[memoryTypeIndex].heapIndex;
+}
+
+std::vector<MemoryHeapBudget> Device::queryMemoryBudget() {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2 memProperties{};
+    memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memProperties.pNext = memoryBudgetEnabled ? &budgetProperties : nullptr;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &memProperties);
+
+    std::vector<MemoryHeapBudget> budgets(memProperties.memoryProperties.memoryHeapCount);
+    for (uint32_t i = 0; i < memProperties.memoryProperties.memoryHeapCount; i++) {
+        if (memoryBudgetEnabled) {
+            budgets[i] = {budgetProperties.heapBudget[i], budgetProperties.heapUsage[i]};
+        } else {
+            budgets[i] = {memProperties.memoryProperties.memoryHeaps[i].size, 0};
+        }
+    }
+    return budgets;
+}
+
+VkDeviceMemory Device::allocateMemory(
+    const VkMemoryRequirements &memRequirements, VkMemoryPropertyFlags properties) {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+
+    VkDeviceMemory memory;
+    VkResult result = vkAllocateMemory(device_, &allocInfo, nullptr, &memory);
+    while (result == VK_ERROR_OUT_OF_DEVICE_MEMORY && outOfMemoryHandler &&
+           outOfMemoryHandler(memoryHeapIndex(allocInfo.memoryTypeIndex), allocInfo.allocationSize)) {
+        result = vkAllocateMemory(device_, &allocInfo, nullptr, &memory);
+    }
+    if (result != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return memory;
+}
+
 void Device::createBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
@@ -419,12 +799,9 @@ void Device::createBuffer(
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
+    bufferMemory = allocateMemory(memRequirements, properties);
+    if (bufferMemory == VK_NULL_HANDLE) {
+        vkDestroyBuffer(device_, buffer, nullptr);
         throw std::runtime_error("failed to allocate vertex buffer memory!");
     }
 
@@ -457,12 +834,52 @@ void Device::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &commandBuffer;
 
-    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue_);
+    {
+        std::lock_guard lock(queueMutex(graphicsQueue_));
+        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
+        vkQueueWaitIdle(graphicsQueue_);
+    }
 
     vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
 
+VkFence Device::submitSingleTimeCommands(VkCommandBuffer commandBuffer) {
+    vkEndCommandBuffer(commandBuffer);
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    VkFence fence;
+    if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create fence!");
+    }
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+
+    std::lock_guard lock(queueMutex(graphicsQueue_));
+    if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit command buffer!");
+    }
+    return fence;
+}
+
+std::mutex& Device::queueMutex(VkQueue queue) {
+    for (auto& [known, mutex]: queueMutexes) {
+        if (known == queue) {
+            return *mutex;
+        }
+    }
+    throw std::invalid_argument("not a queue of this device");
+}
+
+void Device::releaseSingleTimeCommands(VkCommandBuffer commandBuffer, VkFence fence) {
+    vkDestroyFence(device_, fence, nullptr);
+    vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+}
+
 void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
@@ -475,6 +892,29 @@ void Device::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize siz
     endSingleTimeCommands(commandBuffer);
 }
 
+void Device::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size) {
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingMemory;
+    createBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                 stagingBuffer, stagingMemory);
+
+    void *mapped;
+    vkMapMemory(device_, stagingMemory, 0, size, 0, &mapped);
+    memcpy(mapped, data, static_cast<size_t>(size));
+    vkUnmapMemory(device_, stagingMemory);
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+    VkBufferCopy copyRegion{};
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size = size;
+    vkCmdCopyBuffer(commandBuffer, stagingBuffer, dstBuffer, 1, &copyRegion);
+    endSingleTimeCommands(commandBuffer);
+
+    vkDestroyBuffer(device_, stagingBuffer, nullptr);
+    vkFreeMemory(device_, stagingMemory, nullptr);
+}
+
 void Device::copyBufferToImage(
     VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
@@ -514,12 +954,9 @@ void Device::createImageWithInfo(
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+    imageMemory = allocateMemory(memRequirements, properties);
+    if (imageMemory == VK_NULL_HANDLE) {
+        vkDestroyImage(device_, image, nullptr);
         throw std::runtime_error("failed to allocate image memory!");
     }
 
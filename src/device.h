@@ -1,15 +1,30 @@
 #pragma once
 
 #include "Window.h"
+#include "log/ValidationLog.h"
+#include "memory/DeletionQueue.h"
+
+class StartupTimeline;
 
 // std lib headers
+#include <functional>
+#include <array>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <utility>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 struct SwapChainSupportDetails {
+    explicit SwapChainSupportDetails(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : capabilities{}, formats(memory), presentModes(memory) {
+    }
+
     VkSurfaceCapabilitiesKHR capabilities;
-    std::vector<VkSurfaceFormatKHR> formats;
-    std::vector<VkPresentModeKHR> presentModes;
+    std::pmr::vector<VkSurfaceFormatKHR> formats;
+    std::pmr::vector<VkPresentModeKHR> presentModes;
 };
 
 struct QueueFamilyIndices {
@@ -18,11 +33,47 @@ struct QueueFamilyIndices {
     bool graphicsFamilyHasValue = false;
     bool presentFamilyHasValue = false;
 
+    // Always valid once graphicsFamily is. computeFamily is a family without
+    // graphics when the device has one (dedicated), otherwise the graphics
+    // family; transferFamily is a transfer-only family (dedicated), otherwise
+    // the compute family.
+    uint32_t computeFamily{};
+    uint32_t transferFamily{};
+    bool dedicatedCompute = false;
+    bool dedicatedTransfer = false;
+
     [[nodiscard]] bool isComplete() const {
         return graphicsFamilyHasValue && presentFamilyHasValue;
     }
 };
 
+enum class QueueType : uint32_t {
+    Graphics,
+    Compute,
+    Transfer,
+    Present,
+};
+
+constexpr uint32_t queueTypeCount = 4;
+
+struct DeviceOptions {
+    // Index into vkEnumeratePhysicalDevices or a case-insensitive substring of the
+    // device name. Empty means the highest scoring device wins.
+    std::string preferredDevice;
+    // upper bound on queues created per family
+    uint32_t maxQueuesPerFamily = 4;
+    // receives a span per bring-up step when set
+    StartupTimeline* timeline = nullptr;
+
+    // Reads --device=<index|name>, falling back to the VULCAN_DEVICE environment variable.
+    static DeviceOptions fromCommandLine(int argc, char** argv);
+};
+
+struct MemoryHeapBudget {
+    VkDeviceSize budget;
+    VkDeviceSize usage;
+};
+
 class Device {
 public:
 #ifdef NDEBUG
@@ -31,7 +82,11 @@ public:
     const bool enableValidationLayers = true;
 #endif
 
-    explicit Device(Window& window);
+    explicit Device(Window& window, DeviceOptions options = {});
+
+    // Headless device: no surface, no swapchain extension, and the present
+    // queue aliases the graphics queue. Used by the benchmark and replay tools.
+    explicit Device(DeviceOptions options);
 
     ~Device();
 
@@ -44,6 +99,9 @@ public:
 
     Device& operator=(Device&&) = delete;
 
+    // The shared command pool is not synchronized: allocate, record and free its
+    // command buffers (including the single-time helpers below) on the thread
+    // that owns the Device. Other threads record into pools of their own.
     VkCommandPool getCommandPool() {
         return commandPool;
     }
@@ -56,6 +114,20 @@ public:
         return surface_;
     }
 
+    // Retires handles that in-flight frames may still reference; see DeletionQueue.
+    DeletionQueue& deletionQueue() {
+        return deletionQueue_;
+    }
+
+    // Severity/type counters and per-ID counts for everything the validation layers reported.
+    ValidationLog& validationLog() {
+        return validationLog_;
+    }
+
+    [[nodiscard]] bool headless() const {
+        return window == nullptr;
+    }
+
     VkQueue graphicsQueue() {
         return graphicsQueue_;
     }
@@ -64,12 +136,62 @@ public:
         return presentQueue_;
     }
 
-    SwapChainSupportDetails getSwapChainSupport() {
-        return querySwapChainSupport(physicalDevice);
+    // Queue `index` of the given role. Roles sharing a family split the queues
+    // graphics does not use; when there are fewer queues than roles, the
+    // remaining roles reuse the family's last queue, which may be the graphics
+    // queue. computeQueue() and transferQueue() are therefore always usable,
+    // but only queueMutex() makes submitting to them from several threads safe.
+    VkQueue queue(QueueType type, uint32_t index = 0) {
+        return queues[static_cast<uint32_t>(type)][index];
+    }
+
+    [[nodiscard]] uint32_t queueCount(QueueType type) const {
+        return static_cast<uint32_t>(queues[static_cast<uint32_t>(type)].size());
+    }
+
+    VkQueue computeQueue() {
+        return queue(QueueType::Compute);
+    }
+
+    VkQueue transferQueue() {
+        return queue(QueueType::Transfer);
+    }
+
+    // Held around every vkQueueSubmit*, vkQueueWaitIdle and vkQueuePresentKHR
+    // on `queue`, which Vulkan requires to be externally synchronized.
+    std::mutex& queueMutex(VkQueue queue);
+
+    // Pass a FrameArena when querying on the per-frame path (swapchain recreation).
+    SwapChainSupportDetails getSwapChainSupport(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+        return querySwapChainSupport(physicalDevice, memory);
     }
 
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 
+    bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+
+    uint32_t memoryHeapIndex(uint32_t memoryTypeIndex);
+
+    // Highest sample count usable for both color and depth attachments, capped at `requested`.
+    VkSampleCountFlagBits maxUsableSampleCount(VkSampleCountFlagBits requested = VK_SAMPLE_COUNT_64_BIT);
+
+    // Per-heap budget and usage from VK_EXT_memory_budget. Without the extension
+    // the budget is the heap size and usage is reported as zero.
+    std::vector<MemoryHeapBudget> queryMemoryBudget();
+
+    [[nodiscard]] bool hasMemoryBudget() const {
+        return memoryBudgetEnabled;
+    }
+
+    // Invoked when an allocation fails with VK_ERROR_OUT_OF_DEVICE_MEMORY. Returning
+    // true means memory was released and the allocation is retried.
+    void setOutOfMemoryHandler(std::function<bool(uint32_t heapIndex, VkDeviceSize size)> handler) {
+        outOfMemoryHandler = std::move(handler);
+    }
+
+    // Raw allocation used by createBuffer/createImageWithInfo; returns VK_NULL_HANDLE on failure.
+    VkDeviceMemory allocateMemory(const VkMemoryRequirements& memRequirements, VkMemoryPropertyFlags properties);
+
     QueueFamilyIndices findPhysicalQueueFamilies() {
         return findQueueFamilies(physicalDevice);
     }
@@ -89,8 +211,17 @@ public:
 
     void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
+    // Non-blocking variant of endSingleTimeCommands: the returned fence signals once the
+    // work retires, after which releaseSingleTimeCommands frees both.
+    VkFence submitSingleTimeCommands(VkCommandBuffer commandBuffer);
+
+    void releaseSingleTimeCommands(VkCommandBuffer commandBuffer, VkFence fence);
+
     void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 
+    // Writes `size` bytes at `dstOffset` through a temporary staging buffer; blocks until done.
+    void uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
     void copyBufferToImage(
         VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -101,8 +232,11 @@ public:
         VkDeviceMemory& imageMemory);
 
     VkPhysicalDeviceProperties properties;
+    VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties;
 
 private:
+    Device(Window* window, DeviceOptions options);
+
     void createInstance();
 
     void setupDebugMessenger();
@@ -118,6 +252,9 @@ private:
     // helper functions
     bool isDeviceSuitable(VkPhysicalDevice device);
 
+    // 0 for unsuitable devices, otherwise higher is better
+    uint64_t scorePhysicalDevice(VkPhysicalDevice device);
+
     std::vector<const char*> getRequiredExtensions();
 
     bool checkValidationLayerSupport();
@@ -130,19 +267,34 @@ private:
 
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
 
-    SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+    bool checkRequiredFeatureSupport(VkPhysicalDevice device);
+
+    SwapChainSupportDetails querySwapChainSupport(
+        VkPhysicalDevice device, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
 
+    // pUserData of the debug messenger, which ~Device destroys before this member goes
+    ValidationLog validationLog_;
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-    Window& window;
+    Window* window;
     VkCommandPool commandPool;
 
     VkDevice device_;
-    VkSurfaceKHR surface_;
+    VkSurfaceKHR surface_ = VK_NULL_HANDLE;
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
+    std::array<std::vector<VkQueue>, queueTypeCount> queues;
+    // one per distinct queue of any role
+    std::vector<std::pair<VkQueue, std::unique_ptr<std::mutex>>> queueMutexes;
+
+    DeviceOptions options;
+    DeletionQueue deletionQueue_{*this};
 
     const std::vector<const char*> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-    const std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    // emptied for headless devices
+    std::vector<const char*> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+
+    bool memoryBudgetEnabled = false;
+    std::function<bool(uint32_t heapIndex, VkDeviceSize size)> outOfMemoryHandler;
 };
@@ -0,0 +1,87 @@
+#include "DrawQueue.h"
+
+#include "../jobs/JobSystem.h"
+
+void DrawQueue::clear() {
+    packets.clear();
+    entries.clear();
+}
+
+void DrawQueue::reserve(size_t count) {
+    packets.reserve(count);
+    entries.reserve(count);
+}
+
+void DrawQueue::add(uint64_t key, const DrawPacket& packet) {
+    entries.push_back({key, static_cast<uint32_t>(packets.size())});
+    packets.push_back(packet);
+}
+
+void DrawQueue::sort(JobSystem* jobs) {
+    radixSort(entries, scratch, jobs);
+}
+
+void DrawQueue::record(VkCommandBuffer commandBuffer, VkPipelineLayout layout) {
+    stats_ = {};
+    stats_.draws = static_cast<uint32_t>(entries.size());
+
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkBuffer boundVertexBuffer = VK_NULL_HANDLE;
+    VkBuffer boundIndexBuffer = VK_NULL_HANDLE;
+    VkIndexType boundIndexType = VK_INDEX_TYPE_UINT32;
+    uint32_t pushed[2] = {};
+    // push constants are undefined until the first push and after a bind of
+    // a pipeline with an incompatible layout; every pipeline here shares `layout`
+    bool constantsValid = false;
+
+    for (const RadixSortEntry& entry: entries) {
+        const DrawPacket& draw = packets[entry.value];
+
+        if (draw.pipeline != boundPipeline) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, draw.pipeline);
+            boundPipeline = draw.pipeline;
+            stats_.pipelineBinds++;
+        } else {
+            stats_.pipelineBindsSaved++;
+        }
+
+        if (draw.vertexBuffer != VK_NULL_HANDLE) {
+            if (draw.vertexBuffer != boundVertexBuffer) {
+                VkDeviceSize offset = 0;
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &draw.vertexBuffer, &offset);
+                boundVertexBuffer = draw.vertexBuffer;
+                stats_.bufferBinds++;
+            } else {
+                stats_.bufferBindsSaved++;
+            }
+        }
+
+        if (draw.indexBuffer != VK_NULL_HANDLE) {
+            if (draw.indexBuffer != boundIndexBuffer || draw.indexType != boundIndexType) {
+                vkCmdBindIndexBuffer(commandBuffer, draw.indexBuffer, 0, draw.indexType);
+                boundIndexBuffer = draw.indexBuffer;
+                boundIndexType = draw.indexType;
+                stats_.bufferBinds++;
+            } else {
+                stats_.bufferBindsSaved++;
+            }
+        }
+
+        if (!constantsValid || draw.materialIndex != pushed[0] || draw.bufferIndex != pushed[1]) {
+            pushed[0] = draw.materialIndex;
+            pushed[1] = draw.bufferIndex;
+            vkCmdPushConstants(commandBuffer, layout, VK_SHADER_STAGE_ALL, 0, sizeof(pushed), pushed);
+            constantsValid = true;
+            stats_.constantPushes++;
+        } else {
+            stats_.constantPushesSaved++;
+        }
+
+        if (draw.indexBuffer != VK_NULL_HANDLE) {
+            vkCmdDrawIndexed(commandBuffer, draw.count, draw.instanceCount, draw.first, draw.vertexOffset,
+                             draw.firstInstance);
+        } else {
+            vkCmdDraw(commandBuffer, draw.count, draw.instanceCount, draw.first, draw.firstInstance);
+        }
+    }
+}
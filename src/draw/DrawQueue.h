@@ -0,0 +1,138 @@
+#ifndef DRAW_QUEUE_H
+#define DRAW_QUEUE_H
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "../jobs/RadixSort.h"
+
+class JobSystem;
+
+enum class DrawPass : uint32_t {
+    Shadow,
+    Opaque,
+    Transparent,
+};
+
+// Everything needed to record one draw. Geometry is addressed inside shared
+// buffers through firstIndex / vertexOffset, so consecutive draws of different
+// meshes can keep the same buffer bindings.
+struct DrawPacket {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkBuffer vertexBuffer = VK_NULL_HANDLE;
+    // VK_NULL_HANDLE records a non-indexed draw
+    VkBuffer indexBuffer = VK_NULL_HANDLE;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    // index count, or vertex count for non-indexed draws
+    uint32_t count = 0;
+    // first index, or first vertex for non-indexed draws
+    uint32_t first = 0;
+    int32_t vertexOffset = 0;
+    uint32_t instanceCount = 1;
+    // per-object data index, read in the shader through gl_InstanceIndex
+    uint32_t firstInstance = 0;
+    // the DrawConstants push constants of bindless.glsl
+    uint32_t materialIndex = 0;
+    uint32_t bufferIndex = 0;
+};
+
+// 64-bit draw sort keys, most significant field first:
+//
+//   opaque / shadow:  pass:4 | pipeline:16 | material:20 | depth:24 (front to back)
+//   transparent:      pass:4 | depth:24 (back to front) | pipeline:16 | material:20
+//
+// Transparent draws must blend in depth order, so depth outranks state there.
+// Fields wider than their bits wrap; that only costs extra binds, because the
+// recorder compares the actual handles, never the keys.
+namespace draw_key {
+    constexpr uint32_t passBits = 4;
+    constexpr uint32_t pipelineBits = 16;
+    constexpr uint32_t materialBits = 20;
+    constexpr uint32_t depthBits = 24;
+    constexpr uint32_t maxDepthBucket = (1u << depthBits) - 1;
+
+    constexpr uint64_t field(uint32_t value, uint32_t bits) {
+        return value & ((uint64_t(1) << bits) - 1);
+    }
+
+    // Quantizes a view depth in [0, farPlane] into a key bucket. Depths outside
+    // the range clamp to the ends; a non-positive far plane or a NaN depth gives bucket 0.
+    inline uint32_t depthBucket(float depth, float farPlane) {
+        if (!(farPlane > 0.0f)) {
+            return 0;
+        }
+        float normalized = depth / farPlane;
+        // written so NaN fails the test, std::clamp would pass it through to the cast
+        if (!(normalized > 0.0f)) {
+            return 0;
+        }
+        return static_cast<uint32_t>(std::min(normalized, 1.0f) * static_cast<float>(maxDepthBucket));
+    }
+
+    constexpr uint64_t make(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t depthBucket) {
+        uint64_t key = field(static_cast<uint32_t>(pass), passBits) << (64 - passBits);
+        if (pass == DrawPass::Transparent) {
+            key |= field(maxDepthBucket - depthBucket, depthBits) << (pipelineBits + materialBits);
+            key |= field(pipeline, pipelineBits) << materialBits;
+            key |= field(material, materialBits);
+        } else {
+            key |= field(pipeline, pipelineBits) << (materialBits + depthBits);
+            key |= field(material, materialBits) << depthBits;
+            key |= field(depthBucket, depthBits);
+        }
+        return key;
+    }
+}
+
+// Per-frame list of draws. Callers add() packets with their sort keys in any
+// order; sort() orders them by key and record() emits them, binding a
+// pipeline, vertex or index buffer or push constants only when they differ
+// from the previous draw's. stats() counts both the calls made and the ones
+// skipped relative to binding everything for every draw.
+class DrawQueue {
+public:
+    struct Stats {
+        uint32_t draws = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t bufferBinds = 0;
+        uint32_t constantPushes = 0;
+        uint32_t pipelineBindsSaved = 0;
+        uint32_t bufferBindsSaved = 0;
+        uint32_t constantPushesSaved = 0;
+
+        [[nodiscard]] uint32_t bindsSaved() const {
+            return pipelineBindsSaved + bufferBindsSaved + constantPushesSaved;
+        }
+    };
+
+    void clear();
+    void reserve(size_t count);
+
+    void add(uint64_t key, const DrawPacket& packet);
+
+    // Radix sorts the keys, in parallel with `jobs`. Draws with equal keys keep their add() order.
+    void sort(JobSystem* jobs = nullptr);
+
+    // Records every draw in the current order into a command buffer inside a
+    // render pass. `layout` is the layout the push constants are pushed
+    // through, normally BindlessTable::pipelineLayout(): its push-constant
+    // range must cover VK_SHADER_STAGE_ALL.
+    void record(VkCommandBuffer commandBuffer, VkPipelineLayout layout);
+
+    [[nodiscard]] size_t size() const { return packets.size(); }
+    // packet indices with their keys, in recording order
+    [[nodiscard]] const std::vector<RadixSortEntry>& order() const { return entries; }
+    [[nodiscard]] const DrawPacket& packet(uint32_t index) const { return packets[index]; }
+    // of the last record()
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+
+private:
+    std::vector<DrawPacket> packets;
+    std::vector<RadixSortEntry> entries;
+    RadixSortScratch scratch;
+    Stats stats_;
+};
+
+#endif //DRAW_QUEUE_H
@@ -1,7 +1,16 @@
 #include <fstream>
 #include <stdexcept>
+#include <utility>
 #include "files.h"
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define VULCAN_MMAP 1
+#endif
+
 namespace utils {
     std::vector<char> readFile(const std::string& filename) {
         std::ifstream file(filename, std::ios::ate | std::ios::binary);
@@ -15,4 +24,68 @@ namespace utils {
         file.close();
         return buffer;
     }
+
+    MappedFile::MappedFile(const std::string& filename) {
+#ifdef VULCAN_MMAP
+        int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open file!");
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error("failed to stat file!");
+        }
+        size = static_cast<size_t>(info.st_size);
+        // mmap rejects empty mappings; an empty file is just an empty view
+        if (size > 0) {
+            void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("failed to map file!");
+            }
+            data = static_cast<const std::byte*>(view);
+            mapped = true;
+        }
+        // the mapping keeps the file alive
+        close(fd);
+#else
+        fallback = readFile(filename);
+        data = reinterpret_cast<const std::byte*>(fallback.data());
+        size = fallback.size();
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+        unmap();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data(std::exchange(other.data, nullptr)),
+          size(std::exchange(other.size, 0)),
+          mapped(std::exchange(other.mapped, false)),
+          fallback(std::move(other.fallback)) {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data = std::exchange(other.data, nullptr);
+            size = std::exchange(other.size, 0);
+            mapped = std::exchange(other.mapped, false);
+            fallback = std::move(other.fallback);
+        }
+        return *this;
+    }
+
+    void MappedFile::unmap() {
+#ifdef VULCAN_MMAP
+        if (mapped) {
+            munmap(const_cast<std::byte*>(data), size);
+        }
+#endif
+        mapped = false;
+        data = nullptr;
+        size = 0;
+    }
 }
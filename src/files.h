@@ -4,9 +4,37 @@
 
 #ifndef FILES_H
 #define FILES_H
+#include <cstddef>
+#include <span>
 #include <string>
 #include <vector>
 
-std::vector<char> readFile(const std::string &filename);
+namespace utils {
+    std::vector<char> readFile(const std::string &filename);
+
+    // Read-only view of a whole file. Memory mapped where the platform allows,
+    // so opening costs no copy and pages are read on first touch; elsewhere it
+    // falls back to readFile().
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& filename);
+        ~MappedFile();
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        [[nodiscard]] std::span<const std::byte> bytes() const { return {data, size}; }
+
+    private:
+        const std::byte* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        std::vector<char> fallback;
+
+        void unmap();
+    };
+}
 
 #endif //FILES_H
@@ -0,0 +1,200 @@
+#include "JobSystem.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+    thread_local const void* currentSystem = nullptr;
+    thread_local uint32_t currentIndex = UINT32_MAX;
+
+    // spins before a worker parks itself on the condition variable
+    constexpr int idleSpins = 64;
+}
+
+JobSystem::JobSystem() : JobSystem(Options{}) {
+}
+
+JobSystem::JobSystem(Options options) {
+    start(options);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(sleepMutex);
+        stopping.store(true);
+    }
+    wake.notify_all();
+    for (auto& worker: workers) {
+        worker.join();
+    }
+
+    // nothing may be left holding a counter someone is about to wait on
+    while (tryRunOne(0)) {
+    }
+    currentSystem = nullptr;
+    currentIndex = UINT32_MAX;
+}
+
+void JobSystem::start(Options options) {
+    uint32_t workerCount = options.workerCount.value_or(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+    for (uint32_t i = 0; i <= workerCount; i++) {
+        deques.push_back(std::make_unique<Deque>());
+        pools.push_back(std::make_unique<JobPool>());
+    }
+    pools.push_back(std::make_unique<JobPool>());
+
+    currentSystem = this;
+    currentIndex = 0;
+
+    for (uint32_t i = 1; i <= workerCount; i++) {
+        workers.emplace_back(&JobSystem::workerLoop, this, i, options.pinThreads);
+    }
+}
+
+uint32_t JobSystem::currentThreadIndex() {
+    return currentIndex;
+}
+
+JobSystem::Job* JobSystem::allocateJob() {
+    if (currentSystem == this) {
+        return takeJob(currentIndex);
+    }
+    std::lock_guard lock(outsidePoolMutex);
+    return takeJob(static_cast<uint32_t>(pools.size() - 1));
+}
+
+JobSystem::Job* JobSystem::takeJob(uint32_t index) {
+    JobPool& pool = *pools[index];
+    if (!pool.free) {
+        pool.free = pool.returned.exchange(nullptr, std::memory_order_acquire);
+    }
+    if (!pool.free) {
+        auto& block = pool.blocks.emplace_back(std::make_unique<Job[]>(jobBlockSize));
+        for (size_t i = 0; i < jobBlockSize; i++) {
+            block[i].next = i + 1 < jobBlockSize ? &block[i + 1] : nullptr;
+        }
+        pool.free = &block[0];
+    }
+    Job* job = pool.free;
+    pool.free = job->next;
+    job->pool = index;
+    return job;
+}
+
+void JobSystem::releaseJob(Job* job) {
+    JobPool& pool = *pools[job->pool];
+    if (currentSystem == this && job->pool == currentIndex) {
+        job->next = pool.free;
+        pool.free = job;
+        return;
+    }
+    // the owner only ever takes the whole stack, so there is no ABA to guard against
+    Job* head = pool.returned.load(std::memory_order_relaxed);
+    do {
+        job->next = head;
+    } while (!pool.returned.compare_exchange_weak(head, job, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void JobSystem::submit(Job* job) {
+    if (currentSystem == this) {
+        if (!deques[currentIndex]->push(job)) {
+            // deque is full: the producer is far ahead of the workers, so just do the work
+            execute(job);
+            return;
+        }
+    } else {
+        std::lock_guard lock(injectMutex);
+        injected.push_back(job);
+    }
+
+    queued.fetch_add(1);
+    if (sleeping.load() > 0) {
+        std::lock_guard lock(sleepMutex);
+        wake.notify_one();
+    }
+}
+
+void JobSystem::execute(Job* job) {
+    JobCounter* counter = job->counter;
+    job->invoke(*job);
+    releaseJob(job);
+    if (counter) {
+        counter->done();
+    }
+}
+
+bool JobSystem::tryRunOne(uint32_t self) {
+    Job* job = nullptr;
+    bool found = self != UINT32_MAX && deques[self]->pop(job);
+
+    if (!found) {
+        auto count = static_cast<uint32_t>(deques.size());
+        uint32_t start = self == UINT32_MAX ? 0 : self + 1;
+        for (uint32_t i = 0; i < count && !found; i++) {
+            uint32_t victim = (start + i) % count;
+            found = victim != self && deques[victim]->steal(job);
+        }
+    }
+
+    if (!found) {
+        std::lock_guard lock(injectMutex);
+        if (!injected.empty()) {
+            job = injected.front();
+            injected.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+    queued.fetch_sub(1);
+    execute(job);
+    return true;
+}
+
+void JobSystem::wait(const JobCounter& counter) {
+    uint32_t self = currentSystem == this ? currentIndex : UINT32_MAX;
+    while (!counter.isDone()) {
+        if (!tryRunOne(self)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::workerLoop(uint32_t index, bool pin) {
+    currentSystem = this;
+    currentIndex = index;
+
+#ifdef __linux__
+    if (pin) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(index % std::max(std::thread::hardware_concurrency(), 1u), &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#else
+    (void) pin;
+#endif
+
+    int spins = 0;
+    while (!stopping.load(std::memory_order_relaxed)) {
+        if (tryRunOne(index)) {
+            spins = 0;
+            continue;
+        }
+        if (++spins < idleSpins) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        sleeping.fetch_add(1);
+        wake.wait(lock, [this] { return stopping.load() || queued.load() > 0; });
+        sleeping.fetch_sub(1);
+        spins = 0;
+    }
+}
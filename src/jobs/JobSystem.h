@@ -0,0 +1,186 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "WorkStealingDeque.h"
+
+// Tracks outstanding jobs. Every job submitted with a counter increments it and
+// decrements it when finished, so JobSystem::wait() acts as a join point for
+// any number of jobs and a job can wait on the counters it depends on.
+class JobCounter {
+public:
+    void add(int32_t count = 1) {
+        pending.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    void done() {
+        pending.fetch_sub(1, std::memory_order_release);
+    }
+
+    [[nodiscard]] bool isDone() const {
+        return pending.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    std::atomic<int32_t> pending{0};
+};
+
+// Work-stealing scheduler with one Chase-Lev deque per thread.
+//
+// The thread that constructs the system takes slot 0 and participates in
+// work while it waits; the remaining slots belong to worker threads. Jobs
+// pushed from a participating thread go to its own deque (LIFO for cache
+// warmth); idle threads steal from the others (FIFO). Jobs submitted from
+// unrelated threads go through a locked injection queue. Jobs must not throw.
+//
+// Jobs come from per-thread pools that only ever grow, so once a workload has
+// run a frame, submitting it again allocates nothing as long as every closure
+// fits in Job::storage (larger ones are boxed on the heap).
+class JobSystem {
+public:
+    struct Options {
+        // threads besides the caller; unset picks hardware_concurrency() - 1, and 0
+        // runs every job on the thread that waits for it
+        std::optional<uint32_t> workerCount;
+        // pin worker i to logical CPU i + 1 (Linux only)
+        bool pinThreads = false;
+    };
+
+    JobSystem();
+    explicit JobSystem(Options options);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    template<typename F>
+    void run(F&& function, JobCounter* counter = nullptr) {
+        if (counter) {
+            counter->add();
+        }
+        submit(makeJob(std::forward<F>(function), counter));
+    }
+
+    // Runs other jobs until the counter drains.
+    void wait(const JobCounter& counter);
+
+    // Fork/join over [0, count) in chunks of `grain`; function(begin, end) is called per chunk.
+    template<typename F>
+    void parallelFor(uint32_t count, uint32_t grain, F&& function) {
+        if (count == 0) {
+            return;
+        }
+        grain = std::max(grain, 1u);
+        JobCounter counter;
+        uint32_t begin = 0;
+        for (; begin + grain < count; begin += grain) {
+            run([&function, begin, grain] { function(begin, begin + grain); }, &counter);
+        }
+        // the caller takes the last chunk itself instead of idling
+        function(begin, count);
+        wait(counter);
+    }
+
+    [[nodiscard]] uint32_t threadCount() const {
+        return static_cast<uint32_t>(deques.size());
+    }
+
+    // Slot of the calling thread in [0, threadCount()), or UINT32_MAX for outside threads.
+    static uint32_t currentThreadIndex();
+
+private:
+    static constexpr size_t inlineSize = 48;
+    static constexpr size_t dequeCapacity = 4096;
+    static constexpr size_t jobBlockSize = 256;
+
+    struct Job {
+        void (*invoke)(Job&);
+        JobCounter* counter;
+        // free list link while pooled
+        Job* next;
+        // index of the pool the job returns to
+        uint32_t pool;
+        alignas(std::max_align_t) std::byte storage[inlineSize];
+    };
+
+    // Jobs are taken by the owning thread only and may be finished on any
+    // thread: the owner recycles its own jobs straight into `free`, others
+    // push them onto `returned`, which the owner takes over whole once
+    // `free` runs dry.
+    struct alignas(64) JobPool {
+        Job* free = nullptr;
+        std::atomic<Job*> returned{nullptr};
+        std::vector<std::unique_ptr<Job[]>> blocks;
+    };
+
+    using Deque = WorkStealingDeque<Job*, dequeCapacity>;
+
+    std::vector<std::unique_ptr<Deque>> deques;
+    std::vector<std::thread> workers;
+
+    // one per thread slot, then a shared one for outside threads behind outsidePoolMutex
+    std::vector<std::unique_ptr<JobPool>> pools;
+    std::mutex outsidePoolMutex;
+
+    std::mutex injectMutex;
+    std::deque<Job*> injected;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int64_t> queued{0};
+    std::atomic<uint32_t> sleeping{0};
+    std::atomic<bool> stopping{false};
+
+    template<typename F>
+    Job* makeJob(F&& function, JobCounter* counter) {
+        using Fn = std::decay_t<F>;
+        Job* job = allocateJob();
+        job->counter = counter;
+        if constexpr (sizeof(Fn) <= inlineSize && alignof(Fn) <= alignof(std::max_align_t)) {
+            new(job->storage) Fn(std::forward<F>(function));
+            job->invoke = [](Job& self) {
+                Fn* fn = std::launder(reinterpret_cast<Fn*>(self.storage));
+                (*fn)();
+                fn->~Fn();
+            };
+        } else {
+            new(job->storage) Fn*(new Fn(std::forward<F>(function)));
+            job->invoke = [](Job& self) {
+                Fn* fn = *std::launder(reinterpret_cast<Fn**>(self.storage));
+                (*fn)();
+                delete fn;
+            };
+        }
+        return job;
+    }
+
+    void start(Options options);
+
+    Job* allocateJob();
+    Job* takeJob(uint32_t pool);
+    void releaseJob(Job* job);
+
+    void submit(Job* job);
+
+    void execute(Job* job);
+
+    bool tryRunOne(uint32_t self);
+
+    void workerLoop(uint32_t index, bool pin);
+};
+
+#endif //JOB_SYSTEM_H
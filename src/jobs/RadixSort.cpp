@@ -0,0 +1,111 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "JobSystem.h"
+
+namespace {
+    // 11-bit digits: six passes cover 64-bit keys, and a 2048-entry histogram still fits in L1
+    constexpr uint32_t digitBits = 11;
+    constexpr uint32_t radix = 1u << digitBits;
+    constexpr uint64_t digitMask = radix - 1;
+
+    template<typename F>
+    void forChunks(JobSystem* jobs, uint32_t chunkCount, F&& function) {
+        if (jobs && chunkCount > 1) {
+            jobs->parallelFor(chunkCount, 1, [&function](uint32_t begin, uint32_t end) {
+                for (uint32_t chunk = begin; chunk < end; chunk++) {
+                    function(chunk);
+                }
+            });
+        } else {
+            for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+                function(chunk);
+            }
+        }
+    }
+}
+
+void radixSort(std::span<RadixSortEntry> entries, RadixSortScratch& scratch, JobSystem* jobs, uint32_t grain) {
+    const uint32_t count = static_cast<uint32_t>(entries.size());
+    if (count < 2) {
+        return;
+    }
+
+    // a few chunks per thread so an uneven split still balances
+    grain = std::max(grain, 1u);
+    uint32_t chunkCount = jobs ? std::min((count + grain - 1) / grain, jobs->threadCount() * 4) : 1;
+    chunkCount = std::max(chunkCount, 1u);
+    const uint32_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    auto chunkRange = [&](uint32_t chunk) {
+        uint32_t begin = std::min(chunk * chunkSize, count);
+        return std::pair{begin, std::min(begin + chunkSize, count)};
+    };
+
+    // bits that differ from the first key anywhere in the input
+    std::vector<uint64_t>& chunkDiffs = scratch.chunkDiffs;
+    chunkDiffs.resize(chunkCount);
+    const uint64_t firstKey = entries[0].key;
+    forChunks(jobs, chunkCount, [&](uint32_t chunk) {
+        auto [begin, end] = chunkRange(chunk);
+        uint64_t diff = 0;
+        for (uint32_t i = begin; i < end; i++) {
+            diff |= entries[i].key ^ firstKey;
+        }
+        chunkDiffs[chunk] = diff;
+    });
+    uint64_t diff = 0;
+    for (uint64_t chunkDiff: chunkDiffs) {
+        diff |= chunkDiff;
+    }
+
+    RadixSortEntry* source = entries.data();
+    scratch.entries.resize(count);
+    RadixSortEntry* destination = scratch.entries.data();
+    // offsets[chunk * radix + digit]: where the chunk's next entry with that digit goes
+    std::vector<uint32_t>& offsets = scratch.offsets;
+    offsets.resize(static_cast<size_t>(chunkCount) * radix);
+
+    for (uint32_t shift = 0; shift < 64; shift += digitBits) {
+        if (((diff >> shift) & digitMask) == 0) {
+            continue;
+        }
+
+        forChunks(jobs, chunkCount, [&](uint32_t chunk) {
+            auto [begin, end] = chunkRange(chunk);
+            uint32_t* histogram = &offsets[static_cast<size_t>(chunk) * radix];
+            std::fill(histogram, histogram + radix, 0u);
+            for (uint32_t i = begin; i < end; i++) {
+                histogram[(source[i].key >> shift) & digitMask]++;
+            }
+        });
+
+        // digit-major prefix sum keeps equal digits in chunk order, which keeps the sort stable
+        uint32_t total = 0;
+        for (uint32_t digit = 0; digit < radix; digit++) {
+            for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+                uint32_t& slot = offsets[static_cast<size_t>(chunk) * radix + digit];
+                uint32_t digitCount = slot;
+                slot = total;
+                total += digitCount;
+            }
+        }
+
+        forChunks(jobs, chunkCount, [&](uint32_t chunk) {
+            auto [begin, end] = chunkRange(chunk);
+            uint32_t* offset = &offsets[static_cast<size_t>(chunk) * radix];
+            for (uint32_t i = begin; i < end; i++) {
+                destination[offset[(source[i].key >> shift) & digitMask]++] = source[i];
+            }
+        });
+        std::swap(source, destination);
+    }
+
+    if (source != entries.data()) {
+        forChunks(jobs, chunkCount, [&](uint32_t chunk) {
+            auto [begin, end] = chunkRange(chunk);
+            std::copy(source + begin, source + end, entries.data() + begin);
+        });
+    }
+}
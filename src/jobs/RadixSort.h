@@ -0,0 +1,31 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class JobSystem;
+
+struct RadixSortEntry {
+    uint64_t key;
+    uint32_t value;
+};
+
+// Working memory of radixSort(). The buffers only grow, so a scratch kept
+// alive across sorts of similar size stops allocating after the first.
+struct RadixSortScratch {
+    std::vector<RadixSortEntry> entries;
+    std::vector<uint64_t> chunkDiffs;
+    // chunkCount histograms of radix counters
+    std::vector<uint32_t> offsets;
+};
+
+// Stable LSD radix sort on the 64-bit keys, 11 bits per pass. Digits that are
+// equal across all keys are skipped, so keys with unused high bits cost fewer
+// passes. With `jobs`, each pass counts and scatters chunks of at least
+// `grain` entries in parallel. The result always ends up in `entries`.
+void radixSort(std::span<RadixSortEntry> entries, RadixSortScratch& scratch, JobSystem* jobs = nullptr,
+               uint32_t grain = 16384);
+
+#endif //RADIX_SORT_H
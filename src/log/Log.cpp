@@ -0,0 +1,44 @@
+#include "Log.h"
+
+#include <atomic>
+#include <cstdlib>
+
+namespace logging {
+    namespace {
+        LogLevel initialLevel() {
+            LogLevel level = LogLevel::Info;
+            if (const char* env = std::getenv("VULCAN_LOG_LEVEL")) {
+                parseLevel(env, level);
+            }
+            return level;
+        }
+
+        std::atomic<LogLevel>& currentLevel() {
+            static std::atomic<LogLevel> current{initialLevel()};
+            return current;
+        }
+    }
+
+    LogLevel level() {
+        return currentLevel().load(std::memory_order_relaxed);
+    }
+
+    void setLevel(LogLevel level) {
+        currentLevel().store(level, std::memory_order_relaxed);
+    }
+
+    bool parseLevel(std::string_view name, LogLevel& level) {
+        if (name == "error") {
+            level = LogLevel::Error;
+        } else if (name == "warning") {
+            level = LogLevel::Warning;
+        } else if (name == "info") {
+            level = LogLevel::Info;
+        } else if (name == "verbose") {
+            level = LogLevel::Verbose;
+        } else {
+            return false;
+        }
+        return true;
+    }
+}
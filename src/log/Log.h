@@ -0,0 +1,28 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <string_view>
+
+enum class LogLevel {
+    Error,
+    Warning,
+    Info,
+    Verbose,
+};
+
+// Process-wide log threshold. Starts at Info, or whatever VULCAN_LOG_LEVEL
+// (error, warning, info, verbose) says.
+namespace logging {
+    LogLevel level();
+
+    void setLevel(LogLevel level);
+
+    inline bool enabled(LogLevel messageLevel) {
+        return messageLevel <= level();
+    }
+
+    // false if `name` is not a level name
+    bool parseLevel(std::string_view name, LogLevel& level);
+}
+
+#endif //LOG_H
@@ -0,0 +1,237 @@
+#include "ValidationLog.h"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+
+#include "Log.h"
+
+namespace {
+    LogLevel logLevel(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+        switch (severity) {
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT:
+                return LogLevel::Error;
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT:
+                return LogLevel::Warning;
+            case VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT:
+                return LogLevel::Info;
+            default:
+                return LogLevel::Verbose;
+        }
+    }
+}
+
+ValidationLog::ValidationLog() : ValidationLog(Options{}) {
+}
+
+ValidationLog::ValidationLog(Options options)
+    : options(options), out(options.out ? *options.out : std::cerr), head(new Node), tail(head.load()),
+      idSlotCount(std::bit_ceil(std::max(options.idCapacity, 1u))) {
+    idSlots = std::make_unique<IdSlot[]>(idSlotCount + 1);
+}
+
+ValidationLog::~ValidationLog() {
+    stopping.store(true, std::memory_order_release);
+    sequence.fetch_add(1, std::memory_order_release);
+    sequence.notify_one();
+    if (drainThread.joinable()) {
+        drainThread.join();
+    }
+
+    for (uint32_t i = 0; i <= idSlotCount; i++) {
+        const IdSlot& slot = idSlots[i];
+        reportHeldBack(static_cast<int32_t>(slot.messageId.load(std::memory_order_relaxed)), slot.idName,
+                       i == idSlotCount, slot.heldBack.load(std::memory_order_relaxed));
+    }
+    out.flush();
+    delete tail;
+}
+
+size_t ValidationLog::severityIndex(VkDebugUtilsMessageSeverityFlagBitsEXT severity) {
+    // the severity bits are 0x1, 0x10, 0x100, 0x1000
+    return std::min<size_t>(std::countr_zero(static_cast<uint32_t>(severity)) / 4, 3);
+}
+
+VkBool32 ValidationLog::callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+                                 VkDebugUtilsMessageTypeFlagsEXT types,
+                                 const VkDebugUtilsMessengerCallbackDataEXT* data,
+                                 void* userData) {
+    static_cast<ValidationLog*>(userData)->submit(severity, types, *data);
+    return VK_FALSE;
+}
+
+void ValidationLog::submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                           const VkDebugUtilsMessengerCallbackDataEXT& data) {
+    severityCounts[severityIndex(severity)].fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < typeCounts.size(); i++) {
+        if (types & (1u << i)) {
+            typeCounts[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // filtered messages are counted but never copied
+    if (!logging::enabled(logLevel(severity))) {
+        return;
+    }
+
+    // Rate limit before anything is copied. The thread that moves the window on
+    // collects the repeats held back in the old one and reports them with its
+    // message; the reset races with concurrent submits, which at worst lets a
+    // window print a message or two more or fewer.
+    IdSlot& slot = slotFor(data);
+    Clock::rep now = Clock::now().time_since_epoch().count();
+    Clock::rep start = slot.windowStart.load(std::memory_order_relaxed);
+    uint64_t heldBack = 0;
+    if (now - start >= std::chrono::duration_cast<Clock::duration>(options.window).count() &&
+        slot.windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        slot.inWindow.store(0, std::memory_order_relaxed);
+        heldBack = slot.heldBack.exchange(0, std::memory_order_relaxed);
+    }
+    if (slot.inWindow.fetch_add(1, std::memory_order_relaxed) >= options.maxPerWindow) {
+        slot.heldBack.fetch_add(heldBack + 1, std::memory_order_relaxed);
+        slot.total.fetch_add(1, std::memory_order_relaxed);
+        suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (depth.fetch_add(1, std::memory_order_relaxed) >= options.queueCapacity) {
+        depth.fetch_sub(1, std::memory_order_relaxed);
+        slot.heldBack.fetch_add(heldBack, std::memory_order_relaxed);
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    slot.total.fetch_add(1, std::memory_order_relaxed);
+
+    std::call_once(drainStarted, [this] { drainThread = std::thread([this] { drainLoop(); }); });
+
+    Node* node = new Node;
+    node->messageId = data.messageIdNumber;
+    node->heldBack = heldBack;
+    node->sharedLimit = &slot == &idSlots[idSlotCount];
+    node->idName = data.pMessageIdName ? data.pMessageIdName : "";
+    node->text = data.pMessage ? data.pMessage : "";
+
+    Node* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+
+    pushed.fetch_add(1, std::memory_order_release);
+    sequence.fetch_add(1, std::memory_order_release);
+    sequence.notify_one();
+}
+
+ValidationLog::Counters ValidationLog::counters() const {
+    Counters counters;
+    for (size_t i = 0; i < counters.bySeverity.size(); i++) {
+        counters.bySeverity[i] = severityCounts[i].load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < counters.byType.size(); i++) {
+        counters.byType[i] = typeCounts[i].load(std::memory_order_relaxed);
+    }
+    counters.suppressed = suppressedCount.load(std::memory_order_relaxed);
+    counters.dropped = droppedCount.load(std::memory_order_relaxed);
+    return counters;
+}
+
+ValidationLog::IdSlot& ValidationLog::slotFor(const VkDebugUtilsMessengerCallbackDataEXT& data) {
+    uint32_t mask = idSlotCount - 1;
+    uint32_t index = (static_cast<uint32_t>(data.messageIdNumber) * 2654435761u) & mask;
+    for (uint32_t probe = 0; probe < idSlotCount; probe++, index = (index + 1) & mask) {
+        IdSlot& slot = idSlots[index];
+        int64_t current = slot.messageId.load(std::memory_order_acquire);
+        if (current == IdSlot::empty) {
+            if (slot.messageId.compare_exchange_strong(current, data.messageIdNumber, std::memory_order_acq_rel)) {
+                // once per ID, so the allocation stays off the repeat path
+                slot.idName = data.pMessageIdName ? data.pMessageIdName : "";
+                return slot;
+            }
+        }
+        if (current == data.messageIdNumber) {
+            return slot;
+        }
+    }
+    return idSlots[idSlotCount];
+}
+
+const ValidationLog::IdSlot* ValidationLog::findSlot(int32_t messageId) const {
+    uint32_t mask = idSlotCount - 1;
+    uint32_t index = (static_cast<uint32_t>(messageId) * 2654435761u) & mask;
+    for (uint32_t probe = 0; probe < idSlotCount; probe++, index = (index + 1) & mask) {
+        int64_t current = idSlots[index].messageId.load(std::memory_order_acquire);
+        if (current == messageId) {
+            return &idSlots[index];
+        }
+        if (current == IdSlot::empty) {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+uint64_t ValidationLog::occurrences(int32_t messageId) const {
+    const IdSlot* slot = findSlot(messageId);
+    return slot ? slot->total.load(std::memory_order_relaxed) : 0;
+}
+
+void ValidationLog::flush() {
+    uint64_t target = pushed.load(std::memory_order_acquire);
+    for (uint64_t done = drained.load(std::memory_order_acquire); done < target;
+         done = drained.load(std::memory_order_acquire)) {
+        drained.wait(done, std::memory_order_acquire);
+    }
+}
+
+void ValidationLog::drainLoop() {
+    for (;;) {
+        uint32_t seen = sequence.load(std::memory_order_acquire);
+        bool wrote = false;
+        while (drainOnce()) {
+            wrote = true;
+        }
+        if (wrote) {
+            out.flush();
+            drained.notify_all();
+        }
+        if (stopping.load(std::memory_order_acquire)) {
+            return;
+        }
+        sequence.wait(seen, std::memory_order_acquire);
+    }
+}
+
+bool ValidationLog::drainOnce() {
+    Node* current = tail;
+    Node* next = current->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+        // empty, or a producer is between its exchange and its link; it bumps
+        // `sequence` once linked, so the wait in drainLoop will not miss it
+        return false;
+    }
+    // `next` becomes the new stub; its payload stays valid until the next pop frees it
+    tail = next;
+    delete current;
+
+    emit(*next);
+    depth.fetch_sub(1, std::memory_order_relaxed);
+    drained.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void ValidationLog::emit(const Node& message) {
+    reportHeldBack(message.messageId, message.idName, message.sharedLimit, message.heldBack);
+    out << "validation layer: " << message.text << '\n';
+}
+
+void ValidationLog::reportHeldBack(int32_t messageId, const std::string& idName, bool sharedLimit, uint64_t count) {
+    if (count == 0) {
+        return;
+    }
+    out << "validation layer: " << count << " more ";
+    if (sharedLimit) {
+        out << "untracked";
+    } else if (!idName.empty()) {
+        out << idName;
+    } else {
+        out << "id " << messageId;
+    }
+    out << " messages suppressed\n";
+}
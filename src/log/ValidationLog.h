@@ -0,0 +1,136 @@
+#ifndef VALIDATION_LOG_H
+#define VALIDATION_LOG_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vulkan/vulkan_core.h>
+
+// Sink for VK_EXT_debug_utils messages. The messenger callback runs on
+// whatever thread the driver or layer happens to be on, so it only counts the
+// message and pushes a copy onto a lock-free MPSC queue; a background thread
+// does the formatting and I/O.
+//
+// Output is deduplicated by messageIdNumber: each ID prints at most
+// `maxPerWindow` messages per `window`, and the repeats that were held back
+// are reported as a single line once the window has passed. The limit is
+// applied in the callback through a lock-free per-ID counter, so a repeat
+// costs a few atomics and is never copied or queued.
+class ValidationLog {
+public:
+    struct Options {
+        uint32_t maxPerWindow = 3;
+        std::chrono::milliseconds window{1000};
+        // messages beyond this many waiting for the drain thread are dropped (and counted)
+        uint32_t queueCapacity = 4096;
+        // IDs tracked individually (rounded up to a power of two); any beyond share one limit
+        uint32_t idCapacity = 512;
+        std::ostream* out = nullptr; // std::cerr when null
+    };
+
+    // Indexed by severityIndex() and typeIndex().
+    struct Counters {
+        std::array<uint64_t, 4> bySeverity{}; // verbose, info, warning, error
+        std::array<uint64_t, 4> byType{};     // general, validation, performance, device address binding
+        uint64_t suppressed = 0;
+        uint64_t dropped = 0;
+
+        [[nodiscard]] uint64_t errors() const { return bySeverity[3]; }
+        [[nodiscard]] uint64_t warnings() const { return bySeverity[2]; }
+    };
+
+    ValidationLog();
+    explicit ValidationLog(Options options);
+    ~ValidationLog();
+
+    ValidationLog(const ValidationLog&) = delete;
+    ValidationLog& operator=(const ValidationLog&) = delete;
+
+    // Pass as pfnUserCallback with this log as pUserData.
+    static VKAPI_ATTR VkBool32 VKAPI_CALL callback(
+        VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+        VkDebugUtilsMessageTypeFlagsEXT types,
+        const VkDebugUtilsMessengerCallbackDataEXT* data,
+        void* userData);
+
+    void submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types,
+                const VkDebugUtilsMessengerCallbackDataEXT& data);
+
+    // Safe to call from any thread at any time.
+    [[nodiscard]] Counters counters() const;
+    // Times `messageId` was printed or suppressed. Messages below the log level,
+    // dropped on overflow or past idCapacity distinct IDs only show up in counters().
+    [[nodiscard]] uint64_t occurrences(int32_t messageId) const;
+
+    // Blocks until everything submitted so far has been written out.
+    void flush();
+
+    static size_t severityIndex(VkDebugUtilsMessageSeverityFlagBitsEXT severity);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        int32_t messageId = 0;
+        // repeats suppressed in the window before this message, reported ahead of it
+        uint64_t heldBack = 0;
+        bool sharedLimit = false;
+        std::string idName;
+        std::string text;
+    };
+
+    // Open-addressed by messageId; slots are claimed once and never freed.
+    struct IdSlot {
+        static constexpr int64_t empty = INT64_MIN;
+
+        std::atomic<int64_t> messageId{empty};
+        std::atomic<uint64_t> total{0};
+        std::atomic<Clock::rep> windowStart{0};
+        std::atomic<uint32_t> inWindow{0};
+        std::atomic<uint64_t> heldBack{0};
+        // written once by the claiming thread; read only by the destructor
+        std::string idName;
+    };
+
+    Options options;
+    std::ostream& out;
+
+    // Vyukov intrusive queue: producers exchange `head`, only the drain thread touches `tail`
+    std::atomic<Node*> head;
+    Node* tail;
+    std::atomic<uint32_t> depth{0};
+    // bumped after every push and on shutdown; the drain thread waits on it
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint64_t> drained{0};
+    std::atomic<uint64_t> pushed{0};
+    std::atomic<bool> stopping{false};
+
+    std::array<std::atomic<uint64_t>, 4> severityCounts{};
+    std::array<std::atomic<uint64_t>, 4> typeCounts{};
+    std::atomic<uint64_t> suppressedCount{0};
+    std::atomic<uint64_t> droppedCount{0};
+
+    // idSlotCount slots followed by the one shared by IDs that found no free slot
+    std::unique_ptr<IdSlot[]> idSlots;
+    uint32_t idSlotCount;
+
+    // started by the first message, so release builds without a messenger never spawn it
+    std::once_flag drainStarted;
+    std::thread drainThread;
+
+    void drainLoop();
+    bool drainOnce();
+    [[nodiscard]] IdSlot& slotFor(const VkDebugUtilsMessengerCallbackDataEXT& data);
+    [[nodiscard]] const IdSlot* findSlot(int32_t messageId) const;
+    void emit(const Node& message);
+    void reportHeldBack(int32_t messageId, const std::string& idName, bool sharedLimit, uint64_t count);
+};
+
+#endif //VALIDATION_LOG_H
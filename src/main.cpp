@@ -1,10 +1,78 @@
+#include <cstring>
+#include <iostream>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include "Window.h"
+#include "device.h"
+#include "jobs/JobSystem.h"
+#include "log/Log.h"
+#include "startup/StartupLoader.h"
+#include "startup/StartupTimeline.h"
 
-int main() {
-    const auto window = Window(800, 600, "Vulkan");
+namespace {
+    const std::vector<std::string> shaderPaths = {"build/shader.vert.spv", "build/shader.frag.spv"};
+    const std::string pipelineCachePath = "build/pipeline_cache.bin";
+}
+
+// usage: foobar [--device=<index|name>] [--log-level=error|warning|info|verbose]
+int main(int argc, char** argv) {
+    StartupTimeline timeline;
+
+    for (int i = 1; i < argc; i++) {
+        LogLevel level;
+        if (strncmp(argv[i], "--log-level=", 12) == 0 && logging::parseLevel(argv[i] + 12, level)) {
+            logging::setLevel(level);
+        }
+    }
+
+    JobSystem jobs;
+    StartupLoader loader(jobs, &timeline);
+
+    // these reads need no device, so they run on the workers while the window and device come up
+    for (const std::string& path: shaderPaths) {
+        loader.prefetch(path);
+    }
+    loader.prefetchPipelineCache(pipelineCachePath);
+
+    auto windowStart = StartupTimeline::Clock::now();
+    Window window(800, 600, "Vulkan");
+    timeline.record("create window", windowStart, StartupTimeline::Clock::now());
+
+    DeviceOptions options = DeviceOptions::fromCommandLine(argc, argv);
+    options.timeline = &timeline;
+    Device device(window, options);
+
+    VkPipelineCache pipelineCache = loader.createPipelineCache(device);
+    std::vector<VkShaderModule> shaderModules;
+    bool shadersFound = true;
+    for (const std::string& path: shaderPaths) {
+        shadersFound = loader.loaded(path) && shadersFound;
+    }
+    if (shadersFound) {
+        shaderModules = loader.createShaderModules(device, shaderPaths);
+    } else if (logging::enabled(LogLevel::Warning)) {
+        std::cerr << "compiled shaders not found under build/, skipping shader modules\n";
+    }
+
+    bool firstPoll = true;
     while (!window.shouldClose()) {
         glfwPollEvents();
+        if (firstPoll) {
+            firstPoll = false;
+            timeline.markFirstPoll();
+            if (logging::enabled(LogLevel::Info)) {
+                std::cout << "startup timeline:\n";
+                timeline.report(std::cout);
+            }
+        }
+    }
+
+    vkDeviceWaitIdle(device.device());
+    for (VkShaderModule module: shaderModules) {
+        vkDestroyShaderModule(device.device(), module, nullptr);
     }
+    StartupLoader::savePipelineCache(device, pipelineCache, pipelineCachePath);
+    vkDestroyPipelineCache(device.device(), pipelineCache, nullptr);
 }
@@ -0,0 +1,408 @@
+#include "Kernels.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VULCAN_KERNELS_X86 1
+// AVX2 code is compiled per function so the rest of the binary still runs on
+// any x86-64 CPU; it is only called after the CPU check in detect().
+#define VULCAN_AVX2 __attribute__((target("avx2,fma")))
+#endif
+
+namespace kernels {
+    namespace {
+        using ComposeFn = void (*)(const TransformSoA&, const uint32_t*, const AffineSoA&, uint32_t, uint32_t);
+        using BoundsFn = void (*)(const AffineSoA&, const BoundsSoA&, const BoundsSoA&, float*, uint32_t, uint32_t);
+        using CullFn = uint32_t (*)(const SphereSoA&, const Frustum&, uint32_t, uint32_t, uint32_t*);
+
+        struct Table {
+            Isa isa;
+            ComposeFn compose;
+            BoundsFn bounds;
+            CullFn cull;
+        };
+
+        // ---- scalar ----
+
+        void composeScalar(const TransformSoA& local, const uint32_t* parent, const AffineSoA& world,
+                           uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                Transform transform{
+                    {local.px[i], local.py[i], local.pz[i]},
+                    {local.qx[i], local.qy[i], local.qz[i], local.qw[i]},
+                    {local.sx[i], local.sy[i], local.sz[i]},
+                };
+                Affine result = toAffine(transform);
+                if (parent[i] != noParent) {
+                    Affine parentWorld;
+                    for (int k = 0; k < 12; k++) {
+                        parentWorld.m[k] = world.m[k][parent[i]];
+                    }
+                    result = parentWorld * result;
+                }
+                for (int k = 0; k < 12; k++) {
+                    world.m[k][i] = result.m[k];
+                }
+            }
+        }
+
+        void boundsScalar(const AffineSoA& world, const BoundsSoA& local, const BoundsSoA& out, float* radius,
+                          uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; i++) {
+                Affine a;
+                for (int k = 0; k < 12; k++) {
+                    a.m[k] = world.m[k][i];
+                }
+                Bounds b = transformBounds(a, {{local.cx[i], local.cy[i], local.cz[i]},
+                                               {local.ex[i], local.ey[i], local.ez[i]}});
+                out.cx[i] = b.center.x;
+                out.cy[i] = b.center.y;
+                out.cz[i] = b.center.z;
+                out.ex[i] = b.extents.x;
+                out.ey[i] = b.extents.y;
+                out.ez[i] = b.extents.z;
+                radius[i] = length(b.extents);
+            }
+        }
+
+        uint32_t cullScalar(const SphereSoA& spheres, const Frustum& frustum, uint32_t begin, uint32_t end,
+                            uint32_t* visible) {
+            uint32_t count = 0;
+            for (uint32_t i = begin; i < end; i++) {
+                visible[count] = i;
+                count += frustum.intersects({spheres.x[i], spheres.y[i], spheres.z[i]}, spheres.radius[i]);
+            }
+            return count;
+        }
+
+#ifdef VULCAN_KERNELS_X86
+        // ---- SSE2, 4 objects per iteration ----
+
+        void composeSse2(const TransformSoA& local, const uint32_t* parent, const AffineSoA& world,
+                         uint32_t begin, uint32_t end) {
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 two = _mm_set1_ps(2.0f);
+            constexpr float identity[12] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0};
+
+            uint32_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                __m128 qx = _mm_loadu_ps(local.qx + i), qy = _mm_loadu_ps(local.qy + i);
+                __m128 qz = _mm_loadu_ps(local.qz + i), qw = _mm_loadu_ps(local.qw + i);
+                __m128 sx = _mm_loadu_ps(local.sx + i), sy = _mm_loadu_ps(local.sy + i);
+                __m128 sz = _mm_loadu_ps(local.sz + i);
+                __m128 xx = _mm_mul_ps(qx, qx), yy = _mm_mul_ps(qy, qy), zz = _mm_mul_ps(qz, qz);
+                __m128 xy = _mm_mul_ps(qx, qy), xz = _mm_mul_ps(qx, qz), yz = _mm_mul_ps(qy, qz);
+                __m128 wx = _mm_mul_ps(qw, qx), wy = _mm_mul_ps(qw, qy), wz = _mm_mul_ps(qw, qz);
+
+                __m128 l[12] = {
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+                    _mm_loadu_ps(local.px + i),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+                    _mm_loadu_ps(local.py + i),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+                    _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+                    _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+                    _mm_loadu_ps(local.pz + i),
+                };
+
+                bool anyParent = (parent[i] & parent[i + 1] & parent[i + 2] & parent[i + 3]) != noParent;
+                if (!anyParent) {
+                    for (int k = 0; k < 12; k++) {
+                        _mm_storeu_ps(world.m[k] + i, l[k]);
+                    }
+                    continue;
+                }
+
+                // no gather before AVX2, so the parent rows are assembled lane by lane
+                __m128 p[12];
+                for (int k = 0; k < 12; k++) {
+                    alignas(16) float lanes[4];
+                    for (int lane = 0; lane < 4; lane++) {
+                        uint32_t index = parent[i + lane];
+                        lanes[lane] = index == noParent ? identity[k] : world.m[k][index];
+                    }
+                    p[k] = _mm_load_ps(lanes);
+                }
+                for (int row = 0; row < 3; row++) {
+                    const __m128* r = &p[row * 4];
+                    for (int column = 0; column < 4; column++) {
+                        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0], l[column]), _mm_mul_ps(r[1], l[4 + column])),
+                                                _mm_mul_ps(r[2], l[8 + column]));
+                        if (column == 3) {
+                            sum = _mm_add_ps(sum, r[3]);
+                        }
+                        _mm_storeu_ps(world.m[row * 4 + column] + i, sum);
+                    }
+                }
+            }
+            composeScalar(local, parent, world, i, end);
+        }
+
+        void boundsSse2(const AffineSoA& world, const BoundsSoA& local, const BoundsSoA& out, float* radius,
+                        uint32_t begin, uint32_t end) {
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            uint32_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                __m128 c[3] = {_mm_loadu_ps(local.cx + i), _mm_loadu_ps(local.cy + i), _mm_loadu_ps(local.cz + i)};
+                __m128 e[3] = {_mm_loadu_ps(local.ex + i), _mm_loadu_ps(local.ey + i), _mm_loadu_ps(local.ez + i)};
+                float* outCenter[3] = {out.cx, out.cy, out.cz};
+                float* outExtents[3] = {out.ex, out.ey, out.ez};
+                __m128 lengthSquared = _mm_setzero_ps();
+                for (int row = 0; row < 3; row++) {
+                    __m128 m0 = _mm_loadu_ps(world.m[row * 4] + i);
+                    __m128 m1 = _mm_loadu_ps(world.m[row * 4 + 1] + i);
+                    __m128 m2 = _mm_loadu_ps(world.m[row * 4 + 2] + i);
+                    __m128 m3 = _mm_loadu_ps(world.m[row * 4 + 3] + i);
+                    __m128 center = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, c[0]), _mm_mul_ps(m1, c[1])),
+                                               _mm_add_ps(_mm_mul_ps(m2, c[2]), m3));
+                    __m128 extent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, m0), e[0]),
+                                                          _mm_mul_ps(_mm_andnot_ps(signMask, m1), e[1])),
+                                               _mm_mul_ps(_mm_andnot_ps(signMask, m2), e[2]));
+                    _mm_storeu_ps(outCenter[row] + i, center);
+                    _mm_storeu_ps(outExtents[row] + i, extent);
+                    lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(extent, extent));
+                }
+                _mm_storeu_ps(radius + i, _mm_sqrt_ps(lengthSquared));
+            }
+            boundsScalar(world, local, out, radius, i, end);
+        }
+
+        uint32_t cullSse2(const SphereSoA& spheres, const Frustum& frustum, uint32_t begin, uint32_t end,
+                          uint32_t* visible) {
+            uint32_t count = 0;
+            uint32_t i = begin;
+            for (; i + 4 <= end; i += 4) {
+                __m128 x = _mm_loadu_ps(spheres.x + i), y = _mm_loadu_ps(spheres.y + i);
+                __m128 z = _mm_loadu_ps(spheres.z + i);
+                __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres.radius + i));
+                __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+                for (const Plane& plane: frustum.planes) {
+                    __m128 distance = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.normal.x)), _mm_mul_ps(y, _mm_set1_ps(plane.normal.y))),
+                        _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.normal.z)), _mm_set1_ps(plane.distance)));
+                    inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+                }
+                for (int bits = _mm_movemask_ps(inside); bits != 0; bits &= bits - 1) {
+                    visible[count++] = i + __builtin_ctz(bits);
+                }
+            }
+            return count + cullScalar(spheres, frustum, i, end, visible + count);
+        }
+
+        // ---- AVX2 + FMA, 8 objects per iteration ----
+
+        VULCAN_AVX2 void composeAvx2(const TransformSoA& local, const uint32_t* parent, const AffineSoA& world,
+                                     uint32_t begin, uint32_t end) {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            const __m256 two = _mm256_set1_ps(2.0f);
+            const __m256i none = _mm256_set1_epi32(-1);
+
+            uint32_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                __m256 qx = _mm256_loadu_ps(local.qx + i), qy = _mm256_loadu_ps(local.qy + i);
+                __m256 qz = _mm256_loadu_ps(local.qz + i), qw = _mm256_loadu_ps(local.qw + i);
+                __m256 sx = _mm256_loadu_ps(local.sx + i), sy = _mm256_loadu_ps(local.sy + i);
+                __m256 sz = _mm256_loadu_ps(local.sz + i);
+                __m256 xx = _mm256_mul_ps(qx, qx), yy = _mm256_mul_ps(qy, qy), zz = _mm256_mul_ps(qz, qz);
+                __m256 xy = _mm256_mul_ps(qx, qy), xz = _mm256_mul_ps(qx, qz), yz = _mm256_mul_ps(qy, qz);
+                __m256 wx = _mm256_mul_ps(qw, qx), wy = _mm256_mul_ps(qw, qy), wz = _mm256_mul_ps(qw, qz);
+
+                __m256 l[12] = {
+                    _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(yy, zz), one), sx),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz),
+                    _mm256_loadu_ps(local.px + i),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx),
+                    _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, zz), one), sy),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz),
+                    _mm256_loadu_ps(local.py + i),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx),
+                    _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy),
+                    _mm256_mul_ps(_mm256_fnmadd_ps(two, _mm256_add_ps(xx, yy), one), sz),
+                    _mm256_loadu_ps(local.pz + i),
+                };
+
+                __m256i indices = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(parent + i));
+                __m256 hasParent = _mm256_castsi256_ps(_mm256_xor_si256(_mm256_cmpeq_epi32(indices, none), none));
+                if (_mm256_movemask_ps(hasParent) == 0) {
+                    for (int k = 0; k < 12; k++) {
+                        _mm256_storeu_ps(world.m[k] + i, l[k]);
+                    }
+                    continue;
+                }
+
+                // lanes without a parent keep the identity row the gather starts from
+                __m256 p[12];
+                for (int k = 0; k < 12; k++) {
+                    __m256 identity = _mm256_set1_ps(k % 5 == 0 ? 1.0f : 0.0f);
+                    p[k] = _mm256_mask_i32gather_ps(identity, world.m[k], indices, hasParent, 4);
+                }
+                for (int row = 0; row < 3; row++) {
+                    const __m256* r = &p[row * 4];
+                    for (int column = 0; column < 4; column++) {
+                        __m256 sum = column == 3 ? r[3] : _mm256_setzero_ps();
+                        sum = _mm256_fmadd_ps(r[0], l[column], sum);
+                        sum = _mm256_fmadd_ps(r[1], l[4 + column], sum);
+                        sum = _mm256_fmadd_ps(r[2], l[8 + column], sum);
+                        _mm256_storeu_ps(world.m[row * 4 + column] + i, sum);
+                    }
+                }
+            }
+            composeScalar(local, parent, world, i, end);
+        }
+
+        VULCAN_AVX2 void boundsAvx2(const AffineSoA& world, const BoundsSoA& local, const BoundsSoA& out,
+                                    float* radius, uint32_t begin, uint32_t end) {
+            const __m256 signMask = _mm256_set1_ps(-0.0f);
+            uint32_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                __m256 c[3] = {_mm256_loadu_ps(local.cx + i), _mm256_loadu_ps(local.cy + i),
+                               _mm256_loadu_ps(local.cz + i)};
+                __m256 e[3] = {_mm256_loadu_ps(local.ex + i), _mm256_loadu_ps(local.ey + i),
+                               _mm256_loadu_ps(local.ez + i)};
+                float* outCenter[3] = {out.cx, out.cy, out.cz};
+                float* outExtents[3] = {out.ex, out.ey, out.ez};
+                __m256 lengthSquared = _mm256_setzero_ps();
+                for (int row = 0; row < 3; row++) {
+                    __m256 m0 = _mm256_loadu_ps(world.m[row * 4] + i);
+                    __m256 m1 = _mm256_loadu_ps(world.m[row * 4 + 1] + i);
+                    __m256 m2 = _mm256_loadu_ps(world.m[row * 4 + 2] + i);
+                    __m256 m3 = _mm256_loadu_ps(world.m[row * 4 + 3] + i);
+                    __m256 center = _mm256_fmadd_ps(m0, c[0], _mm256_fmadd_ps(m1, c[1], _mm256_fmadd_ps(m2, c[2], m3)));
+                    __m256 extent = _mm256_mul_ps(_mm256_andnot_ps(signMask, m0), e[0]);
+                    extent = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, m1), e[1], extent);
+                    extent = _mm256_fmadd_ps(_mm256_andnot_ps(signMask, m2), e[2], extent);
+                    _mm256_storeu_ps(outCenter[row] + i, center);
+                    _mm256_storeu_ps(outExtents[row] + i, extent);
+                    lengthSquared = _mm256_fmadd_ps(extent, extent, lengthSquared);
+                }
+                _mm256_storeu_ps(radius + i, _mm256_sqrt_ps(lengthSquared));
+            }
+            boundsScalar(world, local, out, radius, i, end);
+        }
+
+        VULCAN_AVX2 uint32_t cullAvx2(const SphereSoA& spheres, const Frustum& frustum, uint32_t begin,
+                                      uint32_t end, uint32_t* visible) {
+            __m256 nx[6], ny[6], nz[6], d[6];
+            for (int plane = 0; plane < 6; plane++) {
+                nx[plane] = _mm256_set1_ps(frustum.planes[plane].normal.x);
+                ny[plane] = _mm256_set1_ps(frustum.planes[plane].normal.y);
+                nz[plane] = _mm256_set1_ps(frustum.planes[plane].normal.z);
+                d[plane] = _mm256_set1_ps(frustum.planes[plane].distance);
+            }
+
+            uint32_t count = 0;
+            uint32_t i = begin;
+            for (; i + 8 <= end; i += 8) {
+                __m256 x = _mm256_loadu_ps(spheres.x + i), y = _mm256_loadu_ps(spheres.y + i);
+                __m256 z = _mm256_loadu_ps(spheres.z + i);
+                __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(spheres.radius + i));
+                __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+                for (int plane = 0; plane < 6; plane++) {
+                    __m256 distance = _mm256_fmadd_ps(x, nx[plane],
+                                                      _mm256_fmadd_ps(y, ny[plane], _mm256_fmadd_ps(z, nz[plane], d[plane])));
+                    inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+                }
+                for (int bits = _mm256_movemask_ps(inside); bits != 0; bits &= bits - 1) {
+                    visible[count++] = i + __builtin_ctz(bits);
+                }
+            }
+            return count + cullScalar(spheres, frustum, i, end, visible + count);
+        }
+#endif
+
+        constexpr Table scalarTable{Isa::Scalar, composeScalar, boundsScalar, cullScalar};
+#ifdef VULCAN_KERNELS_X86
+        constexpr Table sse2Table{Isa::Sse2, composeSse2, boundsSse2, cullSse2};
+        constexpr Table avx2Table{Isa::Avx2, composeAvx2, boundsAvx2, cullAvx2};
+#endif
+
+        const Table* tableFor(Isa isa) {
+            switch (isa) {
+#ifdef VULCAN_KERNELS_X86
+                case Isa::Avx2:
+                    return &avx2Table;
+                case Isa::Sse2:
+                    return &sse2Table;
+#endif
+                default:
+                    return &scalarTable;
+            }
+        }
+
+        const Table* detect() {
+            for (Isa candidate: {Isa::Avx2, Isa::Sse2}) {
+                if (supported(candidate)) {
+                    return tableFor(candidate);
+                }
+            }
+            return &scalarTable;
+        }
+
+        const Table*& active() {
+            static const Table* table = detect();
+            return table;
+        }
+    }
+
+    bool supported(Isa isa) {
+        switch (isa) {
+            case Isa::Scalar:
+                return true;
+#ifdef VULCAN_KERNELS_X86
+            case Isa::Sse2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("sse2");
+            case Isa::Avx2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+            default:
+                return false;
+        }
+    }
+
+    Isa isa() {
+        return active()->isa;
+    }
+
+    void setIsa(Isa isa) {
+        if (!supported(isa)) {
+            throw std::invalid_argument(std::string(name(isa)) + " is not supported on this CPU");
+        }
+        active() = tableFor(isa);
+    }
+
+    const char* name(Isa isa) {
+        switch (isa) {
+            case Isa::Sse2:
+                return "sse2";
+            case Isa::Avx2:
+                return "avx2";
+            default:
+                return "scalar";
+        }
+    }
+
+    void composeWorld(const TransformSoA& local, const uint32_t* parent, const AffineSoA& world,
+                      uint32_t begin, uint32_t end) {
+        active()->compose(local, parent, world, begin, end);
+    }
+
+    void transformBounds(const AffineSoA& world, const BoundsSoA& local, const BoundsSoA& out, float* radius,
+                         uint32_t begin, uint32_t end) {
+        active()->bounds(world, local, out, radius, begin, end);
+    }
+
+    uint32_t cullSpheres(const SphereSoA& spheres, const Frustum& frustum, uint32_t begin, uint32_t end,
+                         uint32_t* visible) {
+        return active()->cull(spheres, frustum, begin, end, visible);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstdint>
+
+#include "Math.h"
+
+// Batch versions of the Math.h per-object operations over structure-of-arrays
+// data, processing 4 (SSE2) or 8 (AVX2 + FMA) objects per instruction. The
+// implementation is chosen once at startup from the CPU's features and can be
+// overridden with setIsa() to compare against the scalar code. Every kernel
+// works on the index range [begin, end), so callers can split work across
+// threads.
+namespace kernels {
+    constexpr uint32_t noParent = UINT32_MAX;
+
+    // Local TRS, one array per float.
+    struct TransformSoA {
+        const float* px;
+        const float* py;
+        const float* pz;
+        const float* qx;
+        const float* qy;
+        const float* qz;
+        const float* qw;
+        const float* sx;
+        const float* sy;
+        const float* sz;
+    };
+
+    // Row-major 3x4 affine: m[row * 4 + column][object].
+    struct AffineSoA {
+        float* m[12];
+    };
+
+    struct BoundsSoA {
+        float* cx;
+        float* cy;
+        float* cz;
+        float* ex;
+        float* ey;
+        float* ez;
+    };
+
+    struct SphereSoA {
+        const float* x;
+        const float* y;
+        const float* z;
+        const float* radius;
+    };
+
+    enum class Isa {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // world[i] = world[parent[i]] * affine(local[i]), or just the local affine
+    // when parent[i] is noParent. Parents must lie outside [begin, end) and be
+    // computed already, which holds per level of a depth-sorted hierarchy.
+    void composeWorld(const TransformSoA& local, const uint32_t* parent, const AffineSoA& world,
+                      uint32_t begin, uint32_t end);
+
+    // World AABBs of the local boxes, plus the radius of the sphere around each
+    // world box (used by cullSpheres).
+    void transformBounds(const AffineSoA& world, const BoundsSoA& local, const BoundsSoA& out, float* radius,
+                         uint32_t begin, uint32_t end);
+
+    // Writes the indices of spheres touching the frustum to `visible`, in
+    // order, and returns how many there were. `visible` needs room for end - begin.
+    uint32_t cullSpheres(const SphereSoA& spheres, const Frustum& frustum, uint32_t begin, uint32_t end,
+                         uint32_t* visible);
+
+    Isa isa();
+    [[nodiscard]] bool supported(Isa isa);
+    // Throws std::invalid_argument if the CPU lacks `isa`. Not thread safe against running kernels.
+    void setIsa(Isa isa);
+    const char* name(Isa isa);
+}
+
+#endif //KERNELS_H
@@ -0,0 +1,273 @@
+#ifndef MATH_H
+#define MATH_H
+
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define VULCAN_MATH_SSE 1
+#endif
+
+// Engine math. Mat4 is column-major like GLSL, with Vulkan clip space (y down,
+// depth 0..1); Mat4 products use SSE where the target has it. Object
+// transforms are stored as row-major 3x4 affine matrices, 48 bytes each. Batch
+// versions of the per-object operations over SoA arrays are in Kernels.h.
+struct Vec3 {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+};
+
+inline Vec3 operator+(Vec3 a, Vec3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+inline Vec3 operator-(Vec3 a, Vec3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Vec3 operator-(Vec3 a) { return {-a.x, -a.y, -a.z}; }
+inline Vec3 operator*(Vec3 a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+inline Vec3 operator*(float s, Vec3 a) { return a * s; }
+
+inline float dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 cross(Vec3 a, Vec3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline float length(Vec3 a) { return std::sqrt(dot(a, a)); }
+inline Vec3 normalize(Vec3 a) { return a * (1.0f / length(a)); }
+
+struct alignas(16) Vec4 {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 0.0f;
+};
+
+struct Quat {
+    float x = 0.0f;
+    float y = 0.0f;
+    float z = 0.0f;
+    float w = 1.0f;
+
+    static Quat fromAxisAngle(Vec3 axis, float radians) {
+        Vec3 n = normalize(axis) * std::sin(radians * 0.5f);
+        return {n.x, n.y, n.z, std::cos(radians * 0.5f)};
+    }
+};
+
+// Applies b first, then a.
+inline Quat operator*(const Quat& a, const Quat& b) {
+    return {
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+    };
+}
+
+inline Quat conjugate(const Quat& q) { return {-q.x, -q.y, -q.z, q.w}; }
+
+inline Quat normalize(const Quat& q) {
+    float inverse = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return {q.x * inverse, q.y * inverse, q.z * inverse, q.w * inverse};
+}
+
+inline Vec3 rotate(const Quat& q, Vec3 v) {
+    Vec3 u{q.x, q.y, q.z};
+    Vec3 t = 2.0f * cross(u, v);
+    return v + q.w * t + cross(u, t);
+}
+
+struct alignas(16) Mat4 {
+    std::array<float, 16> m{1.0f, 0.0f, 0.0f, 0.0f,
+                            0.0f, 1.0f, 0.0f, 0.0f,
+                            0.0f, 0.0f, 1.0f, 0.0f,
+                            0.0f, 0.0f, 0.0f, 1.0f};
+
+    static Mat4 translation(Vec3 t) {
+        Mat4 result;
+        result.m[12] = t.x;
+        result.m[13] = t.y;
+        result.m[14] = t.z;
+        return result;
+    }
+
+    // Right-handed, looking down -Z, y flipped for Vulkan, depth 0 at the near plane.
+    static Mat4 perspective(float fovY, float aspect, float nearPlane, float farPlane) {
+        float f = 1.0f / std::tan(fovY * 0.5f);
+        Mat4 result;
+        result.m = {f / aspect, 0.0f, 0.0f, 0.0f,
+                    0.0f, -f, 0.0f, 0.0f,
+                    0.0f, 0.0f, farPlane / (nearPlane - farPlane), -1.0f,
+                    0.0f, 0.0f, nearPlane * farPlane / (nearPlane - farPlane), 0.0f};
+        return result;
+    }
+
+    static Mat4 lookAt(Vec3 eye, Vec3 target, Vec3 up) {
+        Vec3 forward = normalize(target - eye);
+        Vec3 side = normalize(cross(forward, up));
+        Vec3 realUp = cross(side, forward);
+        Mat4 result;
+        result.m = {side.x, realUp.x, -forward.x, 0.0f,
+                    side.y, realUp.y, -forward.y, 0.0f,
+                    side.z, realUp.z, -forward.z, 0.0f,
+                    -dot(side, eye), -dot(realUp, eye), dot(forward, eye), 1.0f};
+        return result;
+    }
+};
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b) {
+    Mat4 result;
+#ifdef VULCAN_MATH_SSE
+    __m128 c0 = _mm_load_ps(&a.m[0]);
+    __m128 c1 = _mm_load_ps(&a.m[4]);
+    __m128 c2 = _mm_load_ps(&a.m[8]);
+    __m128 c3 = _mm_load_ps(&a.m[12]);
+    for (int column = 0; column < 4; column++) {
+        const float* bColumn = &b.m[column * 4];
+        __m128 sum = _mm_mul_ps(c0, _mm_set1_ps(bColumn[0]));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(bColumn[1])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(bColumn[2])));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(bColumn[3])));
+        _mm_store_ps(&result.m[column * 4], sum);
+    }
+#else
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            result.m[column * 4 + row] = a.m[row] * b.m[column * 4] + a.m[4 + row] * b.m[column * 4 + 1] +
+                                         a.m[8 + row] * b.m[column * 4 + 2] + a.m[12 + row] * b.m[column * 4 + 3];
+        }
+    }
+#endif
+    return result;
+}
+
+inline Vec4 operator*(const Mat4& a, const Vec4& v) {
+    Vec4 result;
+    result.x = a.m[0] * v.x + a.m[4] * v.y + a.m[8] * v.z + a.m[12] * v.w;
+    result.y = a.m[1] * v.x + a.m[5] * v.y + a.m[9] * v.z + a.m[13] * v.w;
+    result.z = a.m[2] * v.x + a.m[6] * v.y + a.m[10] * v.z + a.m[14] * v.w;
+    result.w = a.m[3] * v.x + a.m[7] * v.y + a.m[11] * v.z + a.m[15] * v.w;
+    return result;
+}
+
+struct Transform {
+    Vec3 position;
+    Quat rotation;
+    Vec3 scale{1.0f, 1.0f, 1.0f};
+};
+
+// Rows produce x, y and z; column 3 is the translation. The implicit last row is 0 0 0 1.
+struct Affine {
+    std::array<float, 12> m{1.0f, 0.0f, 0.0f, 0.0f,
+                            0.0f, 1.0f, 0.0f, 0.0f,
+                            0.0f, 0.0f, 1.0f, 0.0f};
+};
+
+// Axis-aligned box as center and half extents.
+struct Bounds {
+    Vec3 center;
+    Vec3 extents;
+};
+
+// Points with dot(normal, p) + distance >= 0 are inside.
+struct Plane {
+    Vec3 normal;
+    float distance = 0.0f;
+};
+
+inline Affine toAffine(const Transform& transform) {
+    const Quat& q = transform.rotation;
+    const Vec3& s = transform.scale;
+    float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    Affine result;
+    result.m = {
+        (1.0f - 2.0f * (yy + zz)) * s.x, 2.0f * (xy - wz) * s.y, 2.0f * (xz + wy) * s.z, transform.position.x,
+        2.0f * (xy + wz) * s.x, (1.0f - 2.0f * (xx + zz)) * s.y, 2.0f * (yz - wx) * s.z, transform.position.y,
+        2.0f * (xz - wy) * s.x, 2.0f * (yz + wx) * s.y, (1.0f - 2.0f * (xx + yy)) * s.z, transform.position.z,
+    };
+    return result;
+}
+
+inline Affine operator*(const Affine& a, const Affine& b) {
+    Affine result;
+    for (int row = 0; row < 3; row++) {
+        const float* r = &a.m[row * 4];
+        for (int column = 0; column < 4; column++) {
+            result.m[row * 4 + column] = r[0] * b.m[column] + r[1] * b.m[4 + column] + r[2] * b.m[8 + column];
+        }
+        result.m[row * 4 + 3] += r[3];
+    }
+    return result;
+}
+
+inline Vec3 transformPoint(const Affine& a, const Vec3& p) {
+    return {
+        a.m[0] * p.x + a.m[1] * p.y + a.m[2] * p.z + a.m[3],
+        a.m[4] * p.x + a.m[5] * p.y + a.m[6] * p.z + a.m[7],
+        a.m[8] * p.x + a.m[9] * p.y + a.m[10] * p.z + a.m[11],
+    };
+}
+
+// Box of the transformed box (Arvo): the new extents are |M| applied to the old ones.
+inline Bounds transformBounds(const Affine& a, const Bounds& bounds) {
+    const Vec3& e = bounds.extents;
+    return {
+        transformPoint(a, bounds.center),
+        {
+            std::fabs(a.m[0]) * e.x + std::fabs(a.m[1]) * e.y + std::fabs(a.m[2]) * e.z,
+            std::fabs(a.m[4]) * e.x + std::fabs(a.m[5]) * e.y + std::fabs(a.m[6]) * e.z,
+            std::fabs(a.m[8]) * e.x + std::fabs(a.m[9]) * e.y + std::fabs(a.m[10]) * e.z,
+        },
+    };
+}
+
+struct Frustum {
+    // left, right, bottom, top, near, far
+    std::array<Plane, 6> planes;
+
+    // Gribb/Hartmann extraction from a column-major projection * view matrix
+    // with Vulkan's 0..1 clip depth.
+    static Frustum fromViewProjection(const Mat4& viewProjection) {
+        const std::array<float, 16>& m = viewProjection.m;
+        auto row = [&](int i) { return std::array<float, 4>{m[i], m[4 + i], m[8 + i], m[12 + i]}; };
+        auto plane = [](std::array<float, 4> a, std::array<float, 4> b, float sign) {
+            Plane p{{a[0] + sign * b[0], a[1] + sign * b[1], a[2] + sign * b[2]}, a[3] + sign * b[3]};
+            float length = std::sqrt(p.normal.x * p.normal.x + p.normal.y * p.normal.y + p.normal.z * p.normal.z);
+            p.normal = {p.normal.x / length, p.normal.y / length, p.normal.z / length};
+            p.distance /= length;
+            return p;
+        };
+        std::array<float, 4> r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+        return {{
+            plane(r3, r0, 1.0f),
+            plane(r3, r0, -1.0f),
+            plane(r3, r1, 1.0f),
+            plane(r3, r1, -1.0f),
+            plane(r2, r2, 0.0f),
+            plane(r3, r2, -1.0f),
+        }};
+    }
+
+    // Evaluates all six planes without early outs: in a culling loop the
+    // outcome is close to random, and a mispredicted branch costs more than
+    // the planes it would skip.
+    [[nodiscard]] bool intersects(const Bounds& bounds) const {
+        bool inside = true;
+        for (const Plane& p: planes) {
+            float radius = bounds.extents.x * std::fabs(p.normal.x) + bounds.extents.y * std::fabs(p.normal.y) +
+                           bounds.extents.z * std::fabs(p.normal.z);
+            float distance = p.normal.x * bounds.center.x + p.normal.y * bounds.center.y +
+                             p.normal.z * bounds.center.z + p.distance;
+            inside &= distance >= -radius;
+        }
+        return inside;
+    }
+
+    [[nodiscard]] bool intersects(Vec3 center, float radius) const {
+        bool inside = true;
+        for (const Plane& p: planes) {
+            inside &= dot(p.normal, center) + p.distance >= -radius;
+        }
+        return inside;
+    }
+};
+
+#endif //MATH_H
@@ -0,0 +1,174 @@
+#include "DeletionQueue.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "../device.h"
+
+namespace {
+    template<typename Handle>
+    Handle handleOf(uint64_t bits) {
+        if constexpr (std::is_pointer_v<Handle>) {
+            return reinterpret_cast<Handle>(static_cast<uintptr_t>(bits));
+        } else {
+            return static_cast<Handle>(bits);
+        }
+    }
+}
+
+DeletionQueue::DeletionQueue(Device& device, uint32_t framesInFlight)
+    : device(device), framesInFlight(framesInFlight) {
+}
+
+DeletionQueue::~DeletionQueue() {
+    flush();
+}
+
+void DeletionQueue::enqueue(Deletion deletion) {
+    if (deletion.handle == 0) {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    if (frames.empty() || frames.back().frame != currentFrame) {
+        frames.push_back({currentFrame, {}});
+    }
+    frames.back().deletions.push_back(deletion);
+}
+
+void DeletionQueue::enqueue(Deletion deletion, VkSemaphore timeline, uint64_t value) {
+    if (deletion.handle == 0) {
+        return;
+    }
+    std::lock_guard lock(mutex);
+    timelineDeletions.push_back({timeline, value, deletion});
+}
+
+void DeletionQueue::beginFrame(uint64_t frameIndex) {
+    std::vector<Deletion> ready;
+    {
+        std::lock_guard lock(mutex);
+        currentFrame = frameIndex;
+        while (!frames.empty() && frames.front().frame + framesInFlight <= frameIndex) {
+            std::vector<Deletion>& batch = frames.front().deletions;
+            ready.insert(ready.end(), batch.begin(), batch.end());
+            frames.pop_front();
+        }
+        collectTimelines(ready);
+    }
+    destroy(ready);
+}
+
+void DeletionQueue::collect() {
+    std::vector<Deletion> ready;
+    {
+        std::lock_guard lock(mutex);
+        collectTimelines(ready);
+    }
+    destroy(ready);
+}
+
+void DeletionQueue::collectTimelines(std::vector<Deletion>& ready) {
+    if (timelineDeletions.empty()) {
+        return;
+    }
+
+    // one query per semaphore, however many handles wait on it
+    std::unordered_map<VkSemaphore, uint64_t> reached;
+    for (const TimelineDeletion& pending: timelineDeletions) {
+        if (!reached.contains(pending.timeline)) {
+            uint64_t value = 0;
+            vkGetSemaphoreCounterValue(device.device(), pending.timeline, &value);
+            reached[pending.timeline] = value;
+        }
+    }
+
+    auto retired = std::stable_partition(timelineDeletions.begin(), timelineDeletions.end(),
+                                         [&](const TimelineDeletion& pending) {
+                                             return pending.value > reached[pending.timeline];
+                                         });
+    for (auto it = retired; it != timelineDeletions.end(); ++it) {
+        ready.push_back(it->deletion);
+    }
+    timelineDeletions.erase(retired, timelineDeletions.end());
+}
+
+void DeletionQueue::flush() {
+    std::vector<Deletion> ready;
+    {
+        std::lock_guard lock(mutex);
+        for (FrameBatch& batch: frames) {
+            ready.insert(ready.end(), batch.deletions.begin(), batch.deletions.end());
+        }
+        frames.clear();
+        for (const TimelineDeletion& pending: timelineDeletions) {
+            ready.push_back(pending.deletion);
+        }
+        timelineDeletions.clear();
+    }
+    destroy(ready);
+}
+
+void DeletionQueue::flush(VkSemaphore timeline) {
+    std::vector<Deletion> ready;
+    {
+        std::lock_guard lock(mutex);
+        auto retired = std::stable_partition(timelineDeletions.begin(), timelineDeletions.end(),
+                                             [&](const TimelineDeletion& pending) {
+                                                 return pending.timeline != timeline;
+                                             });
+        for (auto it = retired; it != timelineDeletions.end(); ++it) {
+            ready.push_back(it->deletion);
+        }
+        timelineDeletions.erase(retired, timelineDeletions.end());
+    }
+    destroy(ready);
+}
+
+size_t DeletionQueue::pending() const {
+    std::lock_guard lock(mutex);
+    size_t count = timelineDeletions.size();
+    for (const FrameBatch& batch: frames) {
+        count += batch.deletions.size();
+    }
+    return count;
+}
+
+void DeletionQueue::destroy(std::vector<Deletion>& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    std::stable_sort(batch.begin(), batch.end(), [](const Deletion& a, const Deletion& b) {
+        return a.kind < b.kind;
+    });
+
+    VkDevice vkDevice = device.device();
+    for (const Deletion& deletion: batch) {
+        switch (deletion.kind) {
+            case Kind::Framebuffer:
+                vkDestroyFramebuffer(vkDevice, handleOf<VkFramebuffer>(deletion.handle), nullptr);
+                break;
+            case Kind::ImageView:
+                vkDestroyImageView(vkDevice, handleOf<VkImageView>(deletion.handle), nullptr);
+                break;
+            case Kind::Sampler:
+                vkDestroySampler(vkDevice, handleOf<VkSampler>(deletion.handle), nullptr);
+                break;
+            case Kind::Pipeline:
+                vkDestroyPipeline(vkDevice, handleOf<VkPipeline>(deletion.handle), nullptr);
+                break;
+            case Kind::ShaderModule:
+                vkDestroyShaderModule(vkDevice, handleOf<VkShaderModule>(deletion.handle), nullptr);
+                break;
+            case Kind::Image:
+                vkDestroyImage(vkDevice, handleOf<VkImage>(deletion.handle), nullptr);
+                break;
+            case Kind::Buffer:
+                vkDestroyBuffer(vkDevice, handleOf<VkBuffer>(deletion.handle), nullptr);
+                break;
+            case Kind::DeviceMemory:
+                vkFreeMemory(vkDevice, handleOf<VkDeviceMemory>(deletion.handle), nullptr);
+                break;
+        }
+    }
+    destroyed.fetch_add(batch.size(), std::memory_order_relaxed);
+}
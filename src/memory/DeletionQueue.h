@@ -0,0 +1,172 @@
+#ifndef DELETION_QUEUE_H
+#define DELETION_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+class Device;
+
+// Defers vkDestroy*/vkFree* until the GPU can no longer be using the handle,
+// so dropping a resource never needs vkDeviceWaitIdle.
+//
+// By default a handle belongs to the frame being recorded and is destroyed by
+// the beginFrame() call framesInFlight frames later, once that frame's fence
+// has been waited on. Work on other queues can instead key a handle to a
+// timeline semaphore value; whoever owns the semaphore flushes its handles
+// before destroying it. Handles are destroyed in batches, views and
+// pipelines before the images, buffers and memory they depend on.
+class DeletionQueue {
+public:
+    enum class Kind : uint8_t {
+        // destruction order within a batch
+        Framebuffer,
+        ImageView,
+        Sampler,
+        Pipeline,
+        ShaderModule,
+        Image,
+        Buffer,
+        DeviceMemory,
+    };
+
+    struct Deletion {
+        Kind kind;
+        uint64_t handle;
+
+        Deletion(VkFramebuffer framebuffer) : kind(Kind::Framebuffer), handle(bits(framebuffer)) {}
+        Deletion(VkImageView view) : kind(Kind::ImageView), handle(bits(view)) {}
+        Deletion(VkSampler sampler) : kind(Kind::Sampler), handle(bits(sampler)) {}
+        Deletion(VkPipeline pipeline) : kind(Kind::Pipeline), handle(bits(pipeline)) {}
+        Deletion(VkShaderModule module) : kind(Kind::ShaderModule), handle(bits(module)) {}
+        Deletion(VkImage image) : kind(Kind::Image), handle(bits(image)) {}
+        Deletion(VkBuffer buffer) : kind(Kind::Buffer), handle(bits(buffer)) {}
+        Deletion(VkDeviceMemory memory) : kind(Kind::DeviceMemory), handle(bits(memory)) {}
+
+    private:
+        template<typename Handle>
+        static uint64_t bits(Handle handle) {
+            if constexpr (std::is_pointer_v<Handle>) {
+                return reinterpret_cast<uintptr_t>(handle);
+            } else {
+                return static_cast<uint64_t>(handle);
+            }
+        }
+    };
+
+    explicit DeletionQueue(Device& device, uint32_t framesInFlight = 2);
+    // Destroys whatever is left; the owner must have waited for the device to go idle.
+    ~DeletionQueue();
+
+    DeletionQueue(const DeletionQueue&) = delete;
+    DeletionQueue& operator=(const DeletionQueue&) = delete;
+
+    // Null handles are ignored. Safe to call from any thread.
+    void enqueue(Deletion deletion);
+    // Destroyed once `timeline` reaches `value` rather than at a frame boundary.
+    void enqueue(Deletion deletion, VkSemaphore timeline, uint64_t value);
+
+    // Destroys the batches of frames that are at least framesInFlight old and
+    // polls the timeline semaphores. Call after waiting on the frame's fence.
+    void beginFrame(uint64_t frameIndex);
+
+    // Polls the timeline semaphores only.
+    void collect();
+
+    // Destroys everything immediately; only valid while the device is idle.
+    void flush();
+    // Destroys the handles keyed to `timeline`. Owners call this once they have
+    // waited on it and before destroying it, so it is never polled afterwards.
+    void flush(VkSemaphore timeline);
+
+    [[nodiscard]] size_t pending() const;
+    [[nodiscard]] uint64_t destroyedCount() const { return destroyed.load(std::memory_order_relaxed); }
+
+private:
+    struct FrameBatch {
+        uint64_t frame;
+        std::vector<Deletion> deletions;
+    };
+
+    struct TimelineDeletion {
+        VkSemaphore timeline;
+        uint64_t value;
+        Deletion deletion;
+    };
+
+    Device& device;
+    uint32_t framesInFlight;
+    uint64_t currentFrame = 0;
+    std::atomic<uint64_t> destroyed{0};
+
+    mutable std::mutex mutex;
+    std::deque<FrameBatch> frames;
+    std::vector<TimelineDeletion> timelineDeletions;
+
+    void destroy(std::vector<Deletion>& batch);
+    void collectTimelines(std::vector<Deletion>& ready);
+};
+
+// Move-only owner of a single handle that retires it through a DeletionQueue
+// instead of destroying it on the spot.
+template<typename Handle>
+class Deferred {
+public:
+    Deferred() = default;
+
+    Deferred(DeletionQueue& queue, Handle handle) : queue(&queue), handle(handle) {}
+
+    ~Deferred() { reset(); }
+
+    Deferred(Deferred&& other) noexcept : queue(other.queue), handle(std::exchange(other.handle, VK_NULL_HANDLE)) {}
+
+    Deferred& operator=(Deferred&& other) noexcept {
+        if (this != &other) {
+            reset();
+            queue = other.queue;
+            handle = std::exchange(other.handle, VK_NULL_HANDLE);
+        }
+        return *this;
+    }
+
+    Deferred(const Deferred&) = delete;
+    Deferred& operator=(const Deferred&) = delete;
+
+    [[nodiscard]] Handle get() const { return handle; }
+    explicit operator bool() const { return handle != VK_NULL_HANDLE; }
+
+    // Gives up ownership without retiring the handle.
+    Handle release() { return std::exchange(handle, VK_NULL_HANDLE); }
+
+    void reset(Handle replacement = VK_NULL_HANDLE) {
+        if (handle != VK_NULL_HANDLE) {
+            queue->enqueue(handle);
+        }
+        handle = replacement;
+    }
+
+private:
+    DeletionQueue* queue = nullptr;
+    Handle handle = VK_NULL_HANDLE;
+};
+
+using DeferredPipeline = Deferred<VkPipeline>;
+using DeferredShaderModule = Deferred<VkShaderModule>;
+using DeferredImageView = Deferred<VkImageView>;
+
+struct DeferredBuffer {
+    Deferred<VkBuffer> buffer;
+    Deferred<VkDeviceMemory> memory;
+};
+
+struct DeferredImage {
+    Deferred<VkImage> image;
+    Deferred<VkDeviceMemory> memory;
+};
+
+#endif //DELETION_QUEUE_H
@@ -0,0 +1,85 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+
+#include "../jobs/JobSystem.h"
+
+FrameArena::FrameArena(size_t initialCapacity, std::pmr::memory_resource* upstream) : upstream(upstream) {
+    addBlock(headerSize + initialCapacity);
+}
+
+FrameArena::~FrameArena() {
+    releaseBlocks();
+}
+
+void FrameArena::addBlock(size_t size) {
+    auto* block = static_cast<Block*>(upstream->allocate(size, alignof(std::max_align_t)));
+    block->previous = current;
+    block->size = size;
+    current = block;
+    offset = headerSize;
+    upstreamCount++;
+}
+
+void FrameArena::releaseBlocks() {
+    while (current) {
+        Block* previous = current->previous;
+        upstream->deallocate(current, current->size, alignof(std::max_align_t));
+        current = previous;
+    }
+}
+
+size_t FrameArena::capacity() const {
+    size_t total = 0;
+    for (const Block* block = current; block; block = block->previous) {
+        total += block->size - headerSize;
+    }
+    return total;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    auto base = reinterpret_cast<uintptr_t>(current);
+    size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+    if (aligned + bytes > current->size) {
+        addBlock(std::max(current->size * 2, headerSize + bytes + alignment));
+        return do_allocate(bytes, alignment);
+    }
+    offset = aligned + bytes;
+    used += bytes;
+    return reinterpret_cast<std::byte*>(current) + aligned;
+}
+
+void FrameArena::do_deallocate(void*, size_t, size_t) {
+}
+
+bool FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void FrameArena::reset() {
+    if (current->previous) {
+        // this frame needed more than one block; size the next one to fit it all
+        size_t total = capacity();
+        releaseBlocks();
+        addBlock(headerSize + total);
+    }
+    offset = headerSize;
+    used = 0;
+}
+
+FrameArenas::FrameArenas(uint32_t threadCount, size_t capacityPerThread) {
+    for (uint32_t i = 0; i <= threadCount; i++) {
+        arenas.push_back(std::make_unique<FrameArena>(capacityPerThread));
+    }
+}
+
+FrameArena& FrameArenas::local() {
+    uint32_t index = JobSystem::currentThreadIndex();
+    return *arenas[std::min<size_t>(index, arenas.size() - 1)];
+}
+
+void FrameArenas::resetAll() {
+    for (auto& arena: arenas) {
+        arena->reset();
+    }
+}
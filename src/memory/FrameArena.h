@@ -0,0 +1,77 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Bump allocator for data that lives at most one frame. Allocation is a pointer
+// increment, deallocation is a no-op and reset() rewinds everything at once.
+// When a frame overflows the current block, the extra blocks are merged into a
+// single larger one on reset(), so a steady-state frame touches the general
+// heap zero times. Blocks are chained through a header at their start, so
+// overflowing into any number of them allocates nothing but the blocks.
+// Use it through std::pmr containers.
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(size_t initialCapacity = 64 * 1024,
+                        std::pmr::memory_resource* upstream = std::pmr::new_delete_resource());
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void reset();
+
+    [[nodiscard]] size_t bytesUsed() const { return used; }
+    [[nodiscard]] size_t capacity() const;
+    // number of times the arena had to go to the upstream resource
+    [[nodiscard]] uint64_t upstreamAllocations() const { return upstreamCount; }
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* pointer, size_t bytes, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+    // header at the start of every upstream allocation; the usable bytes follow it
+    struct Block {
+        Block* previous;
+        // of the whole allocation, header included
+        size_t size;
+    };
+
+    static constexpr size_t headerSize =
+        (sizeof(Block) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    std::pmr::memory_resource* upstream;
+    // the block being allocated from; earlier ones are overflow from this frame
+    Block* current = nullptr;
+    // next free byte of `current`, from its start
+    size_t offset = 0;
+    size_t used = 0;
+    uint64_t upstreamCount = 0;
+
+    void addBlock(size_t size);
+    void releaseBlocks();
+};
+
+// One FrameArena per JobSystem thread so jobs can allocate without contention.
+// resetAll() runs at frame end, once no job from that frame is still running.
+class FrameArenas {
+public:
+    FrameArenas(uint32_t threadCount, size_t capacityPerThread = 64 * 1024);
+
+    // Arena of the calling JobSystem thread; outside threads share the last one,
+    // which is reserved for them and must not be used concurrently.
+    FrameArena& local();
+
+    void resetAll();
+
+private:
+    std::vector<std::unique_ptr<FrameArena>> arenas;
+};
+
+#endif //FRAME_ARENA_H
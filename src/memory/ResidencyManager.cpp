@@ -0,0 +1,125 @@
+#include "ResidencyManager.h"
+
+#include <algorithm>
+
+#include "../device.h"
+
+ResidencyManager::ResidencyManager(Device& device, float budgetFraction, uint32_t framesInFlight)
+    : device(device), budgetFraction(budgetFraction), framesInFlight(framesInFlight),
+      ownerThread(std::this_thread::get_id()) {
+    for (const auto& heap: device.queryMemoryBudget()) {
+        heaps.push_back({heap.budget, heap.usage, 0});
+    }
+    device.setOutOfMemoryHandler([this](uint32_t heapIndex, VkDeviceSize size) {
+        // evict callbacks mutate render-thread state, so allocations failing on
+        // worker threads are not allowed to trigger them
+        return std::this_thread::get_id() == ownerThread && evict(heapIndex, size);
+    });
+}
+
+ResidencyManager::~ResidencyManager() {
+    device.setOutOfMemoryHandler(nullptr);
+}
+
+ResidencyId ResidencyManager::track(uint32_t memoryTypeIndex, VkDeviceSize size, EvictFn evict, ReloadFn reload) {
+    ResidencyId id;
+    if (!freeIds.empty()) {
+        id = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        id = static_cast<ResidencyId>(resources.size());
+        resources.emplace_back();
+    }
+
+    Resource& resource = resources[id];
+    resource.live = true;
+    resource.heapIndex = device.memoryHeapIndex(memoryTypeIndex);
+    resource.size = size;
+    resource.lastUsedFrame = currentFrame;
+    resource.evicted = false;
+    resource.reloadRequested = false;
+    resource.evict = std::move(evict);
+    resource.reload = std::move(reload);
+
+    heaps[resource.heapIndex].tracked += size;
+    return id;
+}
+
+void ResidencyManager::untrack(ResidencyId id) {
+    Resource& resource = resources[id];
+    heaps[resource.heapIndex].tracked -= resource.size;
+    resource = {};
+    freeIds.push_back(id);
+}
+
+void ResidencyManager::resize(ResidencyId id, VkDeviceSize size) {
+    Resource& resource = resources[id];
+    heaps[resource.heapIndex].tracked -= resource.size;
+    heaps[resource.heapIndex].tracked += size;
+    resource.size = size;
+    resource.evicted = false;
+    resource.reloadRequested = false;
+}
+
+void ResidencyManager::touch(ResidencyId id) {
+    Resource& resource = resources[id];
+    resource.lastUsedFrame = currentFrame;
+    if (resource.evicted && !resource.reloadRequested) {
+        resource.reloadRequested = true;
+        resource.reload();
+    }
+}
+
+VkDeviceSize ResidencyManager::heapUsage(uint32_t heapIndex) const {
+    // without the budget extension the driver reports nothing, so fall back to what we track
+    return device.hasMemoryBudget() ? heaps[heapIndex].usage : heaps[heapIndex].tracked;
+}
+
+void ResidencyManager::beginFrame(uint64_t frameIndex) {
+    currentFrame = frameIndex;
+
+    auto budgets = device.queryMemoryBudget();
+    for (uint32_t heapIndex = 0; heapIndex < heaps.size(); heapIndex++) {
+        heaps[heapIndex].budget = budgets[heapIndex].budget;
+        heaps[heapIndex].usage = budgets[heapIndex].usage;
+
+        auto limit = static_cast<VkDeviceSize>(static_cast<double>(heaps[heapIndex].budget) * budgetFraction);
+        VkDeviceSize usage = heapUsage(heapIndex);
+        if (usage > limit) {
+            evict(heapIndex, usage - limit);
+        }
+    }
+}
+
+bool ResidencyManager::evict(uint32_t heapIndex, VkDeviceSize bytes) {
+    std::vector<ResidencyId> candidates;
+    for (ResidencyId id = 0; id < resources.size(); id++) {
+        const Resource& resource = resources[id];
+        if (resource.live && resource.heapIndex == heapIndex && resource.size > 0 &&
+            resource.lastUsedFrame + framesInFlight < currentFrame) {
+            candidates.push_back(id);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](ResidencyId a, ResidencyId b) {
+        return resources[a].lastUsedFrame < resources[b].lastUsedFrame;
+    });
+
+    VkDeviceSize freed = 0;
+    for (ResidencyId id: candidates) {
+        if (freed >= bytes) {
+            break;
+        }
+        Resource& resource = resources[id];
+        VkDeviceSize released = std::min(resource.evict(bytes - freed), resource.size);
+        if (released == 0) {
+            continue;
+        }
+        resource.size -= released;
+        resource.evicted = true;
+        resource.reloadRequested = false;
+        heaps[heapIndex].tracked -= released;
+        freed += released;
+        evictions++;
+    }
+    return freed > 0;
+}
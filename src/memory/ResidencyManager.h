@@ -0,0 +1,84 @@
+#ifndef RESIDENCY_MANAGER_H
+#define RESIDENCY_MANAGER_H
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+class Device;
+
+using ResidencyId = uint32_t;
+
+// Keeps device-local allocations under the heap budget reported by
+// VK_EXT_memory_budget. Tracked resources record the frame they were last
+// used in; when a heap goes over budget the least recently used ones are asked
+// to give memory back. A resource may drop some mips or everything, and it is
+// re-requested the next time it is touched.
+class ResidencyManager {
+public:
+    // Releases up to the requested number of bytes and returns how much was freed.
+    using EvictFn = std::function<VkDeviceSize(VkDeviceSize wanted)>;
+    using ReloadFn = std::function<void()>;
+
+    struct HeapStats {
+        VkDeviceSize budget;
+        VkDeviceSize usage;
+        VkDeviceSize tracked;
+    };
+
+    // budgetFraction leaves headroom for allocations the manager does not track;
+    // resources used within the last framesInFlight frames are never evicted.
+    ResidencyManager(Device& device, float budgetFraction = 0.9f, uint32_t framesInFlight = 2);
+    ~ResidencyManager();
+
+    ResidencyManager(const ResidencyManager&) = delete;
+    ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+    ResidencyId track(uint32_t memoryTypeIndex, VkDeviceSize size, EvictFn evict, ReloadFn reload);
+    void untrack(ResidencyId id);
+
+    // Reports the new footprint after a reload completed.
+    void resize(ResidencyId id, VkDeviceSize size);
+
+    void touch(ResidencyId id);
+
+    // Queries the heap budgets and evicts until every heap is back under budget.
+    void beginFrame(uint64_t frameIndex);
+
+    // Evicts at least `bytes` from `heapIndex` if possible; used as the
+    // Device out-of-memory handler.
+    bool evict(uint32_t heapIndex, VkDeviceSize bytes);
+
+    [[nodiscard]] const std::vector<HeapStats>& heapStats() const { return heaps; }
+    [[nodiscard]] uint64_t evictionCount() const { return evictions; }
+
+private:
+    struct Resource {
+        bool live = false;
+        uint32_t heapIndex = 0;
+        VkDeviceSize size = 0;
+        uint64_t lastUsedFrame = 0;
+        // some or all of the data was evicted and has not been reloaded yet
+        bool evicted = false;
+        bool reloadRequested = false;
+        EvictFn evict;
+        ReloadFn reload;
+    };
+
+    Device& device;
+    float budgetFraction;
+    uint32_t framesInFlight;
+    uint64_t currentFrame = 0;
+    uint64_t evictions = 0;
+    std::thread::id ownerThread;
+
+    std::vector<Resource> resources;
+    std::vector<ResidencyId> freeIds;
+    std::vector<HeapStats> heaps;
+
+    [[nodiscard]] VkDeviceSize heapUsage(uint32_t heapIndex) const;
+};
+
+#endif //RESIDENCY_MANAGER_H
@@ -0,0 +1,125 @@
+#include "UniformRing.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../device.h"
+
+namespace {
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+UniformRing::UniformRing(Device& device, VkDeviceSize bytesPerFrame, uint32_t framesInFlight, uint32_t range)
+    : device(device),
+      framesInFlight(std::max(framesInFlight, 1u)),
+      range_(range),
+      alignment_(std::max<VkDeviceSize>(device.properties.limits.minUniformBufferOffsetAlignment, 1)),
+      frameSize(alignUp(std::max<VkDeviceSize>(bytesPerFrame, 1), alignment_)) {
+    if (range == 0 || range > device.properties.limits.maxUniformBufferRange) {
+        throw std::invalid_argument("uniform ring range exceeds maxUniformBufferRange");
+    }
+    // dynamic offsets are 32-bit, and the last allocation may be read up to `range` bytes
+    if (frameSize * this->framesInFlight + range_ > UINT32_MAX) {
+        throw std::invalid_argument("uniform ring does not fit 32-bit dynamic offsets");
+    }
+    createBuffer();
+    createDescriptorSet();
+}
+
+UniformRing::~UniformRing() {
+    vkDestroyDescriptorPool(device.device(), pool, nullptr);
+    vkDestroyDescriptorSetLayout(device.device(), descriptorSetLayout, nullptr);
+    vkUnmapMemory(device.device(), memory);
+    vkDestroyBuffer(device.device(), buffer_, nullptr);
+    vkFreeMemory(device.device(), memory, nullptr);
+}
+
+void UniformRing::createBuffer() {
+    // the tail past the last slice keeps offset + range inside the buffer for the last allocation
+    VkDeviceSize size = frameSize * framesInFlight + range_;
+    device.createBuffer(size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer_, memory);
+
+    void* data;
+    if (vkMapMemory(device.device(), memory, 0, VK_WHOLE_SIZE, 0, &data) != VK_SUCCESS) {
+        vkDestroyBuffer(device.device(), buffer_, nullptr);
+        vkFreeMemory(device.device(), memory, nullptr);
+        throw std::runtime_error("failed to map uniform ring!");
+    }
+    mapped = static_cast<std::byte*>(data);
+}
+
+void UniformRing::createDescriptorSet() {
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_ALL;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create uniform ring descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1};
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create uniform ring descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &descriptorSetLayout;
+    if (vkAllocateDescriptorSets(device.device(), &allocInfo, &set) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate uniform ring descriptor set!");
+    }
+
+    // the only descriptor write the ring ever does
+    VkDescriptorBufferInfo bufferInfo{buffer_, 0, range_};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+}
+
+void UniformRing::beginFrame(uint64_t frameIndex) {
+    highWater_ = std::max(highWater_, frameUsed());
+    frameBase = (frameIndex % framesInFlight) * frameSize;
+    head.store(0, std::memory_order_relaxed);
+}
+
+UniformRing::Allocation UniformRing::allocate(uint32_t size) {
+    if (size == 0 || size > range_) {
+        throw std::invalid_argument("uniform ring allocation larger than the descriptor range");
+    }
+    VkDeviceSize aligned = alignUp(size, alignment_);
+    VkDeviceSize offset = head.fetch_add(aligned, std::memory_order_relaxed);
+    if (offset + aligned > frameSize) {
+        throw std::runtime_error("uniform ring frame slice is full");
+    }
+    return {mapped + frameBase + offset, static_cast<uint32_t>(frameBase + offset)};
+}
+
+void UniformRing::bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t offset,
+                       VkPipelineBindPoint bindPoint) const {
+    vkCmdBindDescriptorSets(commandBuffer, bindPoint, layout, setIndex, 1, &set, 1, &offset);
+}
+
+VkDeviceSize UniformRing::frameUsed() const {
+    return std::min(head.load(std::memory_order_relaxed), frameSize);
+}
@@ -0,0 +1,99 @@
+#ifndef UNIFORM_RING_H
+#define UNIFORM_RING_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vulkan/vulkan_core.h>
+
+class Device;
+
+// Per-frame uniform data (camera, lights, per-object constants) in one
+// persistently mapped, host-coherent buffer split into framesInFlight slices.
+// Each frame bump-allocates from its own slice, so the CPU never writes memory
+// a frame still in flight is reading.
+//
+// The buffer is described once by a single VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+// descriptor at binding 0 of setLayout(); an allocation is selected purely by
+// the dynamic offset passed to bind(), so per-frame data costs no descriptor
+// writes and every object shares the same set:
+//
+//   layout (set = 1, binding = 0) uniform ObjectData { mat4 model; } object;
+//
+//   ring.beginFrame(frameIndex);                 // after waiting on that frame's fence
+//   uint32_t offset = ring.push(objectData);     // any thread
+//   ring.bind(commandBuffer, layout, 1, offset);
+class UniformRing {
+public:
+    struct Allocation {
+        void* data;
+        // dynamic offset for bind()
+        uint32_t offset;
+    };
+
+    // `bytesPerFrame` is rounded up to the device's minUniformBufferOffsetAlignment;
+    // `range` is the largest block a shader reads through the descriptor.
+    UniformRing(Device& device, VkDeviceSize bytesPerFrame, uint32_t framesInFlight = 2, uint32_t range = 256);
+    ~UniformRing();
+
+    UniformRing(const UniformRing&) = delete;
+    UniformRing& operator=(const UniformRing&) = delete;
+
+    // Switches to the slice of `frameIndex` and rewinds it. Call once the
+    // frame that last used the slice has completed.
+    void beginFrame(uint64_t frameIndex);
+
+    // Reserves `size` bytes (at most range()) aligned for use as a dynamic
+    // offset. Safe to call from any thread. Throws std::runtime_error when the
+    // frame's slice is full.
+    Allocation allocate(uint32_t size);
+
+    template<typename T>
+    uint32_t push(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Allocation allocation = allocate(sizeof(T));
+        std::memcpy(allocation.data, &value, sizeof(T));
+        return allocation.offset;
+    }
+
+    // Binds the ring's set at `setIndex` of `layout` with `offset` as its dynamic offset.
+    void bind(VkCommandBuffer commandBuffer, VkPipelineLayout layout, uint32_t setIndex, uint32_t offset,
+              VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const;
+
+    [[nodiscard]] VkDescriptorSetLayout setLayout() const { return descriptorSetLayout; }
+    [[nodiscard]] VkDescriptorSet descriptorSet() const { return set; }
+    [[nodiscard]] VkBuffer buffer() const { return buffer_; }
+    [[nodiscard]] VkDeviceSize alignment() const { return alignment_; }
+    [[nodiscard]] uint32_t range() const { return range_; }
+    [[nodiscard]] VkDeviceSize frameCapacity() const { return frameSize; }
+    // bytes allocated in the current frame, including alignment padding
+    [[nodiscard]] VkDeviceSize frameUsed() const;
+    // largest frameUsed() seen at a beginFrame()
+    [[nodiscard]] VkDeviceSize highWater() const { return highWater_; }
+
+private:
+    Device& device;
+    uint32_t framesInFlight;
+    uint32_t range_;
+    VkDeviceSize alignment_;
+    VkDeviceSize frameSize;
+
+    VkBuffer buffer_ = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    std::byte* mapped = nullptr;
+
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+
+    VkDeviceSize frameBase = 0;
+    // next free byte of the current slice, relative to frameBase
+    std::atomic<VkDeviceSize> head{0};
+    VkDeviceSize highWater_ = 0;
+
+    void createBuffer();
+    void createDescriptorSet();
+};
+
+#endif //UNIFORM_RING_H
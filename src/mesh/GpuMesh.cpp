@@ -0,0 +1,96 @@
+#include "GpuMesh.h"
+
+#include <algorithm>
+#include <span>
+#include <stdexcept>
+
+#include "MeshFile.h"
+#include "../device.h"
+
+namespace {
+    DeferredBuffer createFilled(Device& device, DeletionQueue& deletionQueue, std::span<const std::byte> data,
+                                VkBufferUsageFlags usage) {
+        VkBuffer buffer;
+        VkDeviceMemory memory;
+        device.createBuffer(data.size(), usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                            buffer, memory);
+        DeferredBuffer result{{deletionQueue, buffer}, {deletionQueue, memory}};
+        device.uploadBuffer(buffer, 0, data.data(), data.size());
+        return result;
+    }
+
+    GpuMesh upload(Device& device, DeletionQueue& deletionQueue, std::span<const std::byte> vertexData,
+                   std::span<const std::byte> indexData, std::span<const mesh_format::Attribute> attributes,
+                   const Bounds& bounds) {
+        if (vertexData.empty() || indexData.empty()) {
+            throw std::runtime_error("cannot upload an empty mesh!");
+        }
+
+        GpuMesh mesh;
+        mesh.vertices = createFilled(device, deletionQueue, vertexData, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        mesh.indices = createFilled(device, deletionQueue, indexData, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        mesh.attributes.assign(attributes.begin(), attributes.end());
+        mesh.bounds = bounds;
+
+        auto position = std::find_if(attributes.begin(), attributes.end(),
+                                     [](const mesh_format::Attribute& a) { return a.location == 0; });
+        if (position != attributes.end() && position->format == VK_FORMAT_R16G16B16A16_SNORM) {
+            mesh.positionOffset = bounds.center;
+            mesh.positionScale = bounds.extents;
+        }
+        auto normal = std::find_if(attributes.begin(), attributes.end(),
+                                   [](const mesh_format::Attribute& a) { return a.location == 1; });
+        mesh.octahedralNormals = normal != attributes.end() && normal->format == VK_FORMAT_R16G16_SNORM;
+        return mesh;
+    }
+}
+
+std::vector<float> GpuMesh::lodErrors() const {
+    std::vector<float> errors;
+    for (const mesh_format::Lod& lod: lods) {
+        errors.push_back(lod.error);
+    }
+    return errors;
+}
+
+DrawPacket GpuMesh::drawPacket(VkPipeline pipeline, uint32_t lod, uint32_t submesh) const {
+    if (lods.empty() || submeshCount == 0) {
+        throw std::runtime_error("mesh has no submeshes to draw!");
+    }
+    if (submesh >= submeshCount) {
+        throw std::out_of_range("submesh index is out of range!");
+    }
+    lod = std::min<uint32_t>(lod, static_cast<uint32_t>(lods.size()) - 1);
+    const mesh_format::Submesh& range = submeshes[size_t(lod) * submeshCount + submesh];
+    DrawPacket packet;
+    packet.pipeline = pipeline;
+    packet.vertexBuffer = vertices.buffer.get();
+    packet.indexBuffer = indices.buffer.get();
+    packet.indexType = indexType;
+    packet.count = range.indexCount;
+    packet.first = range.firstIndex;
+    return packet;
+}
+
+GpuMesh uploadMesh(Device& device, DeletionQueue& deletionQueue, const MeshFile& file) {
+    GpuMesh mesh = upload(device, deletionQueue, file.vertexData(), file.indexData(), file.attributes(), file.bounds());
+    mesh.indexType = file.indexType();
+    mesh.indexCount = file.header().indexCount;
+    mesh.vertexStride = file.header().vertexStride;
+    mesh.submeshes.assign(file.submeshes().begin(), file.submeshes().end());
+    mesh.submeshCount = file.header().submeshCount;
+    mesh.lods.assign(file.lods().begin(), file.lods().end());
+    return mesh;
+}
+
+GpuMesh uploadMesh(Device& device, DeletionQueue& deletionQueue, const MeshData& data) {
+    GpuMesh mesh = upload(device, deletionQueue, data.vertices, std::as_bytes(std::span(data.indices)), data.attributes,
+                          data.bounds);
+    mesh.indexType = VK_INDEX_TYPE_UINT32;
+    mesh.indexCount = static_cast<uint32_t>(data.indices.size());
+    mesh.vertexStride = data.vertexStride;
+    mesh.submeshes = data.submeshes;
+    mesh.lods = mesh_data::lods(data);
+    mesh.submeshCount = static_cast<uint32_t>(data.submeshes.size() / mesh.lods.size());
+    return mesh;
+}
@@ -0,0 +1,74 @@
+#ifndef GPU_MESH_H
+#define GPU_MESH_H
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "MeshData.h"
+#include "MeshFormat.h"
+#include "../draw/DrawQueue.h"
+#include "../math/Math.h"
+#include "../memory/DeletionQueue.h"
+
+class Device;
+class MeshFile;
+
+// The push constants of shader.vert, after bindless.glsl's DrawConstants:
+// push sizeof(MeshConstants) bytes at MeshConstants::offset.
+struct MeshConstants {
+    static constexpr uint32_t offset = 16;
+
+    // clip from object space
+    Mat4 transform;
+    // object-space position = positionOffset.xyz + decoded position * positionScale.xyz
+    float positionOffset[4];
+    // w is 1 when normals are octahedral encoded and 0 when they are float xyz
+    float positionScale[4];
+};
+
+static_assert(sizeof(MeshConstants) == 96, "keep in sync with shader.vert");
+
+// Device-local vertex and index buffers of one mesh, with what a pipeline
+// needs to read them.
+struct GpuMesh {
+    DeferredBuffer vertices;
+    DeferredBuffer indices;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    uint32_t indexCount = 0;
+    uint32_t vertexStride = 0;
+    std::vector<mesh_format::Attribute> attributes;
+    // submeshCount per LOD, LOD after LOD
+    std::vector<mesh_format::Submesh> submeshes;
+    uint32_t submeshCount = 0;
+    std::vector<mesh_format::Lod> lods;
+    // object space
+    Bounds bounds;
+    // position dequantization; identity unless positions are SNORM
+    Vec3 positionOffset;
+    Vec3 positionScale{1.0f, 1.0f, 1.0f};
+    // two-component normals (QuantizedVertex) rather than float xyz (StandardVertex)
+    bool octahedralNormals = false;
+
+    [[nodiscard]] MeshConstants constants(const Mat4& transform) const {
+        return {transform,
+                {positionOffset.x, positionOffset.y, positionOffset.z, 0.0f},
+                {positionScale.x, positionScale.y, positionScale.z, octahedralNormals ? 1.0f : 0.0f}};
+    }
+
+    // LOD errors finest first, for LodSelector::setMeshLods() along with length(bounds.extents).
+    [[nodiscard]] std::vector<float> lodErrors() const;
+
+    // The draw of one submesh at a level of detail (clamped to the coarsest).
+    // Throws if the mesh has no submeshes or `submesh` is not below submeshCount.
+    [[nodiscard]] DrawPacket drawPacket(VkPipeline pipeline, uint32_t lod, uint32_t submesh = 0) const;
+};
+
+// Creates the buffers and copies the file's vertex and index blocks into them
+// directly from the mapping; blocks until the transfer completes. The buffers
+// are retired through `deletionQueue` when the GpuMesh is dropped.
+GpuMesh uploadMesh(Device& device, DeletionQueue& deletionQueue, const MeshFile& file);
+// The same for a mesh built in memory, with 32-bit indices.
+GpuMesh uploadMesh(Device& device, DeletionQueue& deletionQueue, const MeshData& mesh);
+
+#endif //GPU_MESH_H
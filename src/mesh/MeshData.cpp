@@ -0,0 +1,131 @@
+#include "MeshData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    int16_t snorm16(float value) {
+        return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    // IEEE half with round to nearest even; out of range values become infinity.
+    uint16_t half(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        if (magnitude >= 0x7F800000) {
+            return static_cast<uint16_t>(sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00));
+        }
+        if (magnitude >= 0x477FF000) {
+            return static_cast<uint16_t>(sign | 0x7C00);
+        }
+        if (magnitude < 0x38800000) {
+            // subnormal: units of 2^-24
+            return static_cast<uint16_t>(sign | static_cast<uint32_t>(std::nearbyint(std::fabs(value) * 16777216.0f)));
+        }
+        uint32_t rounded = magnitude + 0x0FFF + ((magnitude >> 13) & 1);
+        return static_cast<uint16_t>(sign | ((rounded - 0x38000000) >> 13));
+    }
+
+    // Projects the unit sphere onto an octahedron and unfolds it into [-1, 1]^2.
+    void octahedral(const float normal[3], int16_t out[2]) {
+        float length = std::fabs(normal[0]) + std::fabs(normal[1]) + std::fabs(normal[2]);
+        if (length == 0.0f) {
+            out[0] = out[1] = 0;
+            return;
+        }
+        float x = normal[0] / length;
+        float y = normal[1] / length;
+        if (normal[2] < 0.0f) {
+            float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+            float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+            x = foldedX;
+            y = foldedY;
+        }
+        out[0] = snorm16(x);
+        out[1] = snorm16(y);
+    }
+}
+
+namespace mesh_data {
+    std::vector<mesh_format::Attribute> standardAttributes() {
+        return {
+            {0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(StandardVertex, position)},
+            {1, VK_FORMAT_R32G32B32_SFLOAT, offsetof(StandardVertex, normal)},
+            {2, VK_FORMAT_R32G32_SFLOAT, offsetof(StandardVertex, uv)},
+        };
+    }
+
+    std::vector<mesh_format::Attribute> quantizedAttributes() {
+        return {
+            {0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(QuantizedVertex, position)},
+            {1, VK_FORMAT_R16G16_SNORM, offsetof(QuantizedVertex, normal)},
+            {2, VK_FORMAT_R16G16_SFLOAT, offsetof(QuantizedVertex, uv)},
+        };
+    }
+
+    std::vector<mesh_format::Lod> lods(const MeshData& mesh) {
+        if (!mesh.lods.empty()) {
+            return mesh.lods;
+        }
+        return {{0, static_cast<uint32_t>(mesh.indices.size()), 0.0f}};
+    }
+
+    std::vector<Vec3> positions(const MeshData& mesh) {
+        auto position = std::find_if(mesh.attributes.begin(), mesh.attributes.end(),
+                                     [](const mesh_format::Attribute& a) { return a.location == 0; });
+        if (position == mesh.attributes.end() || position->format != VK_FORMAT_R32G32B32_SFLOAT) {
+            throw std::invalid_argument("mesh has no float positions at location 0");
+        }
+        std::vector<Vec3> result(mesh.vertexCount);
+        for (uint32_t vertex = 0; vertex < mesh.vertexCount; vertex++) {
+            std::memcpy(&result[vertex], mesh.vertices.data() + size_t(vertex) * mesh.vertexStride + position->offset,
+                        sizeof(Vec3));
+        }
+        return result;
+    }
+
+    MeshData quantize(const MeshData& mesh) {
+        if (!isStandard(mesh)) {
+            throw std::invalid_argument("quantize expects a mesh in the standard vertex layout");
+        }
+
+        MeshData result;
+        result.attributes = quantizedAttributes();
+        result.vertexStride = sizeof(QuantizedVertex);
+        result.vertexCount = mesh.vertexCount;
+        result.vertices.resize(size_t(mesh.vertexCount) * sizeof(QuantizedVertex));
+        result.indices = mesh.indices;
+        result.submeshes = mesh.submeshes;
+        result.lods = mesh.lods;
+        result.materials = mesh.materials;
+        result.bounds = mesh.bounds;
+
+        const float center[3] = {mesh.bounds.center.x, mesh.bounds.center.y, mesh.bounds.center.z};
+        const float extents[3] = {mesh.bounds.extents.x, mesh.bounds.extents.y, mesh.bounds.extents.z};
+        float inverseExtents[3];
+        for (int axis = 0; axis < 3; axis++) {
+            inverseExtents[axis] = extents[axis] > 0.0f ? 1.0f / extents[axis] : 0.0f;
+        }
+
+        for (uint32_t i = 0; i < mesh.vertexCount; i++) {
+            StandardVertex in;
+            std::memcpy(&in, mesh.vertices.data() + size_t(i) * sizeof(StandardVertex), sizeof(in));
+            QuantizedVertex out;
+            for (int axis = 0; axis < 3; axis++) {
+                out.position[axis] = snorm16((in.position[axis] - center[axis]) * inverseExtents[axis]);
+            }
+            out.position[3] = 32767;
+            octahedral(in.normal, out.normal);
+            out.uv[0] = half(in.uv[0]);
+            out.uv[1] = half(in.uv[1]);
+            std::memcpy(result.vertices.data() + size_t(i) * sizeof(QuantizedVertex), &out, sizeof(out));
+        }
+        return result;
+    }
+}
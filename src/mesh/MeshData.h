@@ -0,0 +1,73 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "MeshFormat.h"
+#include "../math/Math.h"
+
+// A mesh in memory, in the same interleaved layout the packed format stores:
+// what the OBJ loader produces and MeshFile::write() consumes.
+struct MeshData {
+    std::vector<mesh_format::Attribute> attributes;
+    uint32_t vertexStride = 0;
+    uint32_t vertexCount = 0;
+    std::vector<std::byte> vertices;
+    std::vector<uint32_t> indices;
+    // LOD after LOD when `lods` is set, see MeshFormat.h
+    std::vector<mesh_format::Submesh> submeshes;
+    // empty for a mesh that is only its LOD 0
+    std::vector<mesh_format::Lod> lods;
+    // names of the materials the submeshes refer to, by index
+    std::vector<std::string> materials;
+    Bounds bounds;
+};
+
+// The layout produced by the loaders: float position, normal and texture
+// coordinate at locations 0, 1 and 2.
+struct StandardVertex {
+    float position[3];
+    float normal[3];
+    float uv[2];
+};
+
+// The layout of quantize(), 16 bytes against StandardVertex's 32:
+//   position  R16G16B16A16_SNORM relative to the mesh bounds, decoded as
+//             center + position.xyz * extents (w is always 1)
+//   normal    R16G16_SNORM octahedral encoding
+//   uv        R16G16_SFLOAT
+struct QuantizedVertex {
+    int16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+};
+
+namespace mesh_data {
+    std::vector<mesh_format::Attribute> standardAttributes();
+    std::vector<mesh_format::Attribute> quantizedAttributes();
+
+    // The LODs of `mesh`, with a LOD 0 over every index when it has none.
+    std::vector<mesh_format::Lod> lods(const MeshData& mesh);
+
+    // Float positions at location 0, one per vertex. Throws
+    // std::invalid_argument when the layout has none.
+    std::vector<Vec3> positions(const MeshData& mesh);
+
+    // Re-encodes a mesh in the standard layout as QuantizedVertex. Indices,
+    // submeshes and bounds are kept; the bounds become the position
+    // dequantization parameters. Throws std::invalid_argument for any other layout.
+    MeshData quantize(const MeshData& mesh);
+
+    [[nodiscard]] inline bool isStandard(const MeshData& mesh) {
+        return mesh.vertexStride == sizeof(StandardVertex) && mesh.attributes.size() == 3 &&
+               mesh.attributes[0].format == VK_FORMAT_R32G32B32_SFLOAT &&
+               mesh.attributes[1].format == VK_FORMAT_R32G32B32_SFLOAT &&
+               mesh.attributes[2].format == VK_FORMAT_R32G32_SFLOAT;
+    }
+}
+
+#endif //MESH_DATA_H
@@ -0,0 +1,157 @@
+#include "MeshFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    uint64_t alignUp(uint64_t value) {
+        return (value + mesh_format::blockAlignment - 1) / mesh_format::blockAlignment * mesh_format::blockAlignment;
+    }
+
+    template<typename T>
+    std::span<const T> block(std::span<const std::byte> file, uint64_t offset, uint64_t size, const char* what) {
+        if (offset > file.size() || size > file.size() - offset || offset % alignof(T) != 0 || size % sizeof(T) != 0) {
+            throw std::runtime_error(std::string("mesh file has a bad ") + what + " block!");
+        }
+        return {reinterpret_cast<const T*>(file.data() + offset), static_cast<size_t>(size / sizeof(T))};
+    }
+}
+
+MeshFile::MeshFile(const std::string& filename) : file(filename) {
+    std::span<const std::byte> bytes = file.bytes();
+    if (bytes.size() < sizeof(mesh_format::FileHeader)) {
+        throw std::runtime_error("mesh file is truncated!");
+    }
+    header_ = reinterpret_cast<const mesh_format::FileHeader*>(bytes.data());
+    if (header_->magic != mesh_format::magic) {
+        throw std::runtime_error("not a packed mesh file!");
+    }
+    if (header_->version != mesh_format::version) {
+        throw std::runtime_error("packed mesh version mismatch; re-run meshpack!");
+    }
+
+    attributes_ = block<mesh_format::Attribute>(bytes, header_->attributesOffset,
+                                                uint64_t(header_->attributeCount) * sizeof(mesh_format::Attribute),
+                                                "attribute");
+    if (header_->lodCount == 0) {
+        throw std::runtime_error("mesh file has no LODs!");
+    }
+    submeshes_ = block<mesh_format::Submesh>(bytes, header_->submeshesOffset,
+                                             uint64_t(header_->submeshCount) * header_->lodCount *
+                                                 sizeof(mesh_format::Submesh),
+                                             "submesh");
+    lods_ = block<mesh_format::Lod>(bytes, header_->lodsOffset, uint64_t(header_->lodCount) * sizeof(mesh_format::Lod),
+                                    "LOD");
+    materialNames_ = block<char>(bytes, header_->materialNamesOffset, header_->materialNamesSize, "material name");
+    vertexData_ = block<std::byte>(bytes, header_->vertexOffset, header_->vertexSize, "vertex");
+    indexData_ = block<std::byte>(bytes, header_->indexOffset, header_->indexSize, "index");
+
+    uint64_t indexSize = header_->indexType == VK_INDEX_TYPE_UINT16 ? 2 : header_->indexType == VK_INDEX_TYPE_UINT32 ? 4 : 0;
+    if (indexSize == 0 || header_->indexSize != uint64_t(header_->indexCount) * indexSize ||
+        header_->vertexSize != uint64_t(header_->vertexCount) * header_->vertexStride) {
+        throw std::runtime_error("mesh file block sizes do not match its counts!");
+    }
+    for (const mesh_format::Submesh& submesh: submeshes_) {
+        if (submesh.firstIndex > header_->indexCount || submesh.indexCount > header_->indexCount - submesh.firstIndex) {
+            throw std::runtime_error("mesh file submesh is out of range!");
+        }
+    }
+    for (const mesh_format::Lod& lod: lods_) {
+        if (lod.firstIndex > header_->indexCount || lod.indexCount > header_->indexCount - lod.firstIndex) {
+            throw std::runtime_error("mesh file LOD is out of range!");
+        }
+    }
+    for (const mesh_format::Attribute& attribute: attributes_) {
+        if (attribute.offset >= header_->vertexStride) {
+            throw std::runtime_error("mesh file attribute lies outside the vertex!");
+        }
+    }
+}
+
+Bounds MeshFile::bounds() const {
+    const float* c = header_->boundsCenter;
+    const float* e = header_->boundsExtents;
+    return {{c[0], c[1], c[2]}, {e[0], e[1], e[2]}};
+}
+
+std::vector<std::string_view> MeshFile::materialNames() const {
+    std::vector<std::string_view> names;
+    size_t start = 0;
+    for (size_t i = 0; i < materialNames_.size(); i++) {
+        if (materialNames_[i] == '\0') {
+            names.emplace_back(materialNames_.data() + start, i - start);
+            start = i + 1;
+        }
+    }
+    return names;
+}
+
+void MeshFile::write(const std::string& filename, const MeshData& mesh) {
+    if (mesh.vertices.size() != uint64_t(mesh.vertexCount) * mesh.vertexStride) {
+        throw std::invalid_argument("mesh vertex data does not match vertexCount * vertexStride");
+    }
+
+    std::vector<mesh_format::Lod> lods = mesh_data::lods(mesh);
+    if (mesh.submeshes.size() % lods.size() != 0) {
+        throw std::invalid_argument("every mesh LOD needs the same number of submeshes");
+    }
+
+    bool shortIndices = mesh.vertexCount <= 65536;
+    std::string names;
+    for (const std::string& name: mesh.materials) {
+        names += name;
+        names += '\0';
+    }
+
+    mesh_format::FileHeader header{};
+    header.magic = mesh_format::magic;
+    header.version = mesh_format::version;
+    header.vertexCount = mesh.vertexCount;
+    header.vertexStride = mesh.vertexStride;
+    header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    header.indexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    header.attributeCount = static_cast<uint32_t>(mesh.attributes.size());
+    header.submeshCount = static_cast<uint32_t>(mesh.submeshes.size() / lods.size());
+    header.lodCount = static_cast<uint32_t>(lods.size());
+    header.boundsCenter[0] = mesh.bounds.center.x;
+    header.boundsCenter[1] = mesh.bounds.center.y;
+    header.boundsCenter[2] = mesh.bounds.center.z;
+    header.boundsExtents[0] = mesh.bounds.extents.x;
+    header.boundsExtents[1] = mesh.bounds.extents.y;
+    header.boundsExtents[2] = mesh.bounds.extents.z;
+
+    header.attributesOffset = alignUp(sizeof(header));
+    header.submeshesOffset = alignUp(header.attributesOffset + mesh.attributes.size() * sizeof(mesh_format::Attribute));
+    header.lodsOffset = alignUp(header.submeshesOffset + mesh.submeshes.size() * sizeof(mesh_format::Submesh));
+    header.materialNamesOffset = alignUp(header.lodsOffset + lods.size() * sizeof(mesh_format::Lod));
+    header.materialNamesSize = names.size();
+    header.vertexOffset = alignUp(header.materialNamesOffset + names.size());
+    header.vertexSize = mesh.vertices.size();
+    header.indexOffset = alignUp(header.vertexOffset + header.vertexSize);
+    header.indexSize = uint64_t(header.indexCount) * (shortIndices ? 2 : 4);
+
+    std::vector<std::byte> out(header.indexOffset + header.indexSize);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + header.attributesOffset, mesh.attributes.data(),
+                mesh.attributes.size() * sizeof(mesh_format::Attribute));
+    std::memcpy(out.data() + header.submeshesOffset, mesh.submeshes.data(),
+                mesh.submeshes.size() * sizeof(mesh_format::Submesh));
+    std::memcpy(out.data() + header.lodsOffset, lods.data(), lods.size() * sizeof(mesh_format::Lod));
+    std::memcpy(out.data() + header.materialNamesOffset, names.data(), names.size());
+    std::memcpy(out.data() + header.vertexOffset, mesh.vertices.data(), mesh.vertices.size());
+    if (shortIndices) {
+        auto* indices = reinterpret_cast<uint16_t*>(out.data() + header.indexOffset);
+        for (size_t i = 0; i < mesh.indices.size(); i++) {
+            indices[i] = static_cast<uint16_t>(mesh.indices[i]);
+        }
+    } else {
+        std::memcpy(out.data() + header.indexOffset, mesh.indices.data(), header.indexSize);
+    }
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file) {
+        throw std::runtime_error("failed to write mesh file!");
+    }
+}
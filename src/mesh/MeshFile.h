@@ -0,0 +1,51 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "MeshData.h"
+#include "MeshFormat.h"
+#include "../files.h"
+
+// Memory-mapped view of a packed mesh (see MeshFormat.h). Opening validates
+// the header and block bounds and nothing else: the vertex and index spans
+// point into the mapping, ready to be copied into a staging buffer.
+class MeshFile {
+public:
+    // Throws std::runtime_error if the file is not a valid packed mesh of this version.
+    explicit MeshFile(const std::string& filename);
+
+    [[nodiscard]] const mesh_format::FileHeader& header() const { return *header_; }
+    [[nodiscard]] std::span<const mesh_format::Attribute> attributes() const { return attributes_; }
+    // every LOD's submeshes, LOD after LOD
+    [[nodiscard]] std::span<const mesh_format::Submesh> submeshes() const { return submeshes_; }
+    [[nodiscard]] std::span<const mesh_format::Submesh> submeshes(uint32_t lod) const {
+        return submeshes_.subspan(size_t(lod) * header_->submeshCount, header_->submeshCount);
+    }
+    [[nodiscard]] std::span<const mesh_format::Lod> lods() const { return lods_; }
+    [[nodiscard]] std::span<const std::byte> vertexData() const { return vertexData_; }
+    [[nodiscard]] std::span<const std::byte> indexData() const { return indexData_; }
+    [[nodiscard]] VkIndexType indexType() const { return static_cast<VkIndexType>(header_->indexType); }
+    [[nodiscard]] Bounds bounds() const;
+    [[nodiscard]] std::vector<std::string_view> materialNames() const;
+
+    // Packs `mesh`, with 16-bit indices when every vertex index fits.
+    static void write(const std::string& filename, const MeshData& mesh);
+
+private:
+    utils::MappedFile file;
+    const mesh_format::FileHeader* header_ = nullptr;
+    std::span<const mesh_format::Attribute> attributes_;
+    std::span<const mesh_format::Submesh> submeshes_;
+    std::span<const mesh_format::Lod> lods_;
+    std::span<const char> materialNames_;
+    std::span<const std::byte> vertexData_;
+    std::span<const std::byte> indexData_;
+};
+
+#endif //MESH_FILE_H
@@ -0,0 +1,81 @@
+#ifndef MESH_FORMAT_H
+#define MESH_FORMAT_H
+
+#include <cstdint>
+
+// On-disk layout of a packed mesh (.vmesh), written offline by meshpack:
+//
+//   FileHeader | Attribute[attributeCount] | Submesh[submeshCount * lodCount] | Lod[lodCount]
+//              | material names | vertices | indices
+//
+// LODs share the vertex block and each own a range of the index block. LOD 0
+// is the full mesh; every LOD has its own submeshCount submeshes, stored LOD
+// after LOD, so submesh s of LOD l is Submesh[l * submeshCount + s].
+//
+// Every block starts on a blockAlignment boundary and the vertex and index
+// blocks are exactly what the GPU buffers hold, so loading is a memory map, a
+// header check and a copy into staging memory. Structs are raw host-endian;
+// bump `version` whenever one of them or the meaning of a field changes.
+namespace mesh_format {
+    constexpr uint32_t magic = 0x48534D56; // "VMSH"
+    constexpr uint32_t version = 2;
+    constexpr uint64_t blockAlignment = 64;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vertexCount;
+        uint32_t vertexStride;
+        uint32_t indexCount;
+        // VkIndexType
+        uint32_t indexType;
+        uint32_t attributeCount;
+        // submeshes per LOD
+        uint32_t submeshCount;
+        uint32_t lodCount;
+        uint32_t reserved;
+        // object-space bounds as center and half extents; SNORM positions
+        // (QuantizedVertex) decode to center + position * extents
+        float boundsCenter[3];
+        float boundsExtents[3];
+        uint64_t attributesOffset;
+        uint64_t submeshesOffset;
+        uint64_t lodsOffset;
+        uint64_t vertexOffset;
+        uint64_t vertexSize;
+        uint64_t indexOffset;
+        uint64_t indexSize;
+        // NUL-terminated names of the materials Submesh::material refers to
+        uint64_t materialNamesOffset;
+        uint64_t materialNamesSize;
+    };
+
+    // One vertex input attribute of the interleaved vertex block.
+    struct Attribute {
+        uint32_t location;
+        // VkFormat
+        uint32_t format;
+        uint32_t offset;
+    };
+
+    // A range of the index block drawn with one material.
+    struct Submesh {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t material;
+    };
+
+    // One level of detail, coarser as the index grows.
+    struct Lod {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        // object-space distance the simplified surface may lie from the
+        // original; 0 for LOD 0
+        float error;
+    };
+
+    static_assert(sizeof(FileHeader) == 136, "mesh header layout changed; bump the version");
+    static_assert(sizeof(Attribute) == 12 && sizeof(Submesh) == 12 && sizeof(Lod) == 12);
+}
+
+#endif //MESH_FORMAT_H
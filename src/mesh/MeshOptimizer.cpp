@@ -0,0 +1,297 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    // Forsyth's scoring; the modeled cache is LRU and larger than any real one
+    constexpr uint32_t scoreCacheSize = 32;
+    constexpr float cacheDecayPower = 1.5f;
+    constexpr float lastTriangleScore = 0.75f;
+    constexpr float valenceBoostScale = 2.0f;
+    constexpr float valenceBoostPower = 0.5f;
+    // the cache size used when cutting clusters for overdraw
+    constexpr uint32_t clusterCacheSize = 16;
+
+    float vertexScore(int32_t cachePosition, uint32_t remaining) {
+        if (remaining == 0) {
+            return -1.0f;
+        }
+        float score = 0.0f;
+        if (cachePosition >= 0) {
+            if (cachePosition < 3) {
+                score = lastTriangleScore;
+            } else {
+                float scale = 1.0f / static_cast<float>(scoreCacheSize - 3);
+                score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, cacheDecayPower);
+            }
+        }
+        return score + valenceBoostScale * std::pow(static_cast<float>(remaining), -valenceBoostPower);
+    }
+
+    // Counts FIFO cache misses of each triangle, from a cold cache at index 0.
+    class FifoCache {
+    public:
+        FifoCache(uint32_t vertexCount, uint32_t size) : stamps(vertexCount, 0), size(size), time(size + 1) {}
+
+        uint32_t triangleMisses(const uint32_t* triangle) {
+            uint32_t misses = 0;
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t& stamp = stamps[triangle[corner]];
+                if (time - stamp >= size) {
+                    stamp = time++;
+                    misses++;
+                }
+            }
+            return misses;
+        }
+
+        // Invalidates every entry in O(1).
+        void flush() { time += size; }
+
+    private:
+        std::vector<uint32_t> stamps;
+        uint32_t size;
+        // starts past `size` so a zero stamp always reads as a miss
+        uint32_t time;
+    };
+}
+
+namespace mesh_optimizer {
+    CacheStats analyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize) {
+        CacheStats stats;
+        if (indices.size() < 3) {
+            return stats;
+        }
+        std::vector<uint32_t> stamps(vertexCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        // starts past cacheSize so a zero stamp always reads as a miss
+        uint32_t time = cacheSize + 1;
+        uint32_t misses = 0;
+        uint32_t unique = 0;
+        for (uint32_t index: indices) {
+            if (time - stamps[index] >= cacheSize) {
+                stamps[index] = time++;
+                misses++;
+            }
+            if (!referenced[index]) {
+                referenced[index] = true;
+                unique++;
+            }
+        }
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(unique);
+        return stats;
+    }
+
+    void optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount) {
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        if (triangleCount == 0) {
+            return;
+        }
+
+        // triangles of each vertex; the first `remaining` of a vertex's slots are the unemitted ones
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for (uint32_t index: indices) {
+            remaining[index]++;
+        }
+        std::vector<uint32_t> firstTriangle(vertexCount + 1, 0);
+        std::partial_sum(remaining.begin(), remaining.end(), firstTriangle.begin() + 1);
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> filled(vertexCount, 0);
+        for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t vertex = indices[triangle * 3 + corner];
+                adjacency[firstTriangle[vertex] + filled[vertex]++] = triangle;
+            }
+        }
+
+        std::vector<int32_t> cachePosition(vertexCount, -1);
+        std::vector<float> score(vertexCount);
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++) {
+            score[vertex] = vertexScore(-1, remaining[vertex]);
+        }
+
+        std::vector<uint32_t> source(indices.begin(), indices.end());
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<uint32_t> cache, nextCache;
+        cache.reserve(scoreCacheSize + 3);
+        nextCache.reserve(scoreCacheSize + 3);
+
+        uint32_t scanCursor = 0;
+        int64_t best = -1;
+        for (uint32_t output = 0; output < triangleCount; output++) {
+            if (best < 0) {
+                // nothing in the cache has triangles left: restart at the first unemitted triangle
+                while (emitted[scanCursor]) {
+                    scanCursor++;
+                }
+                best = scanCursor;
+            }
+
+            uint32_t triangle = static_cast<uint32_t>(best);
+            const uint32_t* t = &source[triangle * 3];
+            std::memcpy(&indices[output * 3], t, 3 * sizeof(uint32_t));
+            emitted[triangle] = true;
+
+            for (int corner = 0; corner < 3; corner++) {
+                uint32_t vertex = t[corner];
+                uint32_t* slots = &adjacency[firstTriangle[vertex]];
+                uint32_t* slot = std::find(slots, slots + remaining[vertex], triangle);
+                std::swap(*slot, slots[--remaining[vertex]]);
+            }
+
+            nextCache.assign(t, t + 3);
+            for (uint32_t vertex: cache) {
+                if (vertex != t[0] && vertex != t[1] && vertex != t[2]) {
+                    nextCache.push_back(vertex);
+                }
+            }
+            for (size_t position = scoreCacheSize; position < nextCache.size(); position++) {
+                cachePosition[nextCache[position]] = -1;
+                score[nextCache[position]] = vertexScore(-1, remaining[nextCache[position]]);
+            }
+            nextCache.resize(std::min<size_t>(nextCache.size(), scoreCacheSize));
+            for (size_t position = 0; position < nextCache.size(); position++) {
+                uint32_t vertex = nextCache[position];
+                cachePosition[vertex] = static_cast<int32_t>(position);
+                score[vertex] = vertexScore(static_cast<int32_t>(position), remaining[vertex]);
+            }
+
+            // only triangles touching the cache changed score, and the best next one is among them
+            best = -1;
+            float bestScore = -1.0f;
+            for (uint32_t vertex: nextCache) {
+                const uint32_t* slots = &adjacency[firstTriangle[vertex]];
+                for (uint32_t i = 0; i < remaining[vertex]; i++) {
+                    uint32_t candidate = slots[i];
+                    const uint32_t* c = &source[candidate * 3];
+                    float candidateScore = score[c[0]] + score[c[1]] + score[c[2]];
+                    if (candidateScore > bestScore) {
+                        bestScore = candidateScore;
+                        best = candidate;
+                    }
+                }
+            }
+            std::swap(cache, nextCache);
+        }
+    }
+
+    void optimizeOverdraw(std::span<uint32_t> indices, std::span<const Vec3> positions, float threshold) {
+        const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+        const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+        if (triangleCount < 2) {
+            return;
+        }
+
+        float targetAcmr = analyzeVertexCache(indices, vertexCount, clusterCacheSize).acmr * threshold;
+
+        // Cut where the cache empties by itself (all three corners miss) and
+        // wherever the cluster so far, replayed from a cold cache, is within
+        // the target; either way the cut costs little cache efficiency.
+        std::vector<uint32_t> clusterStarts{0};
+        FifoCache cache(vertexCount, clusterCacheSize);
+        uint32_t clusterMisses = 0;
+        for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+            uint32_t misses = cache.triangleMisses(&indices[triangle * 3]);
+            uint32_t clusterSize = triangle - clusterStarts.back();
+            if (misses == 3 && clusterSize > 0) {
+                clusterStarts.push_back(triangle);
+                clusterMisses = misses;
+                continue;
+            }
+            clusterMisses += misses;
+            if (static_cast<float>(clusterMisses) <= targetAcmr * static_cast<float>(clusterSize + 1) &&
+                triangle + 1 < triangleCount) {
+                clusterStarts.push_back(triangle + 1);
+                clusterMisses = 0;
+                cache.flush();
+            }
+        }
+        clusterStarts.push_back(triangleCount);
+        size_t clusterCount = clusterStarts.size() - 1;
+        if (clusterCount < 2) {
+            return;
+        }
+
+        // area-weighted centroid and normal of each cluster and of the mesh
+        std::vector<Vec3> centroids(clusterCount);
+        std::vector<Vec3> normals(clusterCount);
+        Vec3 meshCentroid;
+        float meshArea = 0.0f;
+        for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+            Vec3 centroid, normal;
+            float area = 0.0f;
+            for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++) {
+                Vec3 a = positions[indices[triangle * 3]];
+                Vec3 b = positions[indices[triangle * 3 + 1]];
+                Vec3 c = positions[indices[triangle * 3 + 2]];
+                Vec3 n = cross(b - a, c - a);
+                float triangleArea = length(n);
+                centroid = centroid + (a + b + c) * (triangleArea / 3.0f);
+                normal = normal + n;
+                area += triangleArea;
+            }
+            meshCentroid = meshCentroid + centroid;
+            meshArea += area;
+            centroids[cluster] = area > 0.0f ? centroid * (1.0f / area) : centroid;
+            float normalLength = length(normal);
+            normals[cluster] = normalLength > 0.0f ? normal * (1.0f / normalLength) : normal;
+        }
+        meshCentroid = meshArea > 0.0f ? meshCentroid * (1.0f / meshArea) : meshCentroid;
+
+        std::vector<float> keys(clusterCount);
+        for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+            keys[cluster] = dot(centroids[cluster] - meshCentroid, normals[cluster]);
+        }
+        std::vector<uint32_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+        std::vector<uint32_t> source(indices.begin(), indices.end());
+        uint32_t* out = indices.data();
+        for (uint32_t cluster: order) {
+            uint32_t begin = clusterStarts[cluster] * 3;
+            uint32_t end = clusterStarts[cluster + 1] * 3;
+            out = std::copy(source.begin() + begin, source.begin() + end, out);
+        }
+    }
+
+    void optimizeVertexFetch(MeshData& mesh) {
+        constexpr uint32_t unused = ~0u;
+        std::vector<uint32_t> remap(mesh.vertexCount, unused);
+        uint32_t next = 0;
+        for (uint32_t& index: mesh.indices) {
+            if (remap[index] == unused) {
+                remap[index] = next++;
+            }
+            index = remap[index];
+        }
+
+        std::vector<std::byte> vertices(size_t(next) * mesh.vertexStride);
+        for (uint32_t vertex = 0; vertex < mesh.vertexCount; vertex++) {
+            if (remap[vertex] != unused) {
+                std::memcpy(vertices.data() + size_t(remap[vertex]) * mesh.vertexStride,
+                            mesh.vertices.data() + size_t(vertex) * mesh.vertexStride, mesh.vertexStride);
+            }
+        }
+        mesh.vertices = std::move(vertices);
+        mesh.vertexCount = next;
+    }
+
+    void optimize(MeshData& mesh, float overdrawThreshold) {
+        std::vector<Vec3> positions = mesh_data::positions(mesh);
+
+        // submeshes (of every LOD) draw separately, so each is ordered on its own
+        for (const mesh_format::Submesh& submesh: mesh.submeshes) {
+            std::span<uint32_t> indices(mesh.indices.data() + submesh.firstIndex, submesh.indexCount);
+            optimizeVertexCache(indices, mesh.vertexCount);
+            optimizeOverdraw(indices, positions, overdrawThreshold);
+        }
+        optimizeVertexFetch(mesh);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstdint>
+#include <span>
+
+#include "MeshData.h"
+#include "../math/Math.h"
+
+// Index and vertex reordering for the import path. Each pass only permutes
+// triangles or vertices; the rendered result is unchanged.
+namespace mesh_optimizer {
+    struct CacheStats {
+        // average cache misses per triangle: 3 is no reuse, about 0.5 is the
+        // practical floor for regular meshes
+        float acmr = 0.0f;
+        // average cache misses per referenced vertex: 1 is ideal
+        float atvr = 0.0f;
+    };
+
+    // Simulates a FIFO post-transform cache of `cacheSize` vertices.
+    CacheStats analyzeVertexCache(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t cacheSize = 16);
+
+    // Reorders triangles for post-transform cache reuse (Forsyth's linear-speed
+    // algorithm, which does not depend on the exact cache size).
+    void optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount);
+
+    // Splits cache-optimized triangles into clusters where the cache restarts
+    // anyway, or where cutting costs at most `threshold` times the current
+    // ACMR, and orders the clusters so outward-facing ones on the outside of
+    // the mesh draw first and occlude the rest.
+    void optimizeOverdraw(std::span<uint32_t> indices, std::span<const Vec3> positions, float threshold = 1.05f);
+
+    // Renumbers vertices in order of first use so vertex fetch walks memory
+    // forward; vertices no triangle references are dropped.
+    void optimizeVertexFetch(MeshData& mesh);
+
+    // All three passes, per submesh of every LOD. Requires float positions at location 0.
+    void optimize(MeshData& mesh, float overdrawThreshold = 1.05f);
+}
+
+#endif //MESH_OPTIMIZER_H
@@ -0,0 +1,300 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    // Sum of squared distances to a set of area-weighted planes, as the
+    // upper triangle of a symmetric 4x4 matrix, plus the total weight so the
+    // error can be read back as a distance.
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+        double weight = 0;
+
+        static Quadric plane(Vec3 normal, float distance, float weight) {
+            double a = normal.x, b = normal.y, c = normal.z, d = distance, w = weight;
+            return {w * a * a, w * a * b, w * a * c, w * a * d,
+                    w * b * b, w * b * c, w * b * d,
+                    w * c * c, w * c * d,
+                    w * d * d, w};
+        }
+
+        Quadric& operator+=(const Quadric& q) {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+            a11 += q.a11; a12 += q.a12; a13 += q.a13;
+            a22 += q.a22; a23 += q.a23;
+            a33 += q.a33;
+            weight += q.weight;
+            return *this;
+        }
+
+        // mean squared distance of `p` to the planes
+        [[nodiscard]] double error(Vec3 p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double sum = x * (a00 * x + 2 * (a01 * y + a02 * z + a03)) +
+                         y * (a11 * y + 2 * (a12 * z + a13)) +
+                         z * (a22 * z + 2 * a23) + a33;
+            return weight > 0 ? std::max(sum, 0.0) / weight : 0.0;
+        }
+    };
+
+    struct Collapse {
+        uint32_t from;
+        uint32_t to;
+        double cost;
+    };
+
+    struct PositionHash {
+        size_t operator()(const Vec3& p) const {
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            uint64_t h = bits[0];
+            h = h * 0x9E3779B97F4A7C15ull ^ bits[1];
+            h = h * 0x9E3779B97F4A7C15ull ^ bits[2];
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    struct PositionEqual {
+        bool operator()(const Vec3& a, const Vec3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+    };
+
+    uint64_t edgeKey(uint32_t a, uint32_t b) {
+        return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+    }
+
+    // Vertices that must stay put: on an open border or sharing their
+    // position with another vertex.
+    std::vector<bool> lockedVertices(std::span<const uint32_t> indices, std::span<const Vec3> positions) {
+        std::vector<bool> locked(positions.size(), false);
+
+        std::unordered_map<Vec3, uint32_t, PositionHash, PositionEqual> firstAtPosition;
+        std::vector<bool> referenced(positions.size(), false);
+        for (uint32_t index: indices) {
+            if (referenced[index]) {
+                continue;
+            }
+            referenced[index] = true;
+            auto [it, inserted] = firstAtPosition.try_emplace(positions[index], index);
+            if (!inserted) {
+                locked[index] = true;
+                locked[it->second] = true;
+            }
+        }
+
+        std::unordered_map<uint64_t, uint32_t> edgeUses;
+        edgeUses.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            for (int edge = 0; edge < 3; edge++) {
+                edgeUses[edgeKey(indices[i + edge], indices[i + (edge + 1) % 3])]++;
+            }
+        }
+        for (const auto& [key, uses]: edgeUses) {
+            if (uses == 1) {
+                locked[key >> 32] = true;
+                locked[key & 0xFFFFFFFF] = true;
+            }
+        }
+        return locked;
+    }
+
+    // Would moving `from` onto `to` turn any surviving triangle around `from` over?
+    bool flips(std::span<const uint32_t> indices, std::span<const uint32_t> triangles, std::span<const Vec3> positions,
+               uint32_t from, uint32_t to) {
+        for (uint32_t triangle: triangles) {
+            const uint32_t* t = &indices[triangle * 3];
+            if (t[0] == to || t[1] == to || t[2] == to) {
+                continue;
+            }
+            Vec3 before[3], after[3];
+            for (int corner = 0; corner < 3; corner++) {
+                before[corner] = positions[t[corner]];
+                after[corner] = t[corner] == from ? positions[to] : before[corner];
+            }
+            Vec3 normalBefore = cross(before[1] - before[0], before[2] - before[0]);
+            Vec3 normalAfter = cross(after[1] - after[0], after[2] - after[0]);
+            if (dot(normalBefore, normalAfter) <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+namespace mesh_simplifier {
+    Result simplify(std::span<const uint32_t> indices, std::span<const Vec3> positions, size_t targetIndexCount,
+                    float maxError) {
+        Result result;
+        result.indices.assign(indices.begin(), indices.end());
+        if (indices.size() <= targetIndexCount || indices.empty()) {
+            return result;
+        }
+        const uint32_t vertexCount = static_cast<uint32_t>(positions.size());
+
+        Vec3 lo{INFINITY, INFINITY, INFINITY}, hi{-INFINITY, -INFINITY, -INFINITY};
+        for (uint32_t index: indices) {
+            Vec3 p = positions[index];
+            lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+            hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+        }
+        double scale = std::max({hi.x - lo.x, hi.y - lo.y, hi.z - lo.z});
+        if (scale <= 0.0) {
+            return result;
+        }
+        double maxCost = double(maxError) * maxError * scale * scale;
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            Vec3 a = positions[indices[i]], b = positions[indices[i + 1]], c = positions[indices[i + 2]];
+            Vec3 n = cross(b - a, c - a);
+            float area = length(n);
+            if (area == 0.0f) {
+                continue;
+            }
+            n = n * (1.0f / area);
+            Quadric q = Quadric::plane(n, -dot(n, a), area * 0.5f);
+            for (size_t corner = 0; corner < 3; corner++) {
+                quadrics[indices[i + corner]] += q;
+            }
+        }
+
+        std::vector<bool> locked = lockedVertices(indices, positions);
+        std::vector<uint32_t>& current = result.indices;
+        std::vector<uint32_t> firstTriangle(vertexCount + 1), adjacency, remap(vertexCount);
+        std::vector<bool> touched(vertexCount);
+        std::vector<Collapse> collapses;
+        double worstCost = 0.0;
+
+        // Each pass performs the cheapest non-overlapping collapses, then
+        // rebuilds the index list; a vertex moves at most once per pass, so
+        // the flip test always sees final positions of its neighbourhood.
+        while (current.size() > targetIndexCount) {
+            const uint32_t triangleCount = static_cast<uint32_t>(current.size() / 3);
+
+            std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+            for (uint32_t index: current) {
+                firstTriangle[index + 1]++;
+            }
+            std::partial_sum(firstTriangle.begin(), firstTriangle.end(), firstTriangle.begin());
+            adjacency.resize(current.size());
+            std::vector<uint32_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+            for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+                for (int corner = 0; corner < 3; corner++) {
+                    adjacency[filled[current[triangle * 3 + corner]]++] = triangle;
+                }
+            }
+
+            collapses.clear();
+            for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+                for (int edge = 0; edge < 3; edge++) {
+                    uint32_t a = current[triangle * 3 + edge];
+                    uint32_t b = current[triangle * 3 + (edge + 1) % 3];
+                    // interior edges appear once in each direction
+                    if (a > b || (locked[a] && locked[b])) {
+                        continue;
+                    }
+                    Quadric q = quadrics[a];
+                    q += quadrics[b];
+                    double costAB = locked[a] ? INFINITY : q.error(positions[b]);
+                    double costBA = locked[b] ? INFINITY : q.error(positions[a]);
+                    collapses.push_back(costAB <= costBA ? Collapse{a, b, costAB} : Collapse{b, a, costBA});
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(),
+                      [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+            // a collapse removes about two triangles
+            size_t trianglesToRemove = (current.size() - targetIndexCount) / 3;
+            size_t removed = 0;
+            std::iota(remap.begin(), remap.end(), 0);
+            std::fill(touched.begin(), touched.end(), false);
+            for (const Collapse& collapse: collapses) {
+                if (collapse.cost > maxCost || removed >= trianglesToRemove) {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to]) {
+                    continue;
+                }
+                std::span<const uint32_t> around(adjacency.data() + firstTriangle[collapse.from],
+                                                 firstTriangle[collapse.from + 1] - firstTriangle[collapse.from]);
+                if (flips(current, around, positions, collapse.from, collapse.to)) {
+                    continue;
+                }
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                worstCost = std::max(worstCost, collapse.cost);
+                for (uint32_t triangle: around) {
+                    for (int corner = 0; corner < 3; corner++) {
+                        touched[current[triangle * 3 + corner]] = true;
+                    }
+                }
+                removed += 2;
+            }
+            if (removed == 0) {
+                break;
+            }
+
+            size_t out = 0;
+            for (size_t i = 0; i < current.size(); i += 3) {
+                uint32_t a = remap[current[i]], b = remap[current[i + 1]], c = remap[current[i + 2]];
+                if (a != b && b != c && a != c) {
+                    current[out++] = a;
+                    current[out++] = b;
+                    current[out++] = c;
+                }
+            }
+            current.resize(out);
+        }
+
+        result.error = static_cast<float>(std::sqrt(worstCost));
+        return result;
+    }
+
+    void generateLods(MeshData& mesh, std::span<const float> ratios, float maxError) {
+        if (mesh.lods.size() > 1) {
+            throw std::invalid_argument("mesh already has LODs");
+        }
+        std::vector<Vec3> positions = mesh_data::positions(mesh);
+
+        const std::vector<mesh_format::Submesh> base = mesh.submeshes;
+        mesh.lods = mesh_data::lods(mesh);
+        uint32_t previousIndexCount = mesh.lods.back().indexCount;
+        float previousError = 0.0f;
+
+        for (float ratio: ratios) {
+            std::vector<mesh_format::Submesh> submeshes;
+            std::vector<uint32_t> indices;
+            float error = previousError;
+            for (const mesh_format::Submesh& submesh: base) {
+                std::span<const uint32_t> source(mesh.indices.data() + submesh.firstIndex, submesh.indexCount);
+                size_t target = static_cast<size_t>(static_cast<float>(submesh.indexCount / 3) * ratio) * 3;
+                Result simplified = simplify(source, positions, target, maxError);
+                submeshes.push_back({static_cast<uint32_t>(mesh.indices.size() + indices.size()),
+                                     static_cast<uint32_t>(simplified.indices.size()), submesh.material});
+                indices.insert(indices.end(), simplified.indices.begin(), simplified.indices.end());
+                error = std::max(error, simplified.error);
+            }
+
+            // not worth a level: the error bound stopped the simplifier
+            if (indices.size() > previousIndexCount * 85 / 100 || indices.empty()) {
+                break;
+            }
+            mesh.lods.push_back({static_cast<uint32_t>(mesh.indices.size()), static_cast<uint32_t>(indices.size()),
+                                 error});
+            mesh.submeshes.insert(mesh.submeshes.end(), submeshes.begin(), submeshes.end());
+            mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+            previousIndexCount = static_cast<uint32_t>(indices.size());
+            previousError = error;
+        }
+        if (mesh.lods.size() == 1) {
+            mesh.lods.clear();
+        }
+    }
+}
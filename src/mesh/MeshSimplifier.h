@@ -0,0 +1,38 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "MeshData.h"
+#include "../math/Math.h"
+
+// Quadric error metric edge-collapse simplification (Garland and Heckbert)
+// for offline LOD generation. Collapses move one vertex onto another, so a
+// simplified index list still refers to the original vertex buffer and LODs
+// share it. Vertices on open borders and on attribute seams (several vertices
+// at one position) never move, which keeps silhouettes and texture seams
+// intact at the cost of some reduction on heavily seamed meshes.
+namespace mesh_simplifier {
+    struct Result {
+        std::vector<uint32_t> indices;
+        // estimated largest distance between the simplified and the original
+        // surface, in the units of the positions
+        float error = 0.0f;
+    };
+
+    // Collapses the cheapest edges until at most `targetIndexCount` indices
+    // remain or the next collapse would exceed `maxError`, a fraction of the
+    // largest extent of the input. Collapses that flip a triangle are skipped.
+    Result simplify(std::span<const uint32_t> indices, std::span<const Vec3> positions, size_t targetIndexCount,
+                    float maxError);
+
+    // Appends a LOD per entry of `ratios` (fractions of LOD 0's triangles,
+    // decreasing), simplifying every submesh of LOD 0 independently. Stops
+    // early once a level cannot get meaningfully smaller within `maxError`.
+    // LOD errors never decrease from one level to the next.
+    void generateLods(MeshData& mesh, std::span<const float> ratios, float maxError = 0.02f);
+}
+
+#endif //MESH_SIMPLIFIER_H
@@ -0,0 +1,256 @@
+#include "ObjLoader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "../files.h"
+
+namespace {
+    struct Corner {
+        int32_t position;
+        int32_t uv;
+        int32_t normal;
+
+        bool operator==(const Corner&) const = default;
+    };
+
+    struct CornerHash {
+        size_t operator()(const Corner& c) const {
+            uint64_t h = static_cast<uint32_t>(c.position);
+            h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(c.uv);
+            h = h * 0x9E3779B97F4A7C15ull ^ static_cast<uint32_t>(c.normal);
+            return static_cast<size_t>(h ^ (h >> 29));
+        }
+    };
+
+    class Cursor {
+    public:
+        Cursor(const char* begin, const char* end) : p(begin), end(end) {}
+
+        void skipSpaces() {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+                p++;
+            }
+        }
+
+        bool atLineEnd() {
+            skipSpaces();
+            return p >= end || *p == '\n' || *p == '#';
+        }
+
+        std::string_view word() {
+            skipSpaces();
+            const char* start = p;
+            while (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+                p++;
+            }
+            return {start, static_cast<size_t>(p - start)};
+        }
+
+        float number() {
+            skipSpaces();
+            float value = 0.0f;
+            auto [next, error] = std::from_chars(p, end, value);
+            if (error != std::errc()) {
+                throw std::runtime_error("obj: malformed number");
+            }
+            p = next;
+            return value;
+        }
+
+        // One face corner index; 0 when the slot is empty ("1//3").
+        int32_t index() {
+            if (p < end && *p == '/') {
+                return 0;
+            }
+            int32_t value = 0;
+            auto [next, error] = std::from_chars(p, end, value);
+            if (error != std::errc()) {
+                throw std::runtime_error("obj: malformed face index");
+            }
+            p = next;
+            return value;
+        }
+
+        bool consume(char c) {
+            if (p < end && *p == c) {
+                p++;
+                return true;
+            }
+            return false;
+        }
+
+        void nextLine() {
+            const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            p = newline ? newline + 1 : end;
+        }
+
+        [[nodiscard]] bool done() const { return p >= end; }
+
+    private:
+        const char* p;
+        const char* end;
+    };
+
+    // OBJ indices are 1-based, negative ones count back from the latest element.
+    int32_t resolve(int32_t index, size_t count) {
+        if (index == 0) {
+            return -1;
+        }
+        int64_t resolved = index > 0 ? index - 1 : static_cast<int64_t>(count) + index;
+        if (resolved < 0 || resolved >= static_cast<int64_t>(count)) {
+            throw std::runtime_error("obj: face index out of range");
+        }
+        return static_cast<int32_t>(resolved);
+    }
+}
+
+namespace obj {
+    MeshData parse(std::string_view text) {
+        std::vector<Vec3> positions;
+        std::vector<Vec3> normals;
+        std::vector<std::pair<float, float>> uvs;
+
+        std::vector<StandardVertex> vertices;
+        std::vector<bool> computeNormal;
+        std::unordered_map<Corner, uint32_t, CornerHash> vertexOf;
+        // triangles per material, concatenated into submeshes at the end
+        std::vector<std::vector<uint32_t>> materialIndices(1);
+        std::vector<std::string> materials{""};
+        size_t material = 0;
+        std::vector<uint32_t> face;
+
+        Cursor cursor(text.data(), text.data() + text.size());
+        while (!cursor.done()) {
+            std::string_view keyword = cursor.word();
+            if (keyword == "v") {
+                Vec3 p;
+                p.x = cursor.number();
+                p.y = cursor.number();
+                p.z = cursor.number();
+                positions.push_back(p);
+            } else if (keyword == "vn") {
+                Vec3 n;
+                n.x = cursor.number();
+                n.y = cursor.number();
+                n.z = cursor.number();
+                normals.push_back(n);
+            } else if (keyword == "vt") {
+                float u = cursor.number();
+                float v = cursor.atLineEnd() ? 0.0f : cursor.number();
+                uvs.emplace_back(u, v);
+            } else if (keyword == "f") {
+                face.clear();
+                while (!cursor.atLineEnd()) {
+                    Corner corner{resolve(cursor.index(), positions.size()), -1, -1};
+                    if (cursor.consume('/')) {
+                        corner.uv = resolve(cursor.index(), uvs.size());
+                        if (cursor.consume('/')) {
+                            corner.normal = resolve(cursor.index(), normals.size());
+                        }
+                    }
+                    if (corner.position < 0) {
+                        throw std::runtime_error("obj: face corner without a position");
+                    }
+
+                    auto [it, inserted] = vertexOf.try_emplace(corner, static_cast<uint32_t>(vertices.size()));
+                    if (inserted) {
+                        StandardVertex vertex{};
+                        Vec3 p = positions[corner.position];
+                        vertex.position[0] = p.x;
+                        vertex.position[1] = p.y;
+                        vertex.position[2] = p.z;
+                        if (corner.normal >= 0) {
+                            Vec3 n = normals[corner.normal];
+                            vertex.normal[0] = n.x;
+                            vertex.normal[1] = n.y;
+                            vertex.normal[2] = n.z;
+                        }
+                        if (corner.uv >= 0) {
+                            vertex.uv[0] = uvs[corner.uv].first;
+                            vertex.uv[1] = 1.0f - uvs[corner.uv].second;
+                        }
+                        vertices.push_back(vertex);
+                        computeNormal.push_back(corner.normal < 0);
+                    }
+                    face.push_back(it->second);
+                }
+                for (size_t i = 2; i < face.size(); i++) {
+                    materialIndices[material].insert(materialIndices[material].end(), {face[0], face[i - 1], face[i]});
+                }
+            } else if (keyword == "usemtl") {
+                std::string name(cursor.word());
+                auto it = std::find(materials.begin(), materials.end(), name);
+                material = static_cast<size_t>(it - materials.begin());
+                if (it == materials.end()) {
+                    materials.push_back(name);
+                    materialIndices.emplace_back();
+                }
+            }
+            cursor.nextLine();
+        }
+
+        // area-weighted face normals for corners the file gave none
+        for (const std::vector<uint32_t>& indices: materialIndices) {
+            for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+                StandardVertex* corners[3] = {&vertices[indices[i]], &vertices[indices[i + 1]], &vertices[indices[i + 2]]};
+                Vec3 a{corners[0]->position[0], corners[0]->position[1], corners[0]->position[2]};
+                Vec3 b{corners[1]->position[0], corners[1]->position[1], corners[1]->position[2]};
+                Vec3 c{corners[2]->position[0], corners[2]->position[1], corners[2]->position[2]};
+                Vec3 n = cross(b - a, c - a);
+                for (int k = 0; k < 3; k++) {
+                    if (computeNormal[indices[i + k]]) {
+                        corners[k]->normal[0] += n.x;
+                        corners[k]->normal[1] += n.y;
+                        corners[k]->normal[2] += n.z;
+                    }
+                }
+            }
+        }
+
+        MeshData mesh;
+        Vec3 lo{INFINITY, INFINITY, INFINITY}, hi{-INFINITY, -INFINITY, -INFINITY};
+        for (size_t i = 0; i < vertices.size(); i++) {
+            StandardVertex& v = vertices[i];
+            if (computeNormal[i]) {
+                Vec3 n{v.normal[0], v.normal[1], v.normal[2]};
+                float len = length(n);
+                n = len > 0.0f ? n * (1.0f / len) : Vec3{0.0f, 1.0f, 0.0f};
+                v.normal[0] = n.x;
+                v.normal[1] = n.y;
+                v.normal[2] = n.z;
+            }
+            lo = {std::min(lo.x, v.position[0]), std::min(lo.y, v.position[1]), std::min(lo.z, v.position[2])};
+            hi = {std::max(hi.x, v.position[0]), std::max(hi.y, v.position[1]), std::max(hi.z, v.position[2])};
+        }
+        if (!vertices.empty()) {
+            mesh.bounds = {(lo + hi) * 0.5f, (hi - lo) * 0.5f};
+        }
+
+        mesh.attributes = mesh_data::standardAttributes();
+        mesh.vertexStride = sizeof(StandardVertex);
+        mesh.vertexCount = static_cast<uint32_t>(vertices.size());
+        mesh.vertices.resize(vertices.size() * sizeof(StandardVertex));
+        std::memcpy(mesh.vertices.data(), vertices.data(), mesh.vertices.size());
+
+        for (size_t m = 0; m < materialIndices.size(); m++) {
+            if (materialIndices[m].empty()) {
+                continue;
+            }
+            mesh.submeshes.push_back({static_cast<uint32_t>(mesh.indices.size()),
+                                      static_cast<uint32_t>(materialIndices[m].size()),
+                                      static_cast<uint32_t>(mesh.materials.size())});
+            mesh.materials.push_back(materials[m]);
+            mesh.indices.insert(mesh.indices.end(), materialIndices[m].begin(), materialIndices[m].end());
+        }
+        return mesh;
+    }
+
+    MeshData load(const std::string& filename) {
+        std::vector<char> text = utils::readFile(filename);
+        return parse({text.data(), text.size()});
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <string>
+#include <string_view>
+
+#include "MeshData.h"
+
+// Wavefront OBJ to MeshData in the standard vertex layout. Faces are
+// triangulated as fans and identical position/uv/normal triples share a
+// vertex. Triangles are grouped into one submesh per `usemtl` material, in
+// order of first use. Missing normals are computed from the faces; texture
+// coordinates are flipped to Vulkan's top-left origin. Only geometry is read:
+// mtllib, groups and smoothing groups are ignored.
+namespace obj {
+    MeshData parse(std::string_view text);
+
+    MeshData load(const std::string& filename);
+}
+
+#endif //OBJ_LOADER_H
@@ -20,11 +20,6 @@ FragmentStageParamsBuilder& FragmentStageParamsBuilder::setSpecializationInfo(co
     return *this;
 }
 
-FragmentStageParamsBuilder& FragmentStageParamsBuilder::setPushConstants(const std::vector<uint8_t>& pushData) {
-    pushConstants = pushData;
-    return *this;
-}
-
 VkPipelineShaderStageCreateInfo FragmentStageParamsBuilder::build() const {
     VkPipelineShaderStageCreateInfo stageInfo{};
     stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
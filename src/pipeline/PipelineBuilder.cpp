@@ -1,8 +1,30 @@
 #include "PipelineBuilder.h"
 
+#include <exception>
 #include <memory>
 #include <stdexcept>
 
+#include "../jobs/JobSystem.h"
+
+namespace {
+    // Defaults are the opaque preset without depth, evaluated at compile time.
+    constexpr PipelineStateDesc defaultState = [] {
+        PipelineStateDesc state = pipeline_state::presets::opaque;
+        state.depthTest = VK_FALSE;
+        state.depthWrite = VK_FALSE;
+        return state;
+    }();
+
+    constexpr VkPipelineInputAssemblyStateCreateInfo defaultInputAssembly = pipeline_state::inputAssemblyInfo(defaultState);
+    constexpr VkPipelineRasterizationStateCreateInfo defaultRasterization = pipeline_state::rasterizationInfo(defaultState);
+    constexpr VkPipelineMultisampleStateCreateInfo defaultMultisample = pipeline_state::multisampleInfo();
+    constexpr VkPipelineDepthStencilStateCreateInfo defaultDepthStencil = pipeline_state::depthStencilInfo(defaultState);
+    constexpr VkPipelineColorBlendAttachmentState defaultBlendAttachment =
+            pipeline_state::blendAttachment(defaultState.blend);
+    constexpr VkPipelineColorBlendStateCreateInfo defaultColorBlend =
+            pipeline_state::colorBlendInfo(defaultState, &defaultBlendAttachment);
+}
+
 PipelineBuilder::PipelineBuilder(float viewportWidth, float viewportHeight, VkRenderPass renderPass,
                                  VkPipelineLayout pipelineLayout)
     : renderPass(renderPass), pipelineLayout(pipelineLayout) {
@@ -34,6 +56,14 @@ PipelineBuilder &PipelineBuilder::setFragmentStage(const VkPipelineShaderStageCr
     return *this;
 }
 
+PipelineBuilder &PipelineBuilder::setVertexInputState(const VkPipelineVertexInputStateCreateInfo &vertexInput) {
+    vertexBindings.assign(vertexInput.pVertexBindingDescriptions,
+                          vertexInput.pVertexBindingDescriptions + vertexInput.vertexBindingDescriptionCount);
+    vertexAttributes.assign(vertexInput.pVertexAttributeDescriptions,
+                            vertexInput.pVertexAttributeDescriptions + vertexInput.vertexAttributeDescriptionCount);
+    return *this;
+}
+
 PipelineBuilder &PipelineBuilder::setInputAssemblyState(const VkPipelineInputAssemblyStateCreateInfo &inputAssembly) {
     this->inputAssemblyState = inputAssembly;
     return *this;
@@ -51,6 +81,7 @@ PipelineBuilder &PipelineBuilder::setMultisampleState(const VkPipelineMultisampl
 
 PipelineBuilder &PipelineBuilder::setColorBlendState(const VkPipelineColorBlendStateCreateInfo &colorBlend) {
     this->colorBlendState = colorBlend;
+    this->blendAttachment.reset();
     return *this;
 }
 
@@ -59,96 +90,97 @@ PipelineBuilder &PipelineBuilder::setDepthStencilState(const VkPipelineDepthSten
     return *this;
 }
 
-VkPipelineInputAssemblyStateCreateInfo PipelineBuilder::defaultInputAssemblyState() {
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
-    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
-    return inputAssembly;
-}
-
-VkPipelineRasterizationStateCreateInfo PipelineBuilder::defaultRasterizationState() {
-    VkPipelineRasterizationStateCreateInfo rasterization{};
-    rasterization.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterization.depthClampEnable = VK_FALSE;
-    rasterization.rasterizerDiscardEnable = VK_FALSE;
-    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterization.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterization.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterization.depthBiasEnable = VK_FALSE;
-    rasterization.lineWidth = 1.0f;
-    return rasterization;
-}
-
-VkPipelineMultisampleStateCreateInfo PipelineBuilder::defaultMultisampleState() {
-    VkPipelineMultisampleStateCreateInfo multisample{};
-    multisample.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-    multisample.sampleShadingEnable = VK_FALSE;
-    return multisample;
-}
-
-VkPipelineColorBlendStateCreateInfo PipelineBuilder::defaultColorBlendState() {
-    static auto defaultColorBlendAttachment = VkPipelineColorBlendAttachmentState{
-        .blendEnable = VK_FALSE,
-        .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT |
-                          VK_COLOR_COMPONENT_A_BIT
-    };
-
-    VkPipelineColorBlendStateCreateInfo colorBlendInfo{};
-    colorBlendInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlendInfo.attachmentCount = 1;
-    colorBlendInfo.pAttachments = &defaultColorBlendAttachment;
-    return colorBlendInfo;
+PipelineBuilder &PipelineBuilder::setState(const PipelineStateDesc &state) {
+    inputAssemblyState = pipeline_state::inputAssemblyInfo(state);
+    rasterizationState = pipeline_state::rasterizationInfo(state);
+    depthStencilState = pipeline_state::depthStencilInfo(state);
+    blendAttachment = pipeline_state::blendAttachment(state.blend);
+    colorBlendState = pipeline_state::colorBlendInfo(state, nullptr);
+    return *this;
 }
 
-VkPipelineDepthStencilStateCreateInfo PipelineBuilder::defaultDepthStencilState() {
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
-    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
-    depthStencil.depthTestEnable = VK_FALSE;
-    depthStencil.depthWriteEnable = VK_FALSE;
-    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
-    depthStencil.depthBoundsTestEnable = VK_FALSE;
-    depthStencil.stencilTestEnable = VK_FALSE;
-    return depthStencil;
+PipelineStateDesc PipelineBuilder::effectiveState() const {
+    const VkPipelineInputAssemblyStateCreateInfo &inputAssembly = inputAssemblyState.value_or(defaultInputAssembly);
+    const VkPipelineRasterizationStateCreateInfo &rasterization = rasterizationState.value_or(defaultRasterization);
+    const VkPipelineDepthStencilStateCreateInfo &depthStencil = depthStencilState.value_or(defaultDepthStencil);
+    const VkPipelineColorBlendStateCreateInfo &colorBlend = colorBlendState.value_or(defaultColorBlend);
+
+    PipelineStateDesc state;
+    state.topology = inputAssembly.topology;
+    state.polygonMode = rasterization.polygonMode;
+    state.cullMode = rasterization.cullMode;
+    state.frontFace = rasterization.frontFace;
+    state.depthBiasEnable = rasterization.depthBiasEnable;
+    state.depthBiasConstant = rasterization.depthBiasConstantFactor;
+    state.depthBiasSlope = rasterization.depthBiasSlopeFactor;
+    state.depthTest = depthStencil.depthTestEnable;
+    state.depthWrite = depthStencil.depthWriteEnable;
+    state.depthCompare = depthStencil.depthCompareOp;
+    state.colorAttachmentCount = colorBlend.attachmentCount;
+
+    const VkPipelineColorBlendAttachmentState *attachment = blendAttachment ? &*blendAttachment : colorBlend.pAttachments;
+    if (colorBlend.attachmentCount > 0 && attachment) {
+        state.blend.enable = attachment->blendEnable;
+        state.blend.srcColor = attachment->srcColorBlendFactor;
+        state.blend.dstColor = attachment->dstColorBlendFactor;
+        state.blend.colorOp = attachment->colorBlendOp;
+        state.blend.srcAlpha = attachment->srcAlphaBlendFactor;
+        state.blend.dstAlpha = attachment->dstAlphaBlendFactor;
+        state.blend.alphaOp = attachment->alphaBlendOp;
+        state.blend.writeMask = attachment->colorWriteMask;
+    }
+    return state;
 }
 
-VkPipeline PipelineBuilder::build(VkDevice device) const {
+VkPipeline PipelineBuilder::build(VkDevice device, VkPipelineCache cache) const {
     if (!vertexStage.sType || !fragmentStage.sType) {
         throw std::runtime_error("Vertex and fragment shader stages must be set.");
     }
 
     VkPipelineShaderStageCreateInfo shaderStages[] = {vertexStage, fragmentStage};
 
-    VkPipelineInputAssemblyStateCreateInfo defaultInputAssembly;
-    VkPipelineRasterizationStateCreateInfo defaultRasterization;
-    VkPipelineMultisampleStateCreateInfo defaultMultisample;
-    VkPipelineColorBlendStateCreateInfo defaultColorBlend;
-    VkPipelineDepthStencilStateCreateInfo defaultDepthStencil;
-
-    const VkPipelineInputAssemblyStateCreateInfo *inputAssemblyStatePtr = inputAssemblyState ?
-            &*inputAssemblyState :
-            (defaultInputAssembly = defaultInputAssemblyState(), &defaultInputAssembly);
-    const VkPipelineRasterizationStateCreateInfo *rasterizationStatePtr = rasterizationState ?
-            &*rasterizationState :
-            (defaultRasterization = defaultRasterizationState(), &defaultRasterization);
-    const VkPipelineMultisampleStateCreateInfo *multisampleStatePtr = multisampleState ?
-            &*multisampleState :
-            (defaultMultisample = defaultMultisampleState(), &defaultMultisample);
-    const VkPipelineColorBlendStateCreateInfo *colorBlendStatePtr = colorBlendState ?
-            &*colorBlendState :
-            (defaultColorBlend = defaultColorBlendState(), &defaultColorBlend);
-    const VkPipelineDepthStencilStateCreateInfo *depthStencilStatePtr = depthStencilState ?
-            &*depthStencilState :
-            (defaultDepthStencil = defaultDepthStencilState(), &defaultDepthStencil);
+    const VkPipelineInputAssemblyStateCreateInfo *inputAssemblyStatePtr =
+            inputAssemblyState ? &*inputAssemblyState : &defaultInputAssembly;
+    const VkPipelineRasterizationStateCreateInfo *rasterizationStatePtr =
+            rasterizationState ? &*rasterizationState : &defaultRasterization;
+    const VkPipelineMultisampleStateCreateInfo *multisampleStatePtr =
+            multisampleState ? &*multisampleState : &defaultMultisample;
+    const VkPipelineDepthStencilStateCreateInfo *depthStencilStatePtr =
+            depthStencilState ? &*depthStencilState : &defaultDepthStencil;
+
+    VkPipelineColorBlendStateCreateInfo presetColorBlend;
+    std::vector<VkPipelineColorBlendAttachmentState> presetAttachments;
+    const VkPipelineColorBlendStateCreateInfo *colorBlendStatePtr = &defaultColorBlend;
+    if (colorBlendState && blendAttachment) {
+        // the preset's blend state, once per color attachment
+        presetColorBlend = *colorBlendState;
+        presetAttachments.assign(presetColorBlend.attachmentCount, *blendAttachment);
+        presetColorBlend.pAttachments = presetAttachments.empty() ? nullptr : presetAttachments.data();
+        colorBlendStatePtr = &presetColorBlend;
+    } else if (colorBlendState) {
+        colorBlendStatePtr = &*colorBlendState;
+    }
+
+    // the builder may have been copied since construction, so point at this instance's viewport
+    VkPipelineViewportStateCreateInfo viewportStateInfo = viewportState;
+    viewportStateInfo.pViewports = &viewport;
+    viewportStateInfo.pScissors = &scissor;
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexBindings.size());
+    vertexInputInfo.pVertexBindingDescriptions = vertexBindings.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.data();
 
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
     pipelineInfo.stageCount = 2;
     pipelineInfo.pStages = shaderStages;
 
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
     pipelineInfo.pInputAssemblyState = inputAssemblyStatePtr;
-    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pViewportState = &viewportStateInfo;
     pipelineInfo.pRasterizationState = rasterizationStatePtr;
     pipelineInfo.pMultisampleState = multisampleStatePtr;
     pipelineInfo.pColorBlendState = colorBlendStatePtr;
@@ -158,9 +190,35 @@ VkPipeline PipelineBuilder::build(VkDevice device) const {
     pipelineInfo.layout = pipelineLayout;
 
     VkPipeline pipeline;
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline.");
     }
 
     return pipeline;
 }
+
+std::vector<VkPipeline> PipelineBuilder::buildParallel(VkDevice device, const std::vector<PipelineBuilder>& builders,
+                                                      JobSystem& jobs, VkPipelineCache cache) {
+    std::vector<VkPipeline> pipelines(builders.size(), VK_NULL_HANDLE);
+    std::vector<std::exception_ptr> errors(builders.size());
+
+    jobs.parallelFor(static_cast<uint32_t>(builders.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            try {
+                pipelines[i] = builders[i].build(device, cache);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        }
+    });
+
+    for (size_t i = 0; i < builders.size(); i++) {
+        if (errors[i]) {
+            for (VkPipeline pipeline: pipelines) {
+                vkDestroyPipeline(device, pipeline, nullptr);
+            }
+            std::rethrow_exception(errors[i]);
+        }
+    }
+    return pipelines;
+}
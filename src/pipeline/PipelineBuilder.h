@@ -3,6 +3,11 @@
 
 #include <vulkan/vulkan.h>
 #include <optional>
+#include <vector>
+
+#include "PipelineState.h"
+
+class JobSystem;
 
 class PipelineBuilder {
 public:
@@ -11,13 +16,39 @@ public:
     PipelineBuilder& setVertexStage(const VkPipelineShaderStageCreateInfo& vertexStage);
     PipelineBuilder& setFragmentStage(const VkPipelineShaderStageCreateInfo& fragmentStage);
 
+    // Copies the binding and attribute descriptions; without a call the pipeline has no vertex inputs.
+    PipelineBuilder& setVertexInputState(const VkPipelineVertexInputStateCreateInfo& vertexInput);
     PipelineBuilder& setInputAssemblyState(const VkPipelineInputAssemblyStateCreateInfo& inputAssembly);
     PipelineBuilder& setRasterizationState(const VkPipelineRasterizationStateCreateInfo& rasterization);
     PipelineBuilder& setMultisampleState(const VkPipelineMultisampleStateCreateInfo& multisample);
     PipelineBuilder& setColorBlendState(const VkPipelineColorBlendStateCreateInfo& colorBlend);
     PipelineBuilder& setDepthStencilState(const VkPipelineDepthStencilStateCreateInfo& depthStencil);
 
-    VkPipeline build(VkDevice device) const;
+    // Replaces input assembly, rasterization, depth-stencil and color blend state with `state`.
+    PipelineBuilder& setState(const PipelineStateDesc& state);
+
+    VkPipeline build(VkDevice device, VkPipelineCache cache = VK_NULL_HANDLE) const;
+
+    // The fixed-function state build() would use, folded back into a PipelineStateDesc.
+    // Fields the desc cannot express (stencil, logic ops, extra attachments) are dropped.
+    [[nodiscard]] PipelineStateDesc effectiveState() const;
+
+    [[nodiscard]] VkRenderPass getRenderPass() const { return renderPass; }
+    [[nodiscard]] VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
+    [[nodiscard]] const VkPipelineShaderStageCreateInfo& getVertexStage() const { return vertexStage; }
+    [[nodiscard]] const VkPipelineShaderStageCreateInfo& getFragmentStage() const { return fragmentStage; }
+    [[nodiscard]] const VkViewport& getViewport() const { return viewport; }
+    [[nodiscard]] const std::vector<VkVertexInputBindingDescription>& getVertexBindings() const {
+        return vertexBindings;
+    }
+    [[nodiscard]] const std::vector<VkVertexInputAttributeDescription>& getVertexAttributes() const {
+        return vertexAttributes;
+    }
+
+    // Builds every pipeline on the job system; driver compilation is the expensive part
+    // and vkCreateGraphicsPipelines may be called concurrently.
+    static std::vector<VkPipeline> buildParallel(VkDevice device, const std::vector<PipelineBuilder>& builders,
+                                                 JobSystem& jobs, VkPipelineCache cache = VK_NULL_HANDLE);
 
 private:
 
@@ -30,18 +61,15 @@ private:
     VkViewport viewport{};
     VkRect2D scissor{};
 
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
     std::optional<VkPipelineInputAssemblyStateCreateInfo> inputAssemblyState;
     std::optional<VkPipelineRasterizationStateCreateInfo> rasterizationState;
     std::optional<VkPipelineMultisampleStateCreateInfo> multisampleState;
     std::optional<VkPipelineColorBlendStateCreateInfo> colorBlendState;
     std::optional<VkPipelineDepthStencilStateCreateInfo> depthStencilState;
-
-    [[nodiscard]] static VkPipelineInputAssemblyStateCreateInfo defaultInputAssemblyState();
-    [[nodiscard]] static VkPipelineRasterizationStateCreateInfo defaultRasterizationState();
-    [[nodiscard]] static VkPipelineMultisampleStateCreateInfo defaultMultisampleState();
-    [[nodiscard]] static VkPipelineColorBlendStateCreateInfo defaultColorBlendState();
-    [[nodiscard]] static VkPipelineDepthStencilStateCreateInfo defaultDepthStencilState();
-
+    // attachment state from setState(); colorBlendState is re-pointed at it in build()
+    std::optional<VkPipelineColorBlendAttachmentState> blendAttachment;
 };
 
 #endif // PIPELINE_BUILDER_H
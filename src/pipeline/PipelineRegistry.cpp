@@ -0,0 +1,79 @@
+#include "PipelineRegistry.h"
+
+#include <stdexcept>
+#include <type_traits>
+
+#include "PipelineBuilder.h"
+#include "../device.h"
+
+namespace {
+    template<typename Handle>
+    uint64_t handleBits(Handle handle) {
+        if constexpr (std::is_pointer_v<Handle>) {
+            return reinterpret_cast<uintptr_t>(handle);
+        } else {
+            return static_cast<uint64_t>(handle);
+        }
+    }
+}
+
+PipelineRegistry::PipelineRegistry(Device& device) : device(device) {
+}
+
+uint64_t PipelineRegistry::makeId(uint64_t stateKey, VkShaderModule vertexShader, VkShaderModule fragmentShader,
+                                  VkRenderPass renderPass, VkPipelineLayout layout) {
+    uint64_t id = pipeline_state::combine(stateKey, handleBits(vertexShader));
+    id = pipeline_state::combine(id, handleBits(fragmentShader));
+    id = pipeline_state::combine(id, handleBits(renderPass));
+    return pipeline_state::combine(id, handleBits(layout));
+}
+
+uint64_t PipelineRegistry::makeId(uint64_t stateKey, const PipelineBuilder& builder) {
+    return makeId(stateKey, builder.getVertexStage().module, builder.getFragmentStage().module,
+                  builder.getRenderPass(), builder.getPipelineLayout());
+}
+
+PipelineRegistry::~PipelineRegistry() {
+    for (const auto& [id, entry]: pipelines) {
+        vkDestroyPipeline(device.device(), entry.pipeline, nullptr);
+    }
+}
+
+VkPipeline PipelineRegistry::find(uint64_t id) const {
+    auto it = pipelines.find(id);
+    return it != pipelines.end() ? it->second.pipeline : VK_NULL_HANDLE;
+}
+
+VkPipeline PipelineRegistry::getOrCreate(uint64_t stateKey, const PipelineBuilder& builder) {
+    uint64_t id = makeId(stateKey, builder);
+    auto it = pipelines.find(id);
+    if (it != pipelines.end()) {
+        return it->second.pipeline;
+    }
+    VkPipeline pipeline = builder.build(device.device());
+    pipelines.emplace(id, Entry{pipeline, nextSortIndex++});
+    return pipeline;
+}
+
+void PipelineRegistry::insert(uint64_t id, VkPipeline pipeline) {
+    if (!pipelines.emplace(id, Entry{pipeline, nextSortIndex}).second) {
+        throw std::runtime_error("Pipeline id is already registered.");
+    }
+    nextSortIndex++;
+}
+
+VkPipeline PipelineRegistry::replace(uint64_t id, VkPipeline pipeline) {
+    auto [it, inserted] = pipelines.try_emplace(id, Entry{pipeline, nextSortIndex});
+    if (inserted) {
+        nextSortIndex++;
+        return VK_NULL_HANDLE;
+    }
+    VkPipeline previous = it->second.pipeline;
+    it->second.pipeline = pipeline;
+    return previous;
+}
+
+uint32_t PipelineRegistry::sortIndex(uint64_t id) const {
+    auto it = pipelines.find(id);
+    return it != pipelines.end() ? it->second.sortIndex : UINT32_MAX;
+}
@@ -0,0 +1,63 @@
+#ifndef PIPELINE_REGISTRY_H
+#define PIPELINE_REGISTRY_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <unordered_map>
+
+class Device;
+class PipelineBuilder;
+
+// Owns pipelines by 64-bit id. Ids come from makeId(): a pipeline_state key
+// folded with the shader modules, render pass and layout, so pipelines that
+// share a preset never alias, and the ids are well mixed enough for a lookup
+// to be an integer compare.
+class PipelineRegistry {
+public:
+    explicit PipelineRegistry(Device& device);
+
+    [[nodiscard]] static uint64_t makeId(uint64_t stateKey, VkShaderModule vertexShader,
+                                         VkShaderModule fragmentShader, VkRenderPass renderPass,
+                                         VkPipelineLayout layout);
+    // The same for the shaders, render pass and layout `builder` is set up with.
+    [[nodiscard]] static uint64_t makeId(uint64_t stateKey, const PipelineBuilder& builder);
+    ~PipelineRegistry();
+
+    PipelineRegistry(const PipelineRegistry&) = delete;
+    PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+    // VK_NULL_HANDLE if no pipeline is registered under `id`
+    [[nodiscard]] VkPipeline find(uint64_t id) const;
+
+    // Builds the pipeline under makeId(stateKey, builder) on first use.
+    VkPipeline getOrCreate(uint64_t stateKey, const PipelineBuilder& builder);
+
+    // Takes ownership of `pipeline`; throws if `id` is already registered.
+    void insert(uint64_t id, VkPipeline pipeline);
+
+    // Swaps in `pipeline` and returns the previous one (or VK_NULL_HANDLE), which
+    // the caller must keep alive until the GPU has stopped using it.
+    VkPipeline replace(uint64_t id, VkPipeline pipeline);
+
+    // Small index of `id` in registration order, kept across replace(), for
+    // packing into draw sort keys. UINT32_MAX if `id` is not registered.
+    [[nodiscard]] uint32_t sortIndex(uint64_t id) const;
+
+    [[nodiscard]] size_t size() const { return pipelines.size(); }
+
+private:
+    struct IdentityHash {
+        size_t operator()(uint64_t id) const { return static_cast<size_t>(id); }
+    };
+
+    struct Entry {
+        VkPipeline pipeline;
+        uint32_t sortIndex;
+    };
+
+    Device& device;
+    std::unordered_map<uint64_t, Entry, IdentityHash> pipelines;
+    uint32_t nextSortIndex = 0;
+};
+
+#endif //PIPELINE_REGISTRY_H
@@ -0,0 +1,230 @@
+#ifndef PIPELINE_STATE_H
+#define PIPELINE_STATE_H
+
+#include <vulkan/vulkan.h>
+#include <bit>
+#include <cstdint>
+
+// Fixed-function pipeline state as a plain constexpr value. Presets are
+// compile-time constants and so are their keys, which means looking up a
+// preset pipeline is an integer compare rather than hashing a struct.
+struct BlendState {
+    VkBool32 enable = VK_FALSE;
+    VkBlendFactor srcColor = VK_BLEND_FACTOR_ONE;
+    VkBlendFactor dstColor = VK_BLEND_FACTOR_ZERO;
+    VkBlendOp colorOp = VK_BLEND_OP_ADD;
+    VkBlendFactor srcAlpha = VK_BLEND_FACTOR_ONE;
+    VkBlendFactor dstAlpha = VK_BLEND_FACTOR_ZERO;
+    VkBlendOp alphaOp = VK_BLEND_OP_ADD;
+    VkColorComponentFlags writeMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                      VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+};
+
+struct PipelineStateDesc {
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+    VkBool32 depthBiasEnable = VK_FALSE;
+    float depthBiasConstant = 0.0f;
+    float depthBiasSlope = 0.0f;
+
+    VkBool32 depthTest = VK_FALSE;
+    VkBool32 depthWrite = VK_FALSE;
+    VkCompareOp depthCompare = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    // 0 for passes that only write depth
+    uint32_t colorAttachmentCount = 1;
+    // applied to every color attachment
+    BlendState blend{};
+};
+
+namespace pipeline_state {
+    // 64-bit FNV-1a
+    constexpr uint64_t fnvOffset = 0xcbf29ce484222325ull;
+    constexpr uint64_t fnvPrime = 0x100000001b3ull;
+
+    constexpr uint64_t fnv1a(uint64_t hash, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            hash ^= (value >> (i * 8)) & 0xffu;
+            hash *= fnvPrime;
+        }
+        return hash;
+    }
+
+    constexpr uint64_t fnv1a(uint64_t hash, float value) {
+        return fnv1a(hash, std::bit_cast<uint32_t>(value));
+    }
+
+    constexpr uint64_t fnv1a(const char* text, uint64_t hash = fnvOffset) {
+        for (; *text; text++) {
+            hash ^= static_cast<uint8_t>(*text);
+            hash *= fnvPrime;
+        }
+        return hash;
+    }
+
+    // Hashes field by field so padding never leaks into the key.
+    constexpr uint64_t key(const PipelineStateDesc& desc) {
+        uint64_t hash = fnvOffset;
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.topology));
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.polygonMode));
+        hash = fnv1a(hash, desc.cullMode);
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.frontFace));
+        hash = fnv1a(hash, desc.depthBiasEnable);
+        hash = fnv1a(hash, desc.depthBiasConstant);
+        hash = fnv1a(hash, desc.depthBiasSlope);
+        hash = fnv1a(hash, desc.depthTest);
+        hash = fnv1a(hash, desc.depthWrite);
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.depthCompare));
+        hash = fnv1a(hash, desc.colorAttachmentCount);
+        hash = fnv1a(hash, desc.blend.enable);
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.blend.srcColor));
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.blend.dstColor));
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.blend.colorOp));
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.blend.srcAlpha));
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.blend.dstAlpha));
+        hash = fnv1a(hash, static_cast<uint32_t>(desc.blend.alphaOp));
+        hash = fnv1a(hash, desc.blend.writeMask);
+        return hash;
+    }
+
+    // Folds another identifier (shader pair, render pass, ...) into a state key.
+    constexpr uint64_t combine(uint64_t key, uint64_t other) {
+        return fnv1a(fnv1a(key, static_cast<uint32_t>(other)), static_cast<uint32_t>(other >> 32));
+    }
+
+    constexpr VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo(const PipelineStateDesc& desc) {
+        return {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+            .topology = desc.topology,
+            .primitiveRestartEnable = VK_FALSE,
+        };
+    }
+
+    constexpr VkPipelineRasterizationStateCreateInfo rasterizationInfo(const PipelineStateDesc& desc) {
+        return {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+            .depthClampEnable = VK_FALSE,
+            .rasterizerDiscardEnable = VK_FALSE,
+            .polygonMode = desc.polygonMode,
+            .cullMode = desc.cullMode,
+            .frontFace = desc.frontFace,
+            .depthBiasEnable = desc.depthBiasEnable,
+            .depthBiasConstantFactor = desc.depthBiasConstant,
+            .depthBiasSlopeFactor = desc.depthBiasSlope,
+            .lineWidth = 1.0f,
+        };
+    }
+
+    constexpr VkPipelineMultisampleStateCreateInfo multisampleInfo() {
+        return {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+            .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+            .sampleShadingEnable = VK_FALSE,
+        };
+    }
+
+    constexpr VkPipelineDepthStencilStateCreateInfo depthStencilInfo(const PipelineStateDesc& desc) {
+        return {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+            .depthTestEnable = desc.depthTest,
+            .depthWriteEnable = desc.depthWrite,
+            .depthCompareOp = desc.depthCompare,
+            .depthBoundsTestEnable = VK_FALSE,
+            .stencilTestEnable = VK_FALSE,
+        };
+    }
+
+    constexpr VkPipelineColorBlendAttachmentState blendAttachment(const BlendState& blend) {
+        return {
+            .blendEnable = blend.enable,
+            .srcColorBlendFactor = blend.srcColor,
+            .dstColorBlendFactor = blend.dstColor,
+            .colorBlendOp = blend.colorOp,
+            .srcAlphaBlendFactor = blend.srcAlpha,
+            .dstAlphaBlendFactor = blend.dstAlpha,
+            .alphaBlendOp = blend.alphaOp,
+            .colorWriteMask = blend.writeMask,
+        };
+    }
+
+    // `attachments` must hold desc.colorAttachmentCount states and outlive the returned struct
+    constexpr VkPipelineColorBlendStateCreateInfo colorBlendInfo(const PipelineStateDesc& desc,
+                                                                 const VkPipelineColorBlendAttachmentState* attachments) {
+        return {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+            .attachmentCount = desc.colorAttachmentCount,
+            .pAttachments = desc.colorAttachmentCount > 0 ? attachments : nullptr,
+        };
+    }
+
+    namespace presets {
+        constexpr PipelineStateDesc opaque{
+            .depthTest = VK_TRUE,
+            .depthWrite = VK_TRUE,
+        };
+
+        // sorted back to front, so it tests against depth but does not write it
+        constexpr PipelineStateDesc alphaBlend{
+            .depthTest = VK_TRUE,
+            .depthWrite = VK_FALSE,
+            .blend = {
+                .enable = VK_TRUE,
+                .srcColor = VK_BLEND_FACTOR_SRC_ALPHA,
+                .dstColor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+                .srcAlpha = VK_BLEND_FACTOR_ONE,
+                .dstAlpha = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            },
+        };
+
+        constexpr PipelineStateDesc additive{
+            .cullMode = VK_CULL_MODE_NONE,
+            .depthTest = VK_TRUE,
+            .depthWrite = VK_FALSE,
+            .blend = {
+                .enable = VK_TRUE,
+                .srcColor = VK_BLEND_FACTOR_SRC_ALPHA,
+                .dstColor = VK_BLEND_FACTOR_ONE,
+                .srcAlpha = VK_BLEND_FACTOR_ZERO,
+                .dstAlpha = VK_BLEND_FACTOR_ONE,
+            },
+        };
+
+        // depth pre-pass; the subpass has no color attachments
+        constexpr PipelineStateDesc depthOnly{
+            .depthTest = VK_TRUE,
+            .depthWrite = VK_TRUE,
+            .colorAttachmentCount = 0,
+        };
+
+        // front faces culled and slope-scaled bias to keep acne off lit surfaces
+        constexpr PipelineStateDesc shadow{
+            .cullMode = VK_CULL_MODE_FRONT_BIT,
+            .depthBiasEnable = VK_TRUE,
+            .depthBiasConstant = 1.25f,
+            .depthBiasSlope = 1.75f,
+            .depthTest = VK_TRUE,
+            .depthWrite = VK_TRUE,
+            .colorAttachmentCount = 0,
+        };
+    }
+
+    namespace keys {
+        constexpr uint64_t opaque = key(presets::opaque);
+        constexpr uint64_t alphaBlend = key(presets::alphaBlend);
+        constexpr uint64_t additive = key(presets::additive);
+        constexpr uint64_t depthOnly = key(presets::depthOnly);
+        constexpr uint64_t shadow = key(presets::shadow);
+    }
+
+    static_assert(keys::opaque != keys::alphaBlend && keys::opaque != keys::additive &&
+                  keys::opaque != keys::depthOnly && keys::opaque != keys::shadow &&
+                  keys::alphaBlend != keys::additive && keys::alphaBlend != keys::depthOnly &&
+                  keys::alphaBlend != keys::shadow && keys::additive != keys::depthOnly &&
+                  keys::additive != keys::shadow && keys::depthOnly != keys::shadow,
+                  "preset keys collide");
+}
+
+#endif //PIPELINE_STATE_H
@@ -0,0 +1,32 @@
+#include "PipelineVertexInputStateBuilder.h"
+
+PipelineVertexInputStateBuilder& PipelineVertexInputStateBuilder::addBinding(uint32_t binding, uint32_t stride,
+                                                                             VkVertexInputRate inputRate) {
+    bindings.push_back({binding, stride, inputRate});
+    return *this;
+}
+
+PipelineVertexInputStateBuilder& PipelineVertexInputStateBuilder::addAttribute(uint32_t location, uint32_t binding,
+                                                                               VkFormat format, uint32_t offset) {
+    attributes.push_back({location, binding, format, offset});
+    return *this;
+}
+
+PipelineVertexInputStateBuilder& PipelineVertexInputStateBuilder::addMeshBinding(
+    uint32_t binding, uint32_t stride, std::span<const mesh_format::Attribute> meshAttributes) {
+    addBinding(binding, stride);
+    for (const mesh_format::Attribute& attribute: meshAttributes) {
+        addAttribute(attribute.location, binding, static_cast<VkFormat>(attribute.format), attribute.offset);
+    }
+    return *this;
+}
+
+VkPipelineVertexInputStateCreateInfo PipelineVertexInputStateBuilder::build() const {
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+    vertexInputInfo.pVertexBindingDescriptions = bindings.data();
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+    vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+    return vertexInputInfo;
+}
@@ -0,0 +1,31 @@
+#ifndef PIPELINE_VERTEX_INPUT_STATE_BUILDER_H
+#define PIPELINE_VERTEX_INPUT_STATE_BUILDER_H
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../mesh/MeshFormat.h"
+
+// The create info returned by build() points into the builder, so it is only
+// valid while the builder lives; PipelineBuilder::setVertexInputState() copies
+// the descriptions it references.
+class PipelineVertexInputStateBuilder {
+public:
+    PipelineVertexInputStateBuilder& addBinding(uint32_t binding, uint32_t stride,
+                                                VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX);
+    PipelineVertexInputStateBuilder& addAttribute(uint32_t location, uint32_t binding, VkFormat format, uint32_t offset);
+
+    // A per-vertex binding with the layout of a packed mesh (MeshFile::attributes()).
+    PipelineVertexInputStateBuilder& addMeshBinding(uint32_t binding, uint32_t stride,
+                                                    std::span<const mesh_format::Attribute> attributes);
+
+    [[nodiscard]] VkPipelineVertexInputStateCreateInfo build() const;
+
+private:
+    std::vector<VkVertexInputBindingDescription> bindings;
+    std::vector<VkVertexInputAttributeDescription> attributes;
+};
+
+#endif  // PIPELINE_VERTEX_INPUT_STATE_BUILDER_H
@@ -0,0 +1,250 @@
+#include "ShaderHotReload.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+
+#include "PipelineRegistry.h"
+#include "../device.h"
+#include "../files.h"
+#include "../shaders.h"
+#include "../log/Log.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    bool isShaderSource(std::string_view name) {
+        return name.ends_with(".vert") || name.ends_with(".frag");
+    }
+
+    std::string quoted(const std::string& path) {
+        std::string result = "'";
+        for (char c: path) {
+            result += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        }
+        return result + "'";
+    }
+}
+
+ShaderHotReload::ShaderHotReload(Device& device, PipelineRegistry& registry)
+    : ShaderHotReload(device, registry, Options{}) {
+}
+
+ShaderHotReload::ShaderHotReload(Device& device, PipelineRegistry& registry, Options options)
+    : device(device), registry(registry), options(std::move(options)) {
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0 && inotify_add_watch(inotifyFd, this->options.sourceDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+        watchThread = std::thread([this] { watchLoop(); });
+        return;
+    }
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+#endif
+    if (logging::enabled(LogLevel::Warning)) {
+        std::cerr << "shader hot reload unavailable for " << this->options.sourceDir << '\n';
+    }
+}
+
+ShaderHotReload::~ShaderHotReload() {
+    stopping.store(true, std::memory_order_relaxed);
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+#ifdef __linux__
+    if (inotifyFd >= 0) {
+        close(inotifyFd);
+    }
+#endif
+    // built but never swapped in, so the GPU has not seen them
+    for (const Rebuilt& rebuilt: ready) {
+        vkDestroyPipeline(device.device(), rebuilt.pipeline, nullptr);
+    }
+}
+
+void ShaderHotReload::watch(uint64_t pipelineId, const PipelineBuilder& builder,
+                            const std::string& vertexSource, const std::string& fragmentSource) {
+    std::lock_guard lock(watchMutex);
+    watches.push_back({pipelineId, builder, vertexSource, fragmentSource});
+}
+
+size_t ShaderHotReload::update() {
+    std::vector<Rebuilt> swapped;
+    {
+        std::unique_lock lock(readyMutex, std::try_to_lock);
+        if (!lock.owns_lock() || ready.empty()) {
+            return 0;
+        }
+        swapped.swap(ready);
+    }
+
+    for (const Rebuilt& rebuilt: swapped) {
+        device.deletionQueue().enqueue(registry.replace(rebuilt.pipelineId, rebuilt.pipeline));
+    }
+    return swapped.size();
+}
+
+void ShaderHotReload::watchLoop() {
+#ifdef __linux__
+    using Clock = std::chrono::steady_clock;
+    constexpr int pollIntervalMs = 100;
+
+    std::vector<std::string> changed;
+    Clock::time_point deadline;
+    alignas(inotify_event) char buffer[4096];
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        int timeout = pollIntervalMs;
+        if (!changed.empty()) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            timeout = static_cast<int>(std::clamp<long long>(remaining.count(), 0, pollIntervalMs));
+        }
+
+        pollfd descriptor{inotifyFd, POLLIN, 0};
+        if (poll(&descriptor, 1, timeout) > 0) {
+            ssize_t length;
+            while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+                for (char* cursor = buffer; cursor < buffer + length;) {
+                    auto* event = reinterpret_cast<inotify_event*>(cursor);
+                    cursor += sizeof(inotify_event) + event->len;
+                    if (event->len == 0 || (event->mask & IN_ISDIR) || !isShaderSource(event->name)) {
+                        continue;
+                    }
+                    if (changed.empty()) {
+                        deadline = Clock::now() + options.debounce;
+                    }
+                    if (std::find(changed.begin(), changed.end(), event->name) == changed.end()) {
+                        changed.emplace_back(event->name);
+                    }
+                }
+            }
+        }
+
+        if (!changed.empty() && Clock::now() >= deadline) {
+            reload(changed);
+            changed.clear();
+        }
+    }
+#endif
+}
+
+bool ShaderHotReload::compile(const std::string& source) {
+#ifdef __linux__
+    std::string output = options.outputDir + "/" + source + ".spv";
+    std::string temporary = output + ".tmp";
+    std::string command = options.compiler + " " + quoted(options.sourceDir + "/" + source) +
+                          " -o " + quoted(temporary) + " 2>&1";
+
+    std::string messages;
+    FILE* pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr) {
+        return false;
+    }
+    char chunk[512];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), pipe)) > 0) {
+        messages.append(chunk, count);
+    }
+    int status = pclose(pipe);
+
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        if (logging::enabled(LogLevel::Warning)) {
+            std::cerr << "shader hot reload: " << source << " failed to compile, keeping the old pipelines\n"
+                      << messages;
+        }
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        return false;
+    }
+
+    // rename so nothing ever reads a half-written .spv
+    std::error_code error;
+    std::filesystem::rename(temporary, output, error);
+    return !error;
+#else
+    return false;
+#endif
+}
+
+VkShaderModule ShaderHotReload::loadModule(const std::string& source) {
+    std::vector<char> code = utils::readFile(options.outputDir + "/" + source + ".spv");
+    VkDevice vkDevice = device.device();
+    VkShaderModule module;
+    createShaderModule(vkDevice, code, module);
+    return module;
+}
+
+void ShaderHotReload::reload(const std::vector<std::string>& changed) {
+    std::vector<std::string> compiled;
+    for (const std::string& source: changed) {
+        if (compile(source)) {
+            compiled.push_back(source);
+        } else {
+            failures.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (compiled.empty()) {
+        return;
+    }
+
+    auto uses = [&](const Watch& watch) {
+        return std::find(compiled.begin(), compiled.end(), watch.vertexSource) != compiled.end() ||
+               std::find(compiled.begin(), compiled.end(), watch.fragmentSource) != compiled.end();
+    };
+    std::vector<Watch> affected;
+    {
+        std::lock_guard lock(watchMutex);
+        std::copy_if(watches.begin(), watches.end(), std::back_inserter(affected), uses);
+    }
+
+    // modules are only needed while the pipelines are created
+    std::unordered_map<std::string, VkShaderModule> modules;
+    auto moduleFor = [&](const std::string& source) {
+        auto it = modules.find(source);
+        if (it == modules.end()) {
+            it = modules.emplace(source, loadModule(source)).first;
+        }
+        return it->second;
+    };
+
+    std::vector<Rebuilt> built;
+    for (const Watch& watch: affected) {
+        try {
+            PipelineBuilder builder = watch.builder;
+            VkPipelineShaderStageCreateInfo vertexStage = builder.getVertexStage();
+            vertexStage.module = moduleFor(watch.vertexSource);
+            VkPipelineShaderStageCreateInfo fragmentStage = builder.getFragmentStage();
+            fragmentStage.module = moduleFor(watch.fragmentSource);
+            builder.setVertexStage(vertexStage).setFragmentStage(fragmentStage);
+            built.push_back({watch.pipelineId, builder.build(device.device(), options.cache)});
+        } catch (const std::exception& e) {
+            failures.fetch_add(1, std::memory_order_relaxed);
+            if (logging::enabled(LogLevel::Warning)) {
+                std::cerr << "shader hot reload: rebuilding " << watch.vertexSource << " + " << watch.fragmentSource
+                          << " failed (" << e.what() << "), keeping the old pipeline\n";
+            }
+        }
+    }
+    for (const auto& [source, module]: modules) {
+        vkDestroyShaderModule(device.device(), module, nullptr);
+    }
+
+    if (logging::enabled(LogLevel::Info)) {
+        for (const std::string& source: compiled) {
+            std::cout << "shader hot reload: recompiled " << source << '\n';
+        }
+    }
+    reloads.fetch_add(built.size(), std::memory_order_relaxed);
+
+    std::lock_guard lock(readyMutex);
+    ready.insert(ready.end(), built.begin(), built.end());
+}
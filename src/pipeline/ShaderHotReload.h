@@ -0,0 +1,106 @@
+#ifndef SHADER_HOT_RELOAD_H
+#define SHADER_HOT_RELOAD_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "PipelineBuilder.h"
+
+class Device;
+class PipelineRegistry;
+
+// Development-time shader reload. A background thread watches the shader
+// sources with inotify, recompiles a changed file with glslc, and rebuilds
+// every watched pipeline that uses it from a copy of its PipelineBuilder. The
+// new pipelines only reach the registry in update(), which the render loop
+// calls at a frame boundary; the replaced ones go to the device's deletion
+// queue. A failed compile or build logs the error and keeps the old pipeline.
+//
+//     ShaderHotReload reload(device, registry);
+//     uint64_t id = PipelineRegistry::makeId(pipeline_state::keys::opaque, builder);
+//     registry.getOrCreate(pipeline_state::keys::opaque, builder);
+//     reload.watch(id, builder, "shader.vert", "shader.frag");
+//     while (running) {
+//         reload.update();
+//         ... record with registry.find(id) ...
+//     }
+//
+// Only available on Linux; elsewhere active() is false and update() does nothing.
+class ShaderHotReload {
+public:
+    struct Options {
+        std::string sourceDir = "src";
+        // compiled output lands here as <source>.spv, matching compile-shaders.py
+        std::string outputDir = "build";
+        std::string compiler = "glslc";
+        // editors often save in several writes; changes are batched for this long
+        std::chrono::milliseconds debounce{100};
+        VkPipelineCache cache = VK_NULL_HANDLE;
+    };
+
+    ShaderHotReload(Device& device, PipelineRegistry& registry);
+    ShaderHotReload(Device& device, PipelineRegistry& registry, Options options);
+    ~ShaderHotReload();
+
+    ShaderHotReload(const ShaderHotReload&) = delete;
+    ShaderHotReload& operator=(const ShaderHotReload&) = delete;
+
+    // Rebuilds `pipelineId` whenever either source changes. Sources are file
+    // names under sourceDir. Both stages are reloaded from their .spv on every
+    // rebuild, so the builder's own shader modules may already be destroyed.
+    void watch(uint64_t pipelineId, const PipelineBuilder& builder,
+               const std::string& vertexSource, const std::string& fragmentSource);
+
+    // Swaps in the pipelines that finished rebuilding and returns how many.
+    // Never waits on the reload thread; if it is busy publishing, the swap
+    // happens next frame.
+    size_t update();
+
+    [[nodiscard]] bool active() const { return watchThread.joinable(); }
+    [[nodiscard]] uint64_t reloadCount() const { return reloads.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t failureCount() const { return failures.load(std::memory_order_relaxed); }
+
+private:
+    struct Watch {
+        uint64_t pipelineId;
+        PipelineBuilder builder;
+        std::string vertexSource;
+        std::string fragmentSource;
+    };
+
+    struct Rebuilt {
+        uint64_t pipelineId;
+        VkPipeline pipeline;
+    };
+
+    Device& device;
+    PipelineRegistry& registry;
+    Options options;
+
+    std::mutex watchMutex;
+    std::vector<Watch> watches;
+
+    std::mutex readyMutex;
+    std::vector<Rebuilt> ready;
+
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> reloads{0};
+    std::atomic<uint64_t> failures{0};
+    int inotifyFd = -1;
+    std::thread watchThread;
+
+    void watchLoop();
+    void reload(const std::vector<std::string>& changed);
+    // false (with the compiler output logged) if the source does not compile
+    bool compile(const std::string& source);
+    VkShaderModule loadModule(const std::string& source);
+};
+
+#endif //SHADER_HOT_RELOAD_H
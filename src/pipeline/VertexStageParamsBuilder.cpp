@@ -20,11 +20,6 @@ VertexStageParamsBuilder& VertexStageParamsBuilder::setSpecializationInfo(const
     return *this;
 }
 
-VertexStageParamsBuilder& VertexStageParamsBuilder::setPushConstants(const std::vector<uint8_t>& pushData) {
-    pushConstants = pushData;
-    return *this;
-}
-
 VkPipelineShaderStageCreateInfo VertexStageParamsBuilder::build() const {
     VkPipelineShaderStageCreateInfo stageInfo{};
     stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -2,7 +2,6 @@
 #define VERTEX_STAGE_BUILDER_H
 
 #include <vulkan/vulkan.h>
-#include <vector>
 #include <optional>
 
 class VertexStageParamsBuilder {
@@ -11,7 +10,6 @@ public:
     VertexStageParamsBuilder& setEntryPoint(const char* entryPoint);
     VertexStageParamsBuilder& setFlags(VkPipelineShaderStageCreateFlags stageFlags);
     VertexStageParamsBuilder& setSpecializationInfo(const VkSpecializationInfo& specInfo);
-    VertexStageParamsBuilder& setPushConstants(const std::vector<uint8_t>& pushData);
 
     [[nodiscard]] VkPipelineShaderStageCreateInfo build() const;
 
@@ -22,7 +20,6 @@ private:
     std::optional<const char*> entryPointName;
     std::optional<VkPipelineShaderStageCreateFlags> flags;
     std::optional<VkSpecializationInfo> specializationInfo;
-    std::optional<std::vector<uint8_t>> pushConstants;
 
     static inline VkShaderModule defaultShaderModule = VK_NULL_HANDLE;
 };
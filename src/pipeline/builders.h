@@ -5,6 +5,7 @@
 #include "PipelineBuilder.h"
 #include "VertexStageParamsBuilder.h"
 #include "FragmentStageParamsBuilder.h"
+#include "PipelineVertexInputStateBuilder.h"
 #include "PipelineInputAssemblyStateBuilder.h"
 #include "PipelineRasterizationStateBuilder.h"
 #include "PipelineMultisampleStateBuilder.h"
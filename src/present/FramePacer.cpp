@@ -0,0 +1,109 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+    template<size_t N>
+    double percentile(const std::array<double, N>& values, size_t count, double fraction) {
+        std::array<double, N> sorted = values;
+        auto end = sorted.begin() + static_cast<std::ptrdiff_t>(count);
+        auto nth = sorted.begin() + static_cast<std::ptrdiff_t>(static_cast<double>(count - 1) * fraction);
+        std::nth_element(sorted.begin(), nth, end);
+        return *nth;
+    }
+}
+
+FramePacer::FramePacer(double targetFrameRate) {
+    setTargetFrameRate(targetFrameRate);
+}
+
+void FramePacer::setTargetFrameRate(double framesPerSecond) {
+    nextDeadline = {};
+    if (framesPerSecond <= 0.0) {
+        targetInterval = Clock::duration::zero();
+        return;
+    }
+    targetInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond));
+}
+
+void FramePacer::waitBeforeInput() {
+    if (targetInterval == Clock::duration::zero() || nextDeadline == Clock::time_point{}) {
+        return;
+    }
+
+    auto predictedWork = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::micro>(predictedWorkUs));
+    Clock::time_point wake = nextDeadline - predictedWork - safetyMargin;
+
+    // sleep coarsely, then yield through the last stretch where the scheduler is too imprecise
+    if (wake - Clock::now() > spinThreshold) {
+        std::this_thread::sleep_until(wake - spinThreshold);
+    }
+    while (Clock::now() < wake) {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::markInputSampled() {
+    inputSampled = Clock::now();
+    inputMarked = true;
+}
+
+void FramePacer::markPresented() {
+    Clock::time_point now = Clock::now();
+
+    if (inputMarked) {
+        double latencyUs = std::chrono::duration<double, std::micro>(now - inputSampled).count();
+        predictedWorkUs = predictedWorkUs == 0.0 ? latencyUs : predictedWorkUs * 0.9 + latencyUs * 0.1;
+        latenciesMs[latenciesRecorded % historySize] = latencyUs / 1000.0;
+        latenciesRecorded++;
+        inputMarked = false;
+    }
+
+    if (hasPresented) {
+        frameTimesMs[recorded % historySize] = std::chrono::duration<double, std::milli>(now - lastPresent).count();
+        recorded++;
+    }
+    lastPresent = now;
+    hasPresented = true;
+
+    if (targetInterval != Clock::duration::zero()) {
+        // re-anchoring on every present would let each frame's lateness push the next deadline back;
+        // only start over once a whole interval has been missed, rather than bursting to catch up
+        if (nextDeadline == Clock::time_point{} || now - nextDeadline > targetInterval) {
+            nextDeadline = now + targetInterval;
+        } else {
+            nextDeadline += targetInterval;
+        }
+    }
+}
+
+FramePacer::Stats FramePacer::stats() const {
+    Stats result{};
+    result.samples = std::min(recorded, historySize);
+    result.latencySamples = std::min(latenciesRecorded, historySize);
+
+    if (result.samples > 0) {
+        for (size_t i = 0; i < result.samples; i++) {
+            result.meanFrameMs += frameTimesMs[i];
+        }
+        result.meanFrameMs /= static_cast<double>(result.samples);
+
+        for (size_t i = 0; i < result.samples; i++) {
+            double delta = frameTimesMs[i] - result.meanFrameMs;
+            result.frameTimeVariance += delta * delta;
+        }
+        result.frameTimeVariance /= static_cast<double>(result.samples);
+        result.p99FrameMs = percentile(frameTimesMs, result.samples, 0.99);
+    }
+
+    if (result.latencySamples > 0) {
+        for (size_t i = 0; i < result.latencySamples; i++) {
+            result.meanLatencyMs += latenciesMs[i];
+        }
+        result.meanLatencyMs /= static_cast<double>(result.latencySamples);
+        result.p99LatencyMs = percentile(latenciesMs, result.latencySamples, 0.99);
+    }
+    return result;
+}
@@ -0,0 +1,68 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+// CPU-side frame limiter and latency tracker.
+//
+// Per frame the loop calls waitBeforeInput(), samples input, calls
+// markInputSampled(), records and submits, then calls markPresented() right
+// after vkQueuePresentKHR returns. With a target frame rate the pacer sleeps
+// until the latest point from which the predicted input-to-present time still
+// meets the next deadline, so input is as fresh as possible when the frame
+// goes out. Deadlines advance by exactly one interval per frame, so early or
+// late presents do not shift the paced rate. Latency is measured on the CPU up
+// to the present call, for frames that called markInputSampled().
+class FramePacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats {
+        double meanFrameMs;
+        double frameTimeVariance;
+        double p99FrameMs;
+        double meanLatencyMs;
+        double p99LatencyMs;
+        size_t samples;
+        size_t latencySamples;
+    };
+
+    // A target of 0 disables the limiter but keeps measuring.
+    explicit FramePacer(double targetFrameRate = 0.0);
+
+    void setTargetFrameRate(double framesPerSecond);
+
+    void waitBeforeInput();
+
+    void markInputSampled();
+
+    void markPresented();
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    static constexpr size_t historySize = 240;
+    // extra room left before the deadline to absorb prediction error and wake-up jitter
+    static constexpr std::chrono::microseconds safetyMargin{500};
+    static constexpr std::chrono::microseconds spinThreshold{1000};
+
+    Clock::duration targetInterval{};
+    // unset until the first paced present, and again after falling a whole interval behind
+    Clock::time_point nextDeadline{};
+    Clock::time_point lastPresent{};
+    Clock::time_point inputSampled{};
+    bool inputMarked = false;
+    bool hasPresented = false;
+
+    // exponential moving average of input-to-present time
+    double predictedWorkUs = 0.0;
+
+    std::array<double, historySize> frameTimesMs{};
+    std::array<double, historySize> latenciesMs{};
+    size_t recorded = 0;
+    size_t latenciesRecorded = 0;
+};
+
+#endif //FRAME_PACER_H
@@ -0,0 +1,40 @@
+#include "PresentPolicy.h"
+
+#include <algorithm>
+
+VkPresentModeKHR choosePresentMode(std::span<const VkPresentModeKHR> available, PresentPolicy policy) {
+    auto supported = [&](VkPresentModeKHR mode) {
+        return std::find(available.begin(), available.end(), mode) != available.end();
+    };
+
+    switch (policy) {
+        case PresentPolicy::Uncapped:
+            if (supported(VK_PRESENT_MODE_IMMEDIATE_KHR)) {
+                return VK_PRESENT_MODE_IMMEDIATE_KHR;
+            }
+            [[fallthrough]];
+        case PresentPolicy::LowLatency:
+            if (supported(VK_PRESENT_MODE_MAILBOX_KHR)) {
+                return VK_PRESENT_MODE_MAILBOX_KHR;
+            }
+            [[fallthrough]];
+        case PresentPolicy::VSync:
+            break;
+    }
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+const char* presentModeName(VkPresentModeKHR mode) {
+    switch (mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR:
+            return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR:
+            return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR:
+            return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+            return "fifo relaxed";
+        default:
+            return "unknown";
+    }
+}
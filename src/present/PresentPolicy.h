@@ -0,0 +1,22 @@
+#ifndef PRESENT_POLICY_H
+#define PRESENT_POLICY_H
+
+#include <span>
+#include <vulkan/vulkan_core.h>
+
+enum class PresentPolicy {
+    // FIFO: no tearing, frame rate locked to the display
+    VSync,
+    // MAILBOX: no tearing, newest frame wins, lowest latency without tearing
+    LowLatency,
+    // IMMEDIATE: may tear, never waits on the display
+    Uncapped,
+};
+
+// Picks the present mode for `policy` out of SwapChainSupportDetails::presentModes,
+// falling back towards FIFO, which every device supports.
+VkPresentModeKHR choosePresentMode(std::span<const VkPresentModeKHR> available, PresentPolicy policy);
+
+const char* presentModeName(VkPresentModeKHR mode);
+
+#endif //PRESENT_POLICY_H
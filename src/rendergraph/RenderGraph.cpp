@@ -0,0 +1,438 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "../device.h"
+
+namespace {
+    struct AccessInfo {
+        VkPipelineStageFlags2 stages;
+        VkAccessFlags2 access;
+        VkImageLayout layout;
+    };
+
+    AccessInfo accessInfo(ResourceAccess access) {
+        switch (access) {
+            case ResourceAccess::ColorAttachmentWrite:
+                return {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+            case ResourceAccess::DepthAttachmentWrite:
+                return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+            case ResourceAccess::DepthAttachmentRead:
+                return {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                        VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL};
+            case ResourceAccess::FragmentSampledRead:
+                return {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            case ResourceAccess::ComputeSampledRead:
+                return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+            case ResourceAccess::ComputeStorageWrite:
+                return {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                        VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_GENERAL};
+            case ResourceAccess::TransferSrc:
+                return {VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                        VK_ACCESS_2_TRANSFER_READ_BIT,
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+            case ResourceAccess::TransferDst:
+                return {VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                        VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+        }
+        throw std::runtime_error("unknown render graph access!");
+    }
+
+    VkImageMemoryBarrier2 imageBarrier(VkImage image, VkImageAspectFlags aspect,
+                                       VkPipelineStageFlags2 srcStages, VkAccessFlags2 srcAccess,
+                                       VkPipelineStageFlags2 dstStages, VkAccessFlags2 dstAccess,
+                                       VkImageLayout oldLayout, VkImageLayout newLayout) {
+        VkImageMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = srcStages;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstStageMask = dstStages;
+        barrier.dstAccessMask = dstAccess;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = {aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+        return barrier;
+    }
+}
+
+RenderResource RenderGraph::PassBuilder::read(RenderResource resource, ResourceAccess access) {
+    graph.passes[pass].uses.push_back({resource, access, false});
+    return resource;
+}
+
+RenderResource RenderGraph::PassBuilder::write(RenderResource resource, ResourceAccess access) {
+    graph.passes[pass].uses.push_back({resource, access, true});
+    return resource;
+}
+
+void RenderGraph::PassBuilder::sideEffect() {
+    graph.passes[pass].sideEffect = true;
+}
+
+RenderGraph::RenderGraph(Device& device) : device(device) {
+}
+
+RenderGraph::~RenderGraph() {
+    releaseTransients();
+}
+
+RenderResource RenderGraph::createImage(const std::string& name, const TransientImageDesc& desc) {
+    Resource& resource = resources.emplace_back();
+    resource.name = name;
+    resource.desc = desc;
+    resource.aspect = desc.aspect;
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+RenderResource RenderGraph::importImage(const std::string& name, VkImage image, VkImageView view,
+                                        VkImageAspectFlags aspect, VkImageLayout initialLayout,
+                                        VkImageLayout finalLayout) {
+    Resource& resource = resources.emplace_back();
+    resource.name = name;
+    resource.imported = true;
+    resource.image = image;
+    resource.view = view;
+    resource.aspect = aspect;
+    resource.initialLayout = initialLayout;
+    resource.finalLayout = finalLayout;
+    return static_cast<RenderResource>(resources.size() - 1);
+}
+
+void RenderGraph::addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup,
+                          ExecuteFn execute) {
+    Pass& pass = passes.emplace_back();
+    pass.name = name;
+    pass.execute = std::move(execute);
+    PassBuilder builder(*this, static_cast<uint32_t>(passes.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::compile() {
+    if (compiled) {
+        throw std::runtime_error("render graph is already compiled!");
+    }
+    cullPasses();
+    assignLevels();
+    computeLifetimes();
+    allocateTransients();
+    compiled = true;
+}
+
+void RenderGraph::cullPasses() {
+    std::vector<bool> needed(resources.size(), false);
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        needed[i] = resources[i].imported;
+    }
+
+    stats_.declaredPasses = static_cast<uint32_t>(passes.size());
+    stats_.culledPasses = 0;
+    for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass) {
+        bool contributes = pass->sideEffect || std::any_of(pass->uses.begin(), pass->uses.end(), [&](const Use& use) {
+            return use.write && needed[use.resource];
+        });
+        pass->culled = !contributes;
+        if (pass->culled) {
+            stats_.culledPasses++;
+            continue;
+        }
+        for (const Use& use: pass->uses) {
+            if (!use.write) {
+                needed[use.resource] = true;
+            }
+        }
+    }
+}
+
+void RenderGraph::assignLevels() {
+    // -1 means "no access yet"
+    std::vector<int> lastWriteLevel(resources.size(), -1);
+    std::vector<int> lastReadLevel(resources.size(), -1);
+    std::vector<VkImageLayout> readLayout(resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+
+    uint32_t levelCount = 0;
+    for (Pass& pass: passes) {
+        if (pass.culled) {
+            continue;
+        }
+
+        int level = 0;
+        for (const Use& use: pass.uses) {
+            level = std::max(level, lastWriteLevel[use.resource] + 1);
+            // writes wait for earlier readers, and so do reads that need another layout
+            if (use.write || (lastReadLevel[use.resource] >= 0 &&
+                              readLayout[use.resource] != accessInfo(use.access).layout)) {
+                level = std::max(level, lastReadLevel[use.resource] + 1);
+            }
+        }
+
+        for (const Use& use: pass.uses) {
+            if (use.write) {
+                lastWriteLevel[use.resource] = level;
+                lastReadLevel[use.resource] = -1;
+            } else {
+                lastReadLevel[use.resource] = std::max(lastReadLevel[use.resource], level);
+                readLayout[use.resource] = accessInfo(use.access).layout;
+            }
+        }
+
+        pass.level = static_cast<uint32_t>(level);
+        levelCount = std::max(levelCount, pass.level + 1);
+    }
+
+    levels.assign(levelCount, {});
+    for (uint32_t i = 0; i < passes.size(); i++) {
+        if (!passes[i].culled) {
+            levels[passes[i].level].push_back(i);
+        }
+    }
+    stats_.levels = levelCount;
+}
+
+void RenderGraph::computeLifetimes() {
+    for (const Pass& pass: passes) {
+        if (pass.culled) {
+            continue;
+        }
+        for (const Use& use: pass.uses) {
+            Resource& resource = resources[use.resource];
+            resource.firstLevel = std::min(resource.firstLevel, pass.level);
+            resource.lastLevel = std::max(resource.lastLevel, pass.level);
+        }
+    }
+}
+
+void RenderGraph::allocateTransients() {
+    std::vector<RenderResource> transients;
+    std::vector<VkMemoryRequirements> requirements(resources.size());
+
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        Resource& resource = resources[i];
+        if (resource.imported || resource.firstLevel == UINT32_MAX) {
+            continue;
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = resource.desc.format;
+        imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = resource.desc.samples;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = resource.desc.usage;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(device.device(), &imageInfo, nullptr, &resource.image) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create render graph image!");
+        }
+        vkGetImageMemoryRequirements(device.device(), resource.image, &requirements[i]);
+        transients.push_back(i);
+    }
+
+    // largest first so smaller images fall into the holes of bigger blocks
+    std::sort(transients.begin(), transients.end(), [&](RenderResource a, RenderResource b) {
+        return requirements[a].size > requirements[b].size;
+    });
+
+    stats_.unaliasedBytes = 0;
+    for (RenderResource i: transients) {
+        Resource& resource = resources[i];
+        const VkMemoryRequirements& requirement = requirements[i];
+        stats_.unaliasedBytes += requirement.size;
+
+        bool lazy = (resource.desc.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) &&
+                    device.hasMemoryType(requirement.memoryTypeBits,
+                                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                         VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
+        auto fits = [&](const MemoryBlock& block) {
+            if (block.lazy != lazy || (block.memoryTypeBits & requirement.memoryTypeBits) == 0) {
+                return false;
+            }
+            return std::none_of(block.residents.begin(), block.residents.end(), [&](RenderResource other) {
+                return resources[other].firstLevel <= resource.lastLevel &&
+                       resource.firstLevel <= resources[other].lastLevel;
+            });
+        };
+        auto block = std::find_if(memoryBlocks.begin(), memoryBlocks.end(), fits);
+        if (block == memoryBlocks.end()) {
+            block = memoryBlocks.insert(memoryBlocks.end(), MemoryBlock{});
+            block->lazy = lazy;
+        }
+
+        block->size = std::max(block->size, requirement.size);
+        block->memoryTypeBits &= requirement.memoryTypeBits;
+        block->residents.push_back(i);
+        resource.block = static_cast<uint32_t>(block - memoryBlocks.begin());
+    }
+
+    stats_.transientBytes = 0;
+    for (MemoryBlock& block: memoryBlocks) {
+        VkMemoryRequirements blockRequirements{};
+        blockRequirements.size = block.size;
+        blockRequirements.memoryTypeBits = block.memoryTypeBits;
+        VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        if (block.lazy) {
+            properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+        }
+        block.memory = device.allocateMemory(blockRequirements, properties);
+        if (block.memory == VK_NULL_HANDLE) {
+            throw std::runtime_error("failed to allocate render graph memory!");
+        }
+        stats_.transientBytes += block.size;
+
+        for (RenderResource i: block.residents) {
+            Resource& resource = resources[i];
+            vkBindImageMemory(device.device(), resource.image, block.memory, 0);
+
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = resource.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = resource.desc.format;
+            viewInfo.subresourceRange = {resource.aspect, 0, 1, 0, 1};
+            if (vkCreateImageView(device.device(), &viewInfo, nullptr, &resource.view) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create render graph image view!");
+            }
+        }
+    }
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer, std::pmr::memory_resource* scratch) {
+    if (!compiled) {
+        compile();
+    }
+
+    std::pmr::vector<State> states(resources.size(), scratch);
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        states[i] = {resources[i].initialLayout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE};
+    }
+    // what the previous occupants of each aliased block last did to it
+    std::pmr::vector<State> blockStates(
+        memoryBlocks.size(), {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE}, scratch);
+
+    stats_.barrierBatches = 0;
+    stats_.imageBarriers = 0;
+    std::pmr::vector<VkImageMemoryBarrier2> barriers(scratch);
+
+    auto flush = [&] {
+        if (barriers.empty()) {
+            return;
+        }
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+        dependencyInfo.pImageMemoryBarriers = barriers.data();
+        vkCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+        stats_.barrierBatches++;
+        stats_.imageBarriers += static_cast<uint32_t>(barriers.size());
+        barriers.clear();
+    };
+
+    for (uint32_t level = 0; level < levels.size(); level++) {
+        for (uint32_t passIndex: levels[level]) {
+            for (const Use& use: passes[passIndex].uses) {
+                Resource& resource = resources[use.resource];
+                State& state = states[use.resource];
+                AccessInfo info = accessInfo(use.access);
+
+                if (!resource.imported && level == resource.firstLevel && state.stages == VK_PIPELINE_STAGE_2_NONE) {
+                    // contents are undefined on first use; only wait for whoever used the memory before
+                    const State& previous = blockStates[resource.block];
+                    state = {VK_IMAGE_LAYOUT_UNDEFINED, previous.stages, previous.writeAccess};
+                }
+
+                bool transition = state.layout != info.layout;
+                bool hazard = state.writeAccess != VK_ACCESS_2_NONE ||
+                              (use.write && state.stages != VK_PIPELINE_STAGE_2_NONE);
+                if (transition || hazard) {
+                    barriers.push_back(imageBarrier(
+                        resource.image, resource.aspect,
+                        state.stages, state.writeAccess,
+                        info.stages, info.access,
+                        state.layout, info.layout));
+                    state = {info.layout, info.stages, use.write ? info.access : VK_ACCESS_2_NONE};
+                } else {
+                    // read-after-read in the same layout: later writers must wait on every reader
+                    state.stages |= info.stages;
+                }
+            }
+        }
+        flush();
+
+        for (uint32_t passIndex: levels[level]) {
+            passes[passIndex].execute(commandBuffer, *this);
+        }
+
+        for (RenderResource i = 0; i < resources.size(); i++) {
+            if (!resources[i].imported && resources[i].lastLevel == level && resources[i].block != UINT32_MAX) {
+                blockStates[resources[i].block] = states[i];
+            }
+        }
+    }
+
+    for (RenderResource i = 0; i < resources.size(); i++) {
+        const Resource& resource = resources[i];
+        if (resource.imported && resource.finalLayout != VK_IMAGE_LAYOUT_UNDEFINED &&
+            resource.finalLayout != states[i].layout) {
+            barriers.push_back(imageBarrier(
+                resource.image, resource.aspect,
+                states[i].stages, states[i].writeAccess,
+                VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                states[i].layout, resource.finalLayout));
+        }
+    }
+    flush();
+}
+
+void RenderGraph::reset() {
+    releaseTransients();
+    passes.clear();
+    resources.clear();
+    levels.clear();
+    compiled = false;
+    stats_ = {};
+}
+
+void RenderGraph::releaseTransients() {
+    // frames still in flight may be rendering into these
+    DeletionQueue& deletionQueue = device.deletionQueue();
+    for (Resource& resource: resources) {
+        if (resource.imported) {
+            continue;
+        }
+        deletionQueue.enqueue(resource.view);
+        deletionQueue.enqueue(resource.image);
+        resource.view = VK_NULL_HANDLE;
+        resource.image = VK_NULL_HANDLE;
+    }
+    for (MemoryBlock& block: memoryBlocks) {
+        deletionQueue.enqueue(block.memory);
+    }
+    memoryBlocks.clear();
+}
+
+VkImage RenderGraph::image(RenderResource resource) const {
+    return resources[resource].image;
+}
+
+VkImageView RenderGraph::view(RenderResource resource) const {
+    return resources[resource].view;
+}
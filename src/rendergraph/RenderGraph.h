@@ -0,0 +1,166 @@
+#ifndef RENDER_GRAPH_H
+#define RENDER_GRAPH_H
+
+#include <cstdint>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+class Device;
+
+using RenderResource = uint32_t;
+
+enum class ResourceAccess {
+    ColorAttachmentWrite,
+    DepthAttachmentWrite,
+    DepthAttachmentRead,
+    FragmentSampledRead,
+    ComputeSampledRead,
+    ComputeStorageWrite,
+    TransferSrc,
+    TransferDst,
+};
+
+struct TransientImageDesc {
+    VkFormat format;
+    VkExtent2D extent;
+    VkImageUsageFlags usage;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+};
+
+// Frame-level description of passes and the images they touch.
+//
+// Passes declare their reads and writes up front. compile() drops passes
+// whose results never reach an output, groups the rest into dependency levels
+// and lets transient images whose lifetimes do not overlap share memory.
+// execute() then records one vkCmdPipelineBarrier2 per level that covers every
+// layout transition and hazard of all the passes in it.
+class RenderGraph {
+public:
+    class PassBuilder {
+    public:
+        RenderResource read(RenderResource resource, ResourceAccess access);
+        RenderResource write(RenderResource resource, ResourceAccess access);
+
+        // Keeps the pass even if nothing it writes is consumed.
+        void sideEffect();
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, uint32_t pass) : graph(graph), pass(pass) {}
+
+        RenderGraph& graph;
+        uint32_t pass;
+    };
+
+    using ExecuteFn = std::function<void(VkCommandBuffer, const RenderGraph&)>;
+
+    struct Stats {
+        uint32_t declaredPasses;
+        uint32_t culledPasses;
+        uint32_t levels;
+        uint32_t barrierBatches;
+        uint32_t imageBarriers;
+        VkDeviceSize transientBytes;
+        // what the transients would occupy without aliasing
+        VkDeviceSize unaliasedBytes;
+    };
+
+    explicit RenderGraph(Device& device);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    RenderResource createImage(const std::string& name, const TransientImageDesc& desc);
+
+    // Imported images are graph outputs: passes writing them are never culled and
+    // the image is left in finalLayout after execute().
+    RenderResource importImage(const std::string& name, VkImage image, VkImageView view, VkImageAspectFlags aspect,
+                               VkImageLayout initialLayout, VkImageLayout finalLayout);
+
+    void addPass(const std::string& name, const std::function<void(PassBuilder&)>& setup, ExecuteFn execute);
+
+    void compile();
+
+    // Per-frame scratch (state tracking, barrier lists) comes from `scratch`, normally the frame arena.
+    void execute(VkCommandBuffer commandBuffer,
+                 std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
+
+    // Drops passes and resources, releasing transient memory.
+    void reset();
+
+    [[nodiscard]] VkImage image(RenderResource resource) const;
+    [[nodiscard]] VkImageView view(RenderResource resource) const;
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+
+private:
+    struct Use {
+        RenderResource resource;
+        ResourceAccess access;
+        bool write;
+    };
+
+    struct Pass {
+        std::string name;
+        ExecuteFn execute;
+        std::vector<Use> uses;
+        bool sideEffect = false;
+        bool culled = false;
+        uint32_t level = 0;
+    };
+
+    struct Resource {
+        std::string name;
+        bool imported = false;
+        TransientImageDesc desc{};
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        uint32_t firstLevel = UINT32_MAX;
+        uint32_t lastLevel = 0;
+        // index into memoryBlocks for transients
+        uint32_t block = UINT32_MAX;
+    };
+
+    struct MemoryBlock {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        uint32_t memoryTypeBits = ~0u;
+        // TRANSIENT_ATTACHMENT images live in lazily allocated memory when available
+        bool lazy = false;
+        std::vector<RenderResource> residents;
+    };
+
+    struct State {
+        VkImageLayout layout;
+        VkPipelineStageFlags2 stages;
+        VkAccessFlags2 writeAccess;
+    };
+
+    Device& device;
+    std::vector<Pass> passes;
+    std::vector<Resource> resources;
+    std::vector<MemoryBlock> memoryBlocks;
+    // kept passes grouped by level
+    std::vector<std::vector<uint32_t>> levels;
+    bool compiled = false;
+    Stats stats_{};
+
+    void cullPasses();
+
+    void assignLevels();
+
+    void computeLifetimes();
+
+    void allocateTransients();
+
+    void releaseTransients();
+};
+
+#endif //RENDER_GRAPH_H
@@ -0,0 +1,177 @@
+#include "MsaaTargets.h"
+
+#include <stdexcept>
+
+#include "../device.h"
+#include "../pipeline/PipelineMultisampleStateBuilder.h"
+
+MsaaTargets::MsaaTargets(Device& device, VkExtent2D extent, VkFormat colorFormat, VkImageLayout resolveFinalLayout,
+                         VkSampleCountFlagBits requestedSamples)
+    : device(device), extent(extent), colorFormat(colorFormat),
+      depthFormat_(device.findSupportedFormat(
+          {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+          VK_IMAGE_TILING_OPTIMAL,
+          VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)),
+      samples_(device.maxUsableSampleCount(requestedSamples)) {
+    if (samples_ != VK_SAMPLE_COUNT_1_BIT) {
+        color = createAttachment(colorFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT);
+    }
+    depth = createAttachment(depthFormat_, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT);
+    createRenderPass(resolveFinalLayout);
+}
+
+MsaaTargets::~MsaaTargets() {
+    vkDestroyRenderPass(device.device(), renderPass_, nullptr);
+    destroyAttachment(depth);
+    destroyAttachment(color);
+}
+
+MsaaTargets::Attachment MsaaTargets::createAttachment(VkFormat format, VkImageUsageFlags usage,
+                                                      VkImageAspectFlags aspect) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = {extent.width, extent.height, 1};
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = samples_;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = usage | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    Attachment attachment;
+    if (vkCreateImage(device.device(), &imageInfo, nullptr, &attachment.image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create multisampled attachment!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device.device(), attachment.image, &memRequirements);
+
+    VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (device.hasMemoryType(memRequirements.memoryTypeBits, properties | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)) {
+        properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+        lazy = true;
+    }
+    attachment.memory = device.allocateMemory(memRequirements, properties);
+    if (attachment.memory == VK_NULL_HANDLE) {
+        throw std::runtime_error("failed to allocate multisampled attachment memory!");
+    }
+    vkBindImageMemory(device.device(), attachment.image, attachment.memory, 0);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = attachment.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange = {aspect, 0, 1, 0, 1};
+    if (vkCreateImageView(device.device(), &viewInfo, nullptr, &attachment.view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create multisampled attachment view!");
+    }
+    return attachment;
+}
+
+void MsaaTargets::destroyAttachment(Attachment& attachment) {
+    // frames still in flight may be rendering into the attachment
+    DeletionQueue& deletionQueue = device.deletionQueue();
+    deletionQueue.enqueue(attachment.view);
+    deletionQueue.enqueue(attachment.image);
+    deletionQueue.enqueue(attachment.memory);
+    attachment = {};
+}
+
+void MsaaTargets::createRenderPass(VkImageLayout resolveFinalLayout) {
+    bool multisampled = samples_ != VK_SAMPLE_COUNT_1_BIT;
+
+    // with MSAA off the "resolve" target is rendered to directly
+    VkAttachmentDescription target{};
+    target.format = colorFormat;
+    target.samples = VK_SAMPLE_COUNT_1_BIT;
+    target.loadOp = multisampled ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR;
+    target.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    target.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    target.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    target.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    target.finalLayout = resolveFinalLayout;
+
+    VkAttachmentDescription depthAttachment{};
+    depthAttachment.format = depthFormat_;
+    depthAttachment.samples = samples_;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentDescription msaaColor{};
+    msaaColor.format = colorFormat;
+    msaaColor.samples = samples_;
+    msaaColor.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    // samples only live until the resolve at the end of the subpass
+    msaaColor.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    msaaColor.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    msaaColor.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    msaaColor.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    msaaColor.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentDescription attachments[] = {target, depthAttachment, msaaColor};
+
+    VkAttachmentReference targetRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+    VkAttachmentReference depthRef{1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+    VkAttachmentReference msaaColorRef{2, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = multisampled ? &msaaColorRef : &targetRef;
+    subpass.pResolveAttachments = multisampled ? &targetRef : nullptr;
+    subpass.pDepthStencilAttachment = &depthRef;
+
+    VkSubpassDependency dependency{};
+    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependency.dstSubpass = 0;
+    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = multisampled ? 3 : 2;
+    renderPassInfo.pAttachments = attachments;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+    renderPassInfo.dependencyCount = 1;
+    renderPassInfo.pDependencies = &dependency;
+
+    if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create multisampled render pass!");
+    }
+}
+
+VkFramebuffer MsaaTargets::createFramebuffer(VkImageView resolveView) const {
+    VkImageView attachments[] = {resolveView, depth.view, color.view};
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = renderPass_;
+    framebufferInfo.attachmentCount = samples_ != VK_SAMPLE_COUNT_1_BIT ? 3 : 2;
+    framebufferInfo.pAttachments = attachments;
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
+    framebufferInfo.layers = 1;
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(device.device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create multisampled framebuffer!");
+    }
+    return framebuffer;
+}
+
+VkPipelineMultisampleStateCreateInfo MsaaTargets::multisampleState() const {
+    return PipelineMultisampleStateBuilder(samples_).build();
+}
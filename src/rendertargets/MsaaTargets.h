@@ -0,0 +1,58 @@
+#ifndef MSAA_TARGETS_H
+#define MSAA_TARGETS_H
+
+#include <vulkan/vulkan_core.h>
+
+class Device;
+
+// Multisampled color and depth attachments plus a render pass that resolves
+// color into a single-sampled target at the end of the subpass. Both
+// multisampled attachments are TRANSIENT_ATTACHMENT images backed by
+// LAZILY_ALLOCATED memory where the device offers it, and are never stored,
+// so on tilers and software rasterizers the samples stay in tile memory.
+class MsaaTargets {
+public:
+    // requestedSamples is clamped to what the device supports; VK_SAMPLE_COUNT_1_BIT turns MSAA off.
+    MsaaTargets(Device& device, VkExtent2D extent, VkFormat colorFormat, VkImageLayout resolveFinalLayout,
+                VkSampleCountFlagBits requestedSamples);
+    ~MsaaTargets();
+
+    MsaaTargets(const MsaaTargets&) = delete;
+    MsaaTargets& operator=(const MsaaTargets&) = delete;
+
+    // Framebuffer over the multisampled attachments resolving into resolveView.
+    [[nodiscard]] VkFramebuffer createFramebuffer(VkImageView resolveView) const;
+
+    [[nodiscard]] VkPipelineMultisampleStateCreateInfo multisampleState() const;
+
+    [[nodiscard]] VkRenderPass renderPass() const { return renderPass_; }
+    [[nodiscard]] VkSampleCountFlagBits samples() const { return samples_; }
+    [[nodiscard]] VkFormat depthFormat() const { return depthFormat_; }
+    [[nodiscard]] bool lazilyAllocated() const { return lazy; }
+
+private:
+    struct Attachment {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+
+    Device& device;
+    VkExtent2D extent;
+    VkFormat colorFormat;
+    VkFormat depthFormat_;
+    VkSampleCountFlagBits samples_;
+    bool lazy = false;
+
+    Attachment color;
+    Attachment depth;
+    VkRenderPass renderPass_ = VK_NULL_HANDLE;
+
+    Attachment createAttachment(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect);
+
+    void destroyAttachment(Attachment& attachment);
+
+    void createRenderPass(VkImageLayout resolveFinalLayout);
+};
+
+#endif //MSAA_TARGETS_H
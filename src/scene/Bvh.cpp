@@ -0,0 +1,393 @@
+#include "Bvh.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+    // SAH splits below this depth, median splits beyond it, which bounds the
+    // depth (and the traversal stacks) for any input
+    constexpr uint32_t sahDepthLimit = 48;
+    constexpr uint32_t maxDepth = sahDepthLimit + 32;
+    constexpr uint32_t maxBinCount = 64;
+    // node visit cost relative to one entity box test
+    constexpr float traversalCost = 1.0f;
+
+    Vec3 min(Vec3 a, Vec3 b) { return {std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z)}; }
+    Vec3 max(Vec3 a, Vec3 b) { return {std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z)}; }
+
+    float axis(Vec3 v, int i) { return i == 0 ? v.x : i == 1 ? v.y : v.z; }
+
+    float area(Vec3 min, Vec3 max) {
+        Vec3 d = max - min;
+        if (d.x < 0.0f) {
+            return 0.0f;
+        }
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    enum class Side {
+        Outside,
+        Intersecting,
+        Inside,
+    };
+
+    // Tests the planes left in `mask` and clears the bits of planes the box is
+    // entirely in front of, so the subtree below skips them.
+    Side classify(const Frustum& frustum, Vec3 min, Vec3 max, uint32_t& mask) {
+        Vec3 center = (min + max) * 0.5f;
+        Vec3 extents = (max - min) * 0.5f;
+        for (uint32_t i = 0; i < frustum.planes.size(); i++) {
+            if (!(mask & (1u << i))) {
+                continue;
+            }
+            const Plane& p = frustum.planes[i];
+            float radius = extents.x * std::fabs(p.normal.x) + extents.y * std::fabs(p.normal.y) +
+                           extents.z * std::fabs(p.normal.z);
+            float distance = dot(p.normal, center) + p.distance;
+            if (distance < -radius) {
+                return Side::Outside;
+            }
+            if (distance >= radius) {
+                mask &= ~(1u << i);
+            }
+        }
+        return mask == 0 ? Side::Inside : Side::Intersecting;
+    }
+
+    // Entry distance of the ray into the box, or INFINITY on a miss.
+    float slab(Vec3 origin, Vec3 inverseDirection, Vec3 min, Vec3 max, float maxDistance) {
+        float tx1 = (min.x - origin.x) * inverseDirection.x, tx2 = (max.x - origin.x) * inverseDirection.x;
+        float ty1 = (min.y - origin.y) * inverseDirection.y, ty2 = (max.y - origin.y) * inverseDirection.y;
+        float tz1 = (min.z - origin.z) * inverseDirection.z, tz2 = (max.z - origin.z) * inverseDirection.z;
+        float entry = std::max({std::min(tx1, tx2), std::min(ty1, ty2), std::min(tz1, tz2), 0.0f});
+        float exit = std::min({std::max(tx1, tx2), std::max(ty1, ty2), std::max(tz1, tz2), maxDistance});
+        return entry <= exit ? entry : INFINITY;
+    }
+}
+
+Bvh::Bvh(Options options) : options(options) {
+    if (options.binCount < 2 || options.binCount > maxBinCount) {
+        throw std::invalid_argument("Bvh binCount must be between 2 and 64");
+    }
+    this->options.maxLeafSize = std::max(options.maxLeafSize, 1u);
+}
+
+void Bvh::build(const Scene& scene) {
+    uint32_t count = scene.size();
+    std::span<const float> bounds[6];
+    for (uint32_t field = 0; field < 6; field++) {
+        bounds[field] = scene.worldBoundsColumn(field);
+    }
+    std::vector<BuildItem> items(count);
+    for (uint32_t i = 0; i < count; i++) {
+        Vec3 center{bounds[0][i], bounds[1][i], bounds[2][i]};
+        Vec3 extents{bounds[3][i], bounds[4][i], bounds[5][i]};
+        items[i] = {{center - extents, center + extents}, center, i};
+    }
+
+    nodes_.clear();
+    if (count > 0) {
+        nodes_.reserve(2 * count / options.maxLeafSize + 1);
+        bins.resize(3 * options.binCount);
+        buildNode(items, 0, count, 0);
+    }
+
+    std::span<const Entity> sceneEntities = scene.entities();
+    entities_.resize(count);
+    boxes.resize(count);
+    denseIndices.resize(count);
+    leafPositions.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        entities_[i] = sceneEntities[items[i].dense];
+        boxes[i] = items[i].box;
+        denseIndices[i] = items[i].dense;
+        leafPositions[items[i].dense] = i;
+    }
+
+    builtLayout = scene.layoutVersion();
+    currentCost = builtCost = computeCost();
+    refitsSinceBuild = 0;
+}
+
+uint32_t Bvh::buildNode(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t depth) {
+    uint32_t index = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+
+    Box bounds, centroidBounds;
+    for (uint32_t i = begin; i < end; i++) {
+        bounds.min = min(bounds.min, items[i].box.min);
+        bounds.max = max(bounds.max, items[i].box.max);
+        centroidBounds.min = min(centroidBounds.min, items[i].centroid);
+        centroidBounds.max = max(centroidBounds.max, items[i].centroid);
+    }
+    nodes_[index].min = bounds.min;
+    nodes_[index].max = bounds.max;
+
+    uint32_t count = end - begin;
+    auto makeLeaf = [&] {
+        nodes_[index].offset = begin;
+        nodes_[index].count = count;
+        return index;
+    };
+    if (count <= options.maxLeafSize) {
+        return makeLeaf();
+    }
+
+    // Binned SAH: drop the centroids into equal-width bins on each axis in one
+    // pass, then evaluate the split between every pair of neighbouring bins.
+    const uint32_t binCount = options.binCount;
+    float lo[3], scale[3];
+    for (int a = 0; a < 3; a++) {
+        lo[a] = axis(centroidBounds.min, a);
+        float width = axis(centroidBounds.max, a) - lo[a];
+        scale[a] = width > 0.0f ? binCount / width : 0.0f;
+    }
+    auto binOf = [&](const BuildItem& item, int a) {
+        return std::min(static_cast<uint32_t>((axis(item.centroid, a) - lo[a]) * scale[a]), binCount - 1);
+    };
+
+    int bestAxis = -1;
+    uint32_t bestSplit = 0;
+    float bestCost = INFINITY;
+    if (depth < sahDepthLimit) {
+        std::fill(bins.begin(), bins.end(), Bin{});
+        for (uint32_t i = begin; i < end; i++) {
+            for (int a = 0; a < 3; a++) {
+                Bin& bin = bins[a * binCount + binOf(items[i], a)];
+                bin.count++;
+                bin.box.min = min(bin.box.min, items[i].box.min);
+                bin.box.max = max(bin.box.max, items[i].box.max);
+            }
+        }
+
+        for (int a = 0; a < 3; a++) {
+            if (scale[a] == 0.0f) {
+                continue;
+            }
+            const Bin* axisBins = &bins[a * binCount];
+            // sweep from the right storing areas, then from the left evaluating each split
+            float rightAreas[maxBinCount];
+            Box right;
+            for (uint32_t b = binCount - 1; b > 0; b--) {
+                right.min = min(right.min, axisBins[b].box.min);
+                right.max = max(right.max, axisBins[b].box.max);
+                rightAreas[b] = area(right.min, right.max);
+            }
+            Box left;
+            uint32_t leftCount = 0;
+            for (uint32_t split = 1; split < binCount; split++) {
+                left.min = min(left.min, axisBins[split - 1].box.min);
+                left.max = max(left.max, axisBins[split - 1].box.max);
+                leftCount += axisBins[split - 1].count;
+                float cost = area(left.min, left.max) * leftCount + rightAreas[split] * (count - leftCount);
+                if (leftCount > 0 && leftCount < count && cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = a;
+                    bestSplit = split;
+                }
+            }
+        }
+    }
+
+    uint32_t middle;
+    if (bestAxis >= 0) {
+        float nodeArea = area(bounds.min, bounds.max);
+        float splitCost = traversalCost + (nodeArea > 0.0f ? bestCost / nodeArea : static_cast<float>(count));
+        if (splitCost >= static_cast<float>(count) && count <= 4 * options.maxLeafSize) {
+            return makeLeaf();
+        }
+        auto split = std::partition(items.begin() + begin, items.begin() + end,
+                                    [&](const BuildItem& item) { return binOf(item, bestAxis) < bestSplit; });
+        middle = static_cast<uint32_t>(split - items.begin());
+    } else {
+        // coincident centroids or too deep: halve along the widest axis
+        Vec3 extent = centroidBounds.max - centroidBounds.min;
+        int widest = extent.x >= extent.y && extent.x >= extent.z ? 0 : extent.y >= extent.z ? 1 : 2;
+        middle = begin + count / 2;
+        std::nth_element(items.begin() + begin, items.begin() + middle, items.begin() + end,
+                         [&](const BuildItem& l, const BuildItem& r) {
+                             return axis(l.centroid, widest) < axis(r.centroid, widest);
+                         });
+    }
+
+    buildNode(items, begin, middle, depth + 1);
+    uint32_t right = buildNode(items, middle, end, depth + 1);
+    nodes_[index].offset = right;
+    return index;
+}
+
+bool Bvh::refit(const Scene& scene) {
+    if (scene.layoutVersion() != builtLayout) {
+        return false;
+    }
+
+    std::span<const float> bounds[6];
+    for (uint32_t field = 0; field < 6; field++) {
+        bounds[field] = scene.worldBoundsColumn(field);
+    }
+    for (uint32_t i = 0; i < scene.size(); i++) {
+        Vec3 center{bounds[0][i], bounds[1][i], bounds[2][i]};
+        Vec3 extents{bounds[3][i], bounds[4][i], bounds[5][i]};
+        boxes[leafPositions[i]] = {center - extents, center + extents};
+    }
+    // children always come after their parent
+    for (size_t i = nodes_.size(); i-- > 0;) {
+        Node& node = nodes_[i];
+        Box box;
+        if (node.count > 0) {
+            for (uint32_t e = node.offset; e < node.offset + node.count; e++) {
+                box.min = min(box.min, boxes[e].min);
+                box.max = max(box.max, boxes[e].max);
+            }
+        } else {
+            const Node& left = nodes_[i + 1];
+            const Node& right = nodes_[node.offset];
+            box = {min(left.min, right.min), max(left.max, right.max)};
+        }
+        node.min = box.min;
+        node.max = box.max;
+    }
+
+    currentCost = computeCost();
+    refitsSinceBuild++;
+    return true;
+}
+
+bool Bvh::update(const Scene& scene) {
+    bool rebuild = !refit(scene) || (options.rebuildInterval > 0 && refitsSinceBuild >= options.rebuildInterval) ||
+                   currentCost > builtCost * options.rebuildCostRatio;
+    if (rebuild) {
+        build(scene);
+    }
+    return rebuild;
+}
+
+float Bvh::computeCost() const {
+    if (nodes_.empty()) {
+        return 0.0f;
+    }
+    float rootArea = area(nodes_[0].min, nodes_[0].max);
+    if (rootArea <= 0.0f) {
+        return static_cast<float>(entities_.size());
+    }
+    float total = 0.0f;
+    for (const Node& node: nodes_) {
+        total += area(node.min, node.max) * (node.count > 0 ? static_cast<float>(node.count) : traversalCost);
+    }
+    return total / rootArea;
+}
+
+void Bvh::emit(const Scene& scene, uint32_t first, uint32_t end, const Plane& near,
+               std::vector<DrawItem>& visible) const {
+    std::span<const RenderHandle> renders = scene.renderHandles();
+    for (uint32_t e = first; e < end; e++) {
+        Vec3 center = (boxes[e].min + boxes[e].max) * 0.5f;
+        visible.push_back({entities_[e], renders[denseIndices[e]], dot(near.normal, center) + near.distance,
+                           length(boxes[e].max - boxes[e].min) * 0.5f});
+    }
+}
+
+void Bvh::cull(const Scene& scene, const Frustum& frustum, std::vector<DrawItem>& visible) const {
+    if (scene.layoutVersion() != builtLayout) {
+        throw std::logic_error("Bvh::cull on a tree built for an older scene layout; call update() first");
+    }
+    if (nodes_.empty()) {
+        return;
+    }
+    const Plane& near = frustum.planes[4];
+    struct Entry {
+        uint32_t node;
+        uint32_t mask;
+    };
+    Entry stack[maxDepth + 1];
+    uint32_t top = 0;
+    stack[top++] = {0, (1u << frustum.planes.size()) - 1};
+
+    while (top > 0) {
+        Entry entry = stack[--top];
+        const Node& node = nodes_[entry.node];
+        Side side = classify(frustum, node.min, node.max, entry.mask);
+        if (side == Side::Outside) {
+            continue;
+        }
+        if (side == Side::Inside) {
+            // the subtree's entries run from its leftmost leaf to the end of its rightmost
+            uint32_t first = entry.node;
+            while (nodes_[first].count == 0) {
+                first++;
+            }
+            uint32_t last = entry.node;
+            while (nodes_[last].count == 0) {
+                last = nodes_[last].offset;
+            }
+            emit(scene, nodes_[first].offset, nodes_[last].offset + nodes_[last].count, near, visible);
+            continue;
+        }
+        if (node.count > 0) {
+            for (uint32_t e = node.offset; e < node.offset + node.count; e++) {
+                uint32_t mask = entry.mask;
+                if (classify(frustum, boxes[e].min, boxes[e].max, mask) != Side::Outside) {
+                    emit(scene, e, e + 1, near, visible);
+                }
+            }
+            continue;
+        }
+        stack[top++] = {node.offset, entry.mask};
+        stack[top++] = {entry.node + 1, entry.mask};
+    }
+}
+
+std::optional<RayHit> Bvh::raycast(const Ray& ray) const {
+    if (nodes_.empty()) {
+        return std::nullopt;
+    }
+    // 1 / 0 gives an infinity, which the slab test handles
+    Vec3 inverse{1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+    std::optional<RayHit> best;
+    float bestDistance = ray.maxDistance;
+
+    struct Entry {
+        uint32_t node;
+        float distance;
+    };
+    Entry stack[maxDepth + 1];
+    uint32_t top = 0;
+    float rootDistance = slab(ray.origin, inverse, nodes_[0].min, nodes_[0].max, bestDistance);
+    if (rootDistance < INFINITY) {
+        stack[top++] = {0, rootDistance};
+    }
+    while (top > 0) {
+        Entry entry = stack[--top];
+        // a closer hit may have been found since this node was pushed
+        if (entry.distance >= bestDistance) {
+            continue;
+        }
+        const Node& node = nodes_[entry.node];
+        if (node.count > 0) {
+            for (uint32_t e = node.offset; e < node.offset + node.count; e++) {
+                float distance = slab(ray.origin, inverse, boxes[e].min, boxes[e].max, bestDistance);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = RayHit{entities_[e], distance};
+                }
+            }
+            continue;
+        }
+
+        // visit the nearer child first so the farther one is more likely pruned
+        Entry near{entry.node + 1, slab(ray.origin, inverse, nodes_[entry.node + 1].min, nodes_[entry.node + 1].max,
+                                        bestDistance)};
+        Entry far{node.offset, slab(ray.origin, inverse, nodes_[node.offset].min, nodes_[node.offset].max,
+                                    bestDistance)};
+        if (far.distance < near.distance) {
+            std::swap(near, far);
+        }
+        if (far.distance < bestDistance) {
+            stack[top++] = far;
+        }
+        if (near.distance < bestDistance) {
+            stack[top++] = near;
+        }
+    }
+    return best;
+}
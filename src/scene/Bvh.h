@@ -0,0 +1,134 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "../math/Math.h"
+#include "Scene.h"
+
+// One entity that survived culling, ready for draw submission.
+struct DrawItem {
+    Entity entity;
+    RenderHandle render;
+    // distance of the bounds center in front of the near plane, for sorting
+    float depth = 0.0f;
+    // half the diagonal of the world bounds
+    float radius = 0.0f;
+    // level of detail to draw, set by LodSelector
+    uint32_t lod = 0;
+};
+
+struct Ray {
+    Vec3 origin;
+    // need not be normalized; hit distances are in units of its length
+    Vec3 direction{0.0f, 0.0f, -1.0f};
+    float maxDistance = INFINITY;
+};
+
+struct RayHit {
+    Entity entity;
+    float distance = 0.0f;
+};
+
+// Bounding volume hierarchy over a Scene's world bounds.
+//
+// build() splits with a binned surface area heuristic. Moving objects are
+// handled by refit(), which recomputes the boxes bottom-up without changing
+// the tree; as objects drift the boxes overlap more, so update() rebuilds
+// once the tree's SAH cost has grown past Options::rebuildCostRatio of the
+// cost it was built with, or when the scene's dense order changed (entities
+// created or destroyed, or the hierarchy re-sorted).
+//
+// Nodes are 32 bytes, stored depth first: a node's left child follows it
+// directly and only the right child is referenced by index, and the
+// entities of every subtree are contiguous.
+class Bvh {
+public:
+    struct Options {
+        // a node with at most this many entities is never split
+        uint32_t maxLeafSize = 4;
+        uint32_t binCount = 16;
+        float rebuildCostRatio = 1.3f;
+        // rebuild after this many refits regardless of cost; 0 disables
+        uint32_t rebuildInterval = 0;
+    };
+
+    struct Node {
+        Vec3 min;
+        // leaf: first entry in entities(); interior: index of the right child
+        uint32_t offset = 0;
+        Vec3 max;
+        // entity count of a leaf, 0 for interior nodes
+        uint32_t count = 0;
+    };
+
+    Bvh() : Bvh(Options{}) {}
+    explicit Bvh(Options options);
+
+    // Builds over every entity of `scene`, using the world bounds from its last propagate().
+    void build(const Scene& scene);
+
+    // Recomputes node boxes from the scene's current world bounds. Returns
+    // false, leaving the tree untouched, if the scene's layoutVersion() moved
+    // since the build.
+    bool refit(const Scene& scene);
+
+    // Refits or rebuilds, whichever the scene needs. Returns true after a rebuild.
+    bool update(const Scene& scene);
+
+    // Appends the entities whose world bounds intersect `frustum`. Call update()
+    // after the scene's propagate() and before culling: a tree built for an
+    // older layoutVersion() would index the wrong render handles, so cull throws.
+    void cull(const Scene& scene, const Frustum& frustum, std::vector<DrawItem>& visible) const;
+
+    // Closest entity whose world bounds the ray enters within maxDistance.
+    [[nodiscard]] std::optional<RayHit> raycast(const Ray& ray) const;
+
+    // Expected cost of a random query relative to testing the root: interior
+    // nodes count 1 and leaves their entity count, weighted by surface area.
+    [[nodiscard]] float cost() const { return currentCost; }
+
+    [[nodiscard]] const std::vector<Node>& nodes() const { return nodes_; }
+    [[nodiscard]] const std::vector<Entity>& entities() const { return entities_; }
+
+private:
+    struct Box {
+        Vec3 min{INFINITY, INFINITY, INFINITY};
+        Vec3 max{-INFINITY, -INFINITY, -INFINITY};
+    };
+
+    // build input, partitioned in place so every split scans contiguous memory
+    struct BuildItem {
+        Box box;
+        Vec3 centroid;
+        uint32_t dense;
+    };
+
+    struct Bin {
+        Box box;
+        uint32_t count = 0;
+    };
+
+    Options options;
+    std::vector<Node> nodes_;
+    // entity, box and scene dense index of each entry, in leaf order
+    std::vector<Entity> entities_;
+    std::vector<Box> boxes;
+    std::vector<uint32_t> denseIndices;
+    // leaf order position of each dense index, so refit() reads the scene sequentially
+    std::vector<uint32_t> leafPositions;
+    // scratch for buildNode(): binCount bins per axis
+    std::vector<Bin> bins;
+    uint64_t builtLayout = 0;
+    float builtCost = 0.0f;
+    float currentCost = 0.0f;
+    uint32_t refitsSinceBuild = 0;
+
+    uint32_t buildNode(std::vector<BuildItem>& items, uint32_t begin, uint32_t end, uint32_t depth);
+    float computeCost() const;
+    void emit(const Scene& scene, uint32_t first, uint32_t end, const Plane& near, std::vector<DrawItem>& visible) const;
+};
+
+#endif //BVH_H
@@ -0,0 +1,72 @@
+#include "LodSelector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+LodSelector::LodSelector(Options options) : options(options) {
+}
+
+void LodSelector::setProjection(float fovY, float viewportHeight) {
+    pixelsPerUnit = viewportHeight / (2.0f * std::tan(fovY * 0.5f));
+}
+
+void LodSelector::setMeshLods(uint32_t mesh, std::span<const float> errors, float radius) {
+    if (!(radius > 0.0f)) {
+        throw std::invalid_argument("mesh radius must be positive");
+    }
+    if (mesh >= meshErrors.size()) {
+        meshErrors.resize(mesh + 1);
+    }
+    meshErrors[mesh].clear();
+    for (float error: errors) {
+        meshErrors[mesh].push_back(error / radius);
+    }
+}
+
+float LodSelector::projectedSize(float length, float distance) const {
+    return distance > 0.0f ? length * pixelsPerUnit / distance : INFINITY;
+}
+
+uint32_t LodSelector::select(std::span<const float> errors, float distance, uint32_t current) const {
+    if (errors.size() < 2) {
+        return 0;
+    }
+    float enter = options.pixelError * (1.0f - options.hysteresis);
+    float leave = options.pixelError * (1.0f + options.hysteresis);
+
+    // refine while the current level is clearly too coarse
+    uint32_t lod = std::min<uint32_t>(current, static_cast<uint32_t>(errors.size() - 1));
+    while (lod > 0 && projectedSize(errors[lod], distance) > leave) {
+        lod--;
+    }
+    if (lod < current) {
+        return lod;
+    }
+    // coarsen only past the margin
+    while (lod + 1 < errors.size() && projectedSize(errors[lod + 1], distance) <= enter) {
+        lod++;
+    }
+    return lod;
+}
+
+void LodSelector::select(std::span<DrawItem> items) {
+    for (DrawItem& item: items) {
+        if (item.render.mesh >= meshErrors.size() || meshErrors[item.render.mesh].size() < 2) {
+            item.lod = 0;
+            continue;
+        }
+
+        // with errors relative to the radius, scaling the mesh to the world
+        // is the same as measuring the distance in radii
+        float distance = item.depth - item.radius;
+        float scaledDistance = item.radius > 0.0f ? distance / item.radius : INFINITY;
+
+        if (item.entity.index >= currentLods.size()) {
+            currentLods.resize(item.entity.index + 1, 0);
+        }
+        uint8_t& current = currentLods[item.entity.index];
+        item.lod = select(meshErrors[item.render.mesh], scaledDistance, current);
+        current = static_cast<uint8_t>(item.lod);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef LOD_SELECTOR_H
+#define LOD_SELECTOR_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Bvh.h"
+
+// Picks each visible entity's level of detail from the screen-space size of
+// its mesh's simplification error: the coarsest LOD whose object-space error
+// (mesh_format::Lod::error), scaled to the world and projected at the nearest
+// distance of its bounds, stays below Options::pixelError.
+//
+// The object's scale is taken as DrawItem::radius over the radius of the mesh
+// bounds, which needs nothing beyond what culling already produced. World
+// bounds enclose the rotated mesh bounds, so a rotated object can get a
+// somewhat finer level than an axis-aligned one, never a coarser.
+//
+// The choice is sticky. A coarser level is only taken once its error is a
+// margin below the threshold, and the current one is kept until its error is
+// the same margin above it. An object hovering around a switching distance
+// therefore does not pop back and forth every frame.
+class LodSelector {
+public:
+    struct Options {
+        // largest acceptable projected error, in pixels
+        float pixelError = 1.0f;
+        // the margin, as a fraction of pixelError
+        float hysteresis = 0.25f;
+    };
+
+    LodSelector() : LodSelector(Options{}) {}
+    explicit LodSelector(Options options);
+
+    // `fovY` in radians, `viewportHeight` in pixels.
+    void setProjection(float fovY, float viewportHeight);
+
+    // The LOD errors of the mesh that RenderHandle::mesh == `mesh` refers to,
+    // finest first, and the half diagonal of its bounds.
+    void setMeshLods(uint32_t mesh, std::span<const float> errors, float radius);
+
+    // Pixels covered by an object-space length at `distance` in front of the camera.
+    [[nodiscard]] float projectedSize(float length, float distance) const;
+
+    // The level to draw for a mesh with `errors` at `distance`, given the level drawn last time.
+    [[nodiscard]] uint32_t select(std::span<const float> errors, float distance, uint32_t current) const;
+
+    // Sets DrawItem::lod of every item and remembers it for the entity's next
+    // selection. Items of meshes without LODs get level 0.
+    void select(std::span<DrawItem> items);
+
+private:
+    Options options;
+    // pixels per unit of length at distance 1
+    float pixelsPerUnit = 1.0f;
+    // errors in units of the mesh radius
+    std::vector<std::vector<float>> meshErrors;
+    // last level chosen, by Entity::index
+    std::vector<uint8_t> currentLods;
+};
+
+#endif //LOD_SELECTOR_H
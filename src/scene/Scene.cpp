@@ -0,0 +1,345 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "../jobs/JobSystem.h"
+
+namespace {
+    template<typename T>
+    void permute(std::vector<T>& column, const std::vector<uint32_t>& order) {
+        std::vector<T> sorted;
+        sorted.reserve(column.size());
+        for (uint32_t from: order) {
+            sorted.push_back(column[from]);
+        }
+        column.swap(sorted);
+    }
+
+    template<typename T>
+    void swapRemove(std::vector<T>& column, uint32_t index) {
+        column[index] = column.back();
+        column.pop_back();
+    }
+}
+
+template<typename F>
+void Scene::forEachColumn(F&& function) {
+    function(entityColumn);
+    function(parentColumn);
+    function(parentIndexColumn);
+    for (FloatColumn& column: localColumns) {
+        function(column);
+    }
+    for (FloatColumn& column: localBoundsColumns) {
+        function(column);
+    }
+    for (FloatColumn& column: worldColumns) {
+        function(column);
+    }
+    for (FloatColumn& column: worldBoundsColumns) {
+        function(column);
+    }
+    function(radiusColumn);
+    function(renderColumn);
+}
+
+void Scene::reserve(size_t count) {
+    slots.reserve(count);
+    forEachColumn([count](auto& column) { column.reserve(count); });
+}
+
+Entity Scene::create(const Transform& local, const Bounds& bounds, RenderHandle render) {
+    uint32_t index;
+    if (!freeSlots.empty()) {
+        index = freeSlots.back();
+        freeSlots.pop_back();
+    } else {
+        index = static_cast<uint32_t>(slots.size());
+        slots.emplace_back();
+    }
+    Entity entity{index, slots[index].generation};
+    slots[index].dense = size();
+
+    entityColumn.push_back(entity);
+    parentColumn.push_back({});
+    parentIndexColumn.push_back(noParent);
+    for (FloatColumn& column: localColumns) {
+        column.emplace_back();
+    }
+    for (FloatColumn& column: localBoundsColumns) {
+        column.emplace_back();
+    }
+    // identity until the next propagate()
+    for (uint32_t element = 0; element < worldColumns.size(); element++) {
+        worldColumns[element].push_back(element % 5 == 0 ? 1.0f : 0.0f);
+    }
+    for (FloatColumn& column: worldBoundsColumns) {
+        column.emplace_back();
+    }
+    radiusColumn.emplace_back();
+    renderColumn.push_back(render);
+
+    setLocal(entity, local);
+    setLocalBounds(entity, bounds);
+    layoutChanges++;
+
+    // a root appended after deeper levels breaks the depth order
+    if (parentedCount > 0) {
+        hierarchyDirty = true;
+    }
+    return entity;
+}
+
+void Scene::destroy(Entity entity) {
+    uint32_t dense = denseIndex(entity);
+    if (parentColumn[dense] != Entity{}) {
+        parentedCount--;
+    }
+
+    slots[entityColumn.back().index].dense = dense;
+    forEachColumn([dense](auto& column) { swapRemove(column, dense); });
+
+    slots[entity.index].dense = noParent;
+    slots[entity.index].generation++;
+    freeSlots.push_back(entity.index);
+    layoutChanges++;
+
+    // the move breaks the depth order and parent indices; orphaned children are
+    // found by sortByDepth(), and any child would have kept parentedCount above 0
+    if (parentedCount > 0) {
+        hierarchyDirty = true;
+    }
+}
+
+bool Scene::alive(Entity entity) const {
+    return entity.index < slots.size() && slots[entity.index].generation == entity.generation &&
+           slots[entity.index].dense != noParent;
+}
+
+uint32_t Scene::denseIndex(Entity entity) const {
+    if (!alive(entity)) {
+        throw std::invalid_argument("stale or invalid entity handle");
+    }
+    return slots[entity.index].dense;
+}
+
+Transform Scene::local(Entity entity) const {
+    uint32_t i = denseIndex(entity);
+    const auto& c = localColumns;
+    return {{c[0][i], c[1][i], c[2][i]}, {c[3][i], c[4][i], c[5][i], c[6][i]}, {c[7][i], c[8][i], c[9][i]}};
+}
+
+void Scene::setLocal(Entity entity, const Transform& local) {
+    uint32_t i = denseIndex(entity);
+    const float values[10] = {local.position.x, local.position.y, local.position.z,
+                              local.rotation.x, local.rotation.y, local.rotation.z, local.rotation.w,
+                              local.scale.x, local.scale.y, local.scale.z};
+    for (size_t field = 0; field < localColumns.size(); field++) {
+        localColumns[field][i] = values[field];
+    }
+}
+
+Bounds Scene::localBounds(Entity entity) const {
+    uint32_t i = denseIndex(entity);
+    const auto& c = localBoundsColumns;
+    return {{c[0][i], c[1][i], c[2][i]}, {c[3][i], c[4][i], c[5][i]}};
+}
+
+void Scene::setLocalBounds(Entity entity, const Bounds& bounds) {
+    uint32_t i = denseIndex(entity);
+    const float values[6] = {bounds.center.x, bounds.center.y, bounds.center.z,
+                             bounds.extents.x, bounds.extents.y, bounds.extents.z};
+    for (size_t field = 0; field < localBoundsColumns.size(); field++) {
+        localBoundsColumns[field][i] = values[field];
+    }
+}
+
+Affine Scene::world(Entity entity) const {
+    uint32_t i = denseIndex(entity);
+    Affine result;
+    for (size_t element = 0; element < worldColumns.size(); element++) {
+        result.m[element] = worldColumns[element][i];
+    }
+    return result;
+}
+
+Bounds Scene::worldBounds(Entity entity) const {
+    uint32_t i = denseIndex(entity);
+    const auto& c = worldBoundsColumns;
+    return {{c[0][i], c[1][i], c[2][i]}, {c[3][i], c[4][i], c[5][i]}};
+}
+
+void Scene::setParent(Entity child, Entity parent) {
+    uint32_t dense = denseIndex(child);
+    if (parent != Entity{}) {
+        if (!alive(parent)) {
+            throw std::invalid_argument("stale or invalid entity handle");
+        }
+        // walk up from the new parent; meeting the child would close a loop
+        for (Entity ancestor = parent; alive(ancestor); ancestor = parentColumn[slots[ancestor.index].dense]) {
+            if (ancestor == child) {
+                throw std::invalid_argument("setParent would create a cycle");
+            }
+        }
+    }
+
+    bool hadParent = parentColumn[dense] != Entity{};
+    bool hasParent = parent != Entity{};
+    parentedCount += static_cast<uint32_t>(hasParent) - static_cast<uint32_t>(hadParent);
+    parentColumn[dense] = parent;
+    hierarchyDirty = true;
+}
+
+kernels::TransformSoA Scene::localSoA() const {
+    const auto& c = localColumns;
+    return {c[0].data(), c[1].data(), c[2].data(), c[3].data(), c[4].data(),
+            c[5].data(), c[6].data(), c[7].data(), c[8].data(), c[9].data()};
+}
+
+kernels::AffineSoA Scene::worldSoA() {
+    kernels::AffineSoA soa{};
+    for (size_t element = 0; element < worldColumns.size(); element++) {
+        soa.m[element] = worldColumns[element].data();
+    }
+    return soa;
+}
+
+kernels::BoundsSoA Scene::boundsSoA(std::array<FloatColumn, 6>& columns) {
+    return {columns[0].data(), columns[1].data(), columns[2].data(),
+            columns[3].data(), columns[4].data(), columns[5].data()};
+}
+
+void Scene::sortByDepth() {
+    uint32_t count = size();
+    constexpr uint32_t unknown = UINT32_MAX;
+    std::vector<uint32_t> depth(count, unknown);
+    std::vector<uint32_t> chain;
+
+    for (uint32_t i = 0; i < count; i++) {
+        // climb until a root or an entity whose depth is known, then unwind
+        uint32_t current = i;
+        while (depth[current] == unknown) {
+            Entity parent = parentColumn[current];
+            if (parent == Entity{}) {
+                depth[current] = 0;
+                break;
+            }
+            if (!alive(parent)) {
+                parentColumn[current] = {};
+                parentedCount--;
+                depth[current] = 0;
+                break;
+            }
+            chain.push_back(current);
+            current = slots[parent.index].dense;
+        }
+        uint32_t base = depth[current];
+        while (!chain.empty()) {
+            depth[chain.back()] = ++base;
+            chain.pop_back();
+        }
+    }
+
+    // stable counting sort by depth
+    uint32_t maxDepth = count > 0 ? *std::max_element(depth.begin(), depth.end()) : 0;
+    std::vector<uint32_t> starts(maxDepth + 2, 0);
+    for (uint32_t d: depth) {
+        starts[d + 1]++;
+    }
+    for (size_t level = 1; level < starts.size(); level++) {
+        starts[level] += starts[level - 1];
+    }
+    levelEnds.assign(starts.begin() + 1, starts.end());
+
+    std::vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; i++) {
+        order[starts[depth[i]]++] = i;
+    }
+
+    forEachColumn([&order](auto& column) { permute(column, order); });
+
+    for (uint32_t i = 0; i < count; i++) {
+        slots[entityColumn[i].index].dense = i;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        Entity parent = parentColumn[i];
+        parentIndexColumn[i] = parent == Entity{} ? noParent : slots[parent.index].dense;
+    }
+    hierarchyDirty = false;
+    layoutChanges++;
+}
+
+void Scene::propagateRange(uint32_t begin, uint32_t end) {
+    kernels::AffineSoA world = worldSoA();
+    kernels::composeWorld(localSoA(), parentIndexColumn.data(), world, begin, end);
+    kernels::transformBounds(world, boundsSoA(localBoundsColumns), boundsSoA(worldBoundsColumns),
+                             radiusColumn.data(), begin, end);
+}
+
+void Scene::propagate(JobSystem* jobs, uint32_t grain) {
+    if (hierarchyDirty) {
+        sortByDepth();
+    }
+    if (parentedCount == 0) {
+        // flat scene: a single level, whatever creates and destroys happened
+        levelEnds.assign(1, size());
+    }
+
+    uint32_t begin = 0;
+    for (uint32_t end: levelEnds) {
+        if (jobs) {
+            jobs->parallelFor(end - begin, grain, [this, begin](uint32_t first, uint32_t last) {
+                propagateRange(begin + first, begin + last);
+            });
+        } else {
+            propagateRange(begin, end);
+        }
+        begin = end;
+    }
+}
+
+void Scene::cull(const Frustum& frustum, std::vector<uint32_t>& visible, JobSystem* jobs, uint32_t grain) const {
+    uint32_t count = size();
+    grain = std::max(grain, 1u);
+    uint32_t chunkCount = (count + grain - 1) / grain;
+    const auto& bounds = worldBoundsColumns;
+    kernels::SphereSoA spheres{bounds[0].data(), bounds[1].data(), bounds[2].data(), radiusColumn.data()};
+
+    // each chunk writes its survivors at its own offset, then the chunks are packed
+    visible.resize(count);
+    std::vector<uint32_t>& survivors = cullSurvivors;
+    survivors.assign(chunkCount, 0);
+    auto cullChunks = [&](uint32_t firstChunk, uint32_t lastChunk) {
+        for (uint32_t chunk = firstChunk; chunk < lastChunk; chunk++) {
+            uint32_t begin = chunk * grain;
+            uint32_t end = std::min(begin + grain, count);
+            uint32_t* out = visible.data() + begin;
+            uint32_t candidates = kernels::cullSpheres(spheres, frustum, begin, end, out);
+
+            uint32_t kept = 0;
+            for (uint32_t c = 0; c < candidates; c++) {
+                uint32_t i = out[c];
+                out[kept] = i;
+                kept += frustum.intersects(Bounds{{bounds[0][i], bounds[1][i], bounds[2][i]},
+                                                  {bounds[3][i], bounds[4][i], bounds[5][i]}});
+            }
+            survivors[chunk] = kept;
+        }
+    };
+    if (jobs) {
+        jobs->parallelFor(chunkCount, 1, cullChunks);
+    } else {
+        cullChunks(0, chunkCount);
+    }
+
+    uint32_t total = 0;
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++) {
+        if (total != chunk * grain) {
+            std::memmove(visible.data() + total, visible.data() + chunk * grain, survivors[chunk] * sizeof(uint32_t));
+        }
+        total += survivors[chunk];
+    }
+    visible.resize(total);
+}
@@ -0,0 +1,138 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "../math/Kernels.h"
+#include "../math/Math.h"
+
+class JobSystem;
+
+// Stable handle: `index` names a slot that is reused only after `generation` moves on.
+struct Entity {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const Entity&) const = default;
+};
+
+struct RenderHandle {
+    uint32_t mesh = 0;
+    uint32_t material = 0;
+};
+
+// Sparse-set entity store with structure-of-arrays columns: one float array
+// per component field (position x, rotation w, world matrix element, ...), so
+// the SIMD kernels in math/Kernels.h process 4-8 entities per instruction.
+// Every entity has a local transform, local bounds and a render handle;
+// propagate() derives the world transform, world bounds and bounding sphere
+// columns from them.
+//
+// Columns are indexed by dense index, which changes when entities are
+// destroyed or the hierarchy changes; entities keep their handle. The dense
+// order is kept sorted by hierarchy depth, so propagation walks each depth
+// level front to back with every parent already resolved, and each level can
+// be split across worker threads. Re-sorting after a hierarchy change is
+// O(n), so parent changes are meant to be occasional.
+class Scene {
+public:
+    static constexpr uint32_t noParent = kernels::noParent;
+
+    // Field order of the local transform columns.
+    enum class LocalField : uint32_t {
+        PositionX, PositionY, PositionZ,
+        RotationX, RotationY, RotationZ, RotationW,
+        ScaleX, ScaleY, ScaleZ,
+    };
+
+    void reserve(size_t count);
+
+    Entity create(const Transform& local = {}, const Bounds& bounds = {}, RenderHandle render = {});
+    // Children of a destroyed entity become roots, keeping their local transform.
+    void destroy(Entity entity);
+    [[nodiscard]] bool alive(Entity entity) const;
+
+    // A default Entity{} makes `child` a root. Throws std::invalid_argument on a cycle.
+    void setParent(Entity child, Entity parent);
+
+    [[nodiscard]] Transform local(Entity entity) const;
+    void setLocal(Entity entity, const Transform& local);
+    [[nodiscard]] Bounds localBounds(Entity entity) const;
+    void setLocalBounds(Entity entity, const Bounds& bounds);
+    RenderHandle& render(Entity entity) { return renderColumn[denseIndex(entity)]; }
+    [[nodiscard]] const RenderHandle& render(Entity entity) const { return renderColumn[denseIndex(entity)]; }
+    // valid after the last propagate()
+    [[nodiscard]] Affine world(Entity entity) const;
+    [[nodiscard]] Bounds worldBounds(Entity entity) const;
+
+    [[nodiscard]] uint32_t denseIndex(Entity entity) const;
+    [[nodiscard]] uint32_t size() const { return static_cast<uint32_t>(entityColumn.size()); }
+    // Changes whenever entities are created or destroyed or the dense order is
+    // re-sorted, i.e. whenever a cached dense index may have gone stale.
+    [[nodiscard]] uint64_t layoutVersion() const { return layoutChanges; }
+
+    // Recomputes every world transform and world bounds. With `jobs`, each
+    // depth level is split into chunks of `grain` entities.
+    void propagate(JobSystem* jobs = nullptr, uint32_t grain = 16384);
+
+    // Replaces `visible` with the dense indices, in order, of entities whose
+    // world bounds intersect `frustum`: a SIMD sphere test, then the exact box
+    // test on the survivors. Reuses per-scene scratch, so one scene must not be
+    // culled from several threads at once.
+    void cull(const Frustum& frustum, std::vector<uint32_t>& visible, JobSystem* jobs = nullptr,
+              uint32_t grain = 16384) const;
+
+    // Dense columns for systems that iterate everything.
+    [[nodiscard]] std::span<const Entity> entities() const { return entityColumn; }
+    std::span<float> localColumn(LocalField field) { return localColumns[static_cast<uint32_t>(field)]; }
+    std::span<RenderHandle> renderHandles() { return renderColumn; }
+    [[nodiscard]] std::span<const RenderHandle> renderHandles() const { return renderColumn; }
+    // row-major 3x4 element, 0-11
+    [[nodiscard]] std::span<const float> worldColumn(uint32_t element) const { return worldColumns[element]; }
+    // center xyz, extents xyz
+    [[nodiscard]] std::span<const float> worldBoundsColumn(uint32_t field) const { return worldBoundsColumns[field]; }
+
+private:
+    struct Slot {
+        uint32_t dense = noParent;
+        uint32_t generation = 0;
+    };
+
+    using FloatColumn = std::vector<float>;
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+
+    std::vector<Entity> entityColumn;
+    std::vector<Entity> parentColumn;
+    std::vector<uint32_t> parentIndexColumn;
+    std::array<FloatColumn, 10> localColumns;
+    // center xyz, extents xyz
+    std::array<FloatColumn, 6> localBoundsColumns;
+    std::array<FloatColumn, 12> worldColumns;
+    std::array<FloatColumn, 6> worldBoundsColumns;
+    FloatColumn radiusColumn;
+    std::vector<RenderHandle> renderColumn;
+
+    // end of each depth level in dense order; only meaningful while !hierarchyDirty
+    std::vector<uint32_t> levelEnds;
+    // survivor count of each chunk during cull(), kept to avoid a per-call allocation
+    mutable std::vector<uint32_t> cullSurvivors;
+    uint32_t parentedCount = 0;
+    bool hierarchyDirty = false;
+    uint64_t layoutChanges = 0;
+
+    template<typename F>
+    void forEachColumn(F&& function);
+
+    kernels::TransformSoA localSoA() const;
+    kernels::AffineSoA worldSoA();
+    static kernels::BoundsSoA boundsSoA(std::array<FloatColumn, 6>& columns);
+    void sortByDepth();
+    void propagateRange(uint32_t begin, uint32_t end);
+};
+
+#endif //SCENE_H
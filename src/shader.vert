@@ -1,11 +1,34 @@
 #version 450
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+// Mesh vertices in either layout of mesh/MeshData.h. The vertex formats
+// already normalize every attribute, so only positions need the per-mesh
+// scale and offset (identity for float layouts). Normals are octahedral
+// (two components, z reads as 0) or plain xyz, as positionScale.w says.
+layout (location = 0) in vec4 inPosition;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUv;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec2 outUv;
+
+// MeshConstants in mesh/GpuMesh.h; the first 16 bytes are bindless.glsl's DrawConstants
+layout (push_constant) uniform MeshConstants {
+    layout (offset = 16) mat4 transform;
+    vec4 positionOffset;
+    vec4 positionScale; // w: 1 for octahedral normals, 0 for xyz
+} mesh;
+
+vec3 decodeOctahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-}
\ No newline at end of file
+    vec3 position = mesh.positionOffset.xyz + inPosition.xyz * mesh.positionScale.xyz;
+    gl_Position = mesh.transform * vec4(position, 1.0);
+    outNormal = mesh.positionScale.w != 0.0 ? decodeOctahedral(inNormal.xy) : normalize(inNormal);
+    outUv = inUv;
+}
@@ -5,4 +5,9 @@
 #ifndef SHADERS_H
 #define SHADERS_H
 
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+void createShaderModule(VkDevice& device, const std::vector<char>& code, VkShaderModule& shaderModule);
+
 #endif //SHADERS_H
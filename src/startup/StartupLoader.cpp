@@ -0,0 +1,140 @@
+#include "StartupLoader.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "StartupTimeline.h"
+#include "../device.h"
+#include "../files.h"
+
+StartupLoader::StartupLoader(JobSystem& jobs, StartupTimeline* timeline) : jobs(jobs), timeline(timeline) {
+}
+
+StartupLoader::~StartupLoader() {
+    for (auto& [path, entry]: entries) {
+        jobs.wait(entry->done);
+    }
+}
+
+void StartupLoader::prefetch(const std::string& path) {
+    if (entries.contains(path)) {
+        return;
+    }
+    auto entry = std::make_unique<Entry>();
+    entry->path = path;
+    Entry* target = entry.get();
+    entries.emplace(path, std::move(entry));
+
+    StartupTimeline* spans = timeline;
+    jobs.run([target, spans] {
+        auto scope = startupScope(spans, "read " + target->path);
+        try {
+            target->data = utils::readFile(target->path);
+        } catch (...) {
+            target->error = std::current_exception();
+        }
+    }, &target->done);
+}
+
+void StartupLoader::prefetchPipelineCache(const std::string& path) {
+    pipelineCachePath = path;
+    prefetch(path);
+}
+
+StartupLoader::Entry& StartupLoader::wait(const std::string& path) {
+    auto it = entries.find(path);
+    if (it == entries.end()) {
+        prefetch(path);
+        it = entries.find(path);
+    }
+    jobs.wait(it->second->done);
+    return *it->second;
+}
+
+bool StartupLoader::loaded(const std::string& path) {
+    return !wait(path).error;
+}
+
+const std::vector<char>& StartupLoader::data(const std::string& path) {
+    Entry& entry = wait(path);
+    if (entry.error) {
+        std::rethrow_exception(entry.error);
+    }
+    return entry.data;
+}
+
+std::vector<VkShaderModule> StartupLoader::createShaderModules(Device& device, const std::vector<std::string>& paths) {
+    auto scope = startupScope(timeline, "create shader modules");
+
+    std::vector<const std::vector<char>*> code;
+    for (const std::string& path: paths) {
+        code.push_back(&data(path));
+    }
+
+    // vkCreateShaderModule has no external synchronization requirements, so modules can be made concurrently
+    std::vector<VkShaderModule> modules(paths.size(), VK_NULL_HANDLE);
+    std::vector<VkResult> results(paths.size(), VK_SUCCESS);
+    VkDevice logicalDevice = device.device();
+    jobs.parallelFor(static_cast<uint32_t>(paths.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; i++) {
+            VkShaderModuleCreateInfo createInfo{};
+            createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            createInfo.codeSize = code[i]->size();
+            createInfo.pCode = reinterpret_cast<const uint32_t*>(code[i]->data());
+            results[i] = vkCreateShaderModule(logicalDevice, &createInfo, nullptr, &modules[i]);
+        }
+    });
+
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (results[i] != VK_SUCCESS) {
+            for (VkShaderModule module: modules) {
+                vkDestroyShaderModule(logicalDevice, module, nullptr);
+            }
+            throw std::runtime_error("failed to create shader module for " + paths[i]);
+        }
+    }
+    return modules;
+}
+
+VkPipelineCache StartupLoader::createPipelineCache(Device& device) {
+    auto scope = startupScope(timeline, "create pipeline cache");
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+
+    if (!pipelineCachePath.empty() && loaded(pipelineCachePath)) {
+        const std::vector<char>& blob = data(pipelineCachePath);
+        // a blob from another GPU or driver version is legal to pass but useless, so drop it here
+        VkPipelineCacheHeaderVersionOne header{};
+        if (blob.size() >= sizeof(header)) {
+            std::memcpy(&header, blob.data(), sizeof(header));
+            bool matches = header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                           header.vendorID == device.properties.vendorID &&
+                           header.deviceID == device.properties.deviceID &&
+                           std::memcmp(header.pipelineCacheUUID, device.properties.pipelineCacheUUID,
+                                       VK_UUID_SIZE) == 0;
+            if (matches) {
+                cacheInfo.initialDataSize = blob.size();
+                cacheInfo.pInitialData = blob.data();
+            }
+        }
+    }
+
+    VkPipelineCache cache;
+    if (vkCreatePipelineCache(device.device(), &cacheInfo, nullptr, &cache) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+    return cache;
+}
+
+void StartupLoader::savePipelineCache(Device& device, VkPipelineCache cache, const std::string& path) {
+    size_t size = 0;
+    vkGetPipelineCacheData(device.device(), cache, &size, nullptr);
+    std::vector<char> blob(size);
+    if (vkGetPipelineCacheData(device.device(), cache, &size, blob.data()) != VK_SUCCESS) {
+        return;
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(blob.data(), static_cast<std::streamsize>(size));
+}
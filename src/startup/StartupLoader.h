@@ -0,0 +1,65 @@
+#ifndef STARTUP_LOADER_H
+#define STARTUP_LOADER_H
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "../jobs/JobSystem.h"
+
+class Device;
+class StartupTimeline;
+
+// Overlaps startup file I/O with device bring-up. Everything that does not
+// need a VkDevice (shader SPIR-V, the pipeline cache blob, assets) is read on
+// the job system as soon as it is requested; the device-dependent half
+// (shader modules, VkPipelineCache) runs once the device exists.
+//
+// Requests and lookups must come from the thread that owns the loader.
+class StartupLoader {
+public:
+    explicit StartupLoader(JobSystem& jobs, StartupTimeline* timeline = nullptr);
+    ~StartupLoader();
+
+    StartupLoader(const StartupLoader&) = delete;
+    StartupLoader& operator=(const StartupLoader&) = delete;
+
+    void prefetch(const std::string& path);
+
+    void prefetchPipelineCache(const std::string& path);
+
+    // Waits for `path`; false if it could not be read.
+    bool loaded(const std::string& path);
+
+    // Waits for `path` and returns its contents; rethrows the read error.
+    const std::vector<char>& data(const std::string& path);
+
+    // Creates modules for prefetched SPIR-V files in parallel.
+    std::vector<VkShaderModule> createShaderModules(Device& device, const std::vector<std::string>& paths);
+
+    // Seeded with the prefetched blob when its header matches this device and
+    // driver; an empty cache otherwise.
+    VkPipelineCache createPipelineCache(Device& device);
+
+    static void savePipelineCache(Device& device, VkPipelineCache cache, const std::string& path);
+
+private:
+    struct Entry {
+        std::string path;
+        std::vector<char> data;
+        std::exception_ptr error;
+        JobCounter done;
+    };
+
+    JobSystem& jobs;
+    StartupTimeline* timeline;
+    std::unordered_map<std::string, std::unique_ptr<Entry>> entries;
+    std::string pipelineCachePath;
+
+    Entry& wait(const std::string& path);
+};
+
+#endif //STARTUP_LOADER_H
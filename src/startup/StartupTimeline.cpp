@@ -0,0 +1,71 @@
+#include "StartupTimeline.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "../jobs/JobSystem.h"
+
+StartupTimeline::Scope::Scope(StartupTimeline* timeline, std::string name)
+    : timeline(timeline), name(std::move(name)), start(Clock::now()) {
+}
+
+StartupTimeline::Scope::~Scope() {
+    if (timeline) {
+        timeline->record(std::move(name), start, Clock::now());
+    }
+}
+
+StartupTimeline::StartupTimeline() : origin(Clock::now()) {
+}
+
+double StartupTimeline::sinceOrigin(Clock::time_point time) const {
+    return std::chrono::duration<double, std::milli>(time - origin).count();
+}
+
+void StartupTimeline::record(std::string name, Clock::time_point start, Clock::time_point end) {
+    Span span{std::move(name), JobSystem::currentThreadIndex(), sinceOrigin(start), sinceOrigin(end)};
+    std::lock_guard lock(mutex);
+    spans_.push_back(std::move(span));
+}
+
+void StartupTimeline::markFirstPoll() {
+    double now = sinceOrigin(Clock::now());
+    std::lock_guard lock(mutex);
+    if (firstPollMs < 0.0) {
+        firstPollMs = now;
+    }
+}
+
+double StartupTimeline::timeToFirstPollMs() const {
+    std::lock_guard lock(mutex);
+    return firstPollMs;
+}
+
+std::vector<StartupTimeline::Span> StartupTimeline::spans() const {
+    std::lock_guard lock(mutex);
+    std::vector<Span> sorted = spans_;
+    std::sort(sorted.begin(), sorted.end(), [](const Span& a, const Span& b) {
+        return a.startMs < b.startMs;
+    });
+    return sorted;
+}
+
+void StartupTimeline::report(std::ostream& out) const {
+    char line[160];
+    for (const Span& span: spans()) {
+        // threads outside the job system show up as '-'
+        if (span.thread == UINT32_MAX) {
+            std::snprintf(line, sizeof(line), "  %8.2f ms  %8.2f ms  [-] %s\n", span.startMs,
+                          span.endMs - span.startMs, span.name.c_str());
+        } else {
+            std::snprintf(line, sizeof(line), "  %8.2f ms  %8.2f ms  [%u] %s\n", span.startMs,
+                          span.endMs - span.startMs, span.thread, span.name.c_str());
+        }
+        out << line;
+    }
+    double firstPoll = timeToFirstPollMs();
+    if (firstPoll >= 0.0) {
+        std::snprintf(line, sizeof(line), "  time to first event poll: %.2f ms\n", firstPoll);
+        out << line;
+    }
+}
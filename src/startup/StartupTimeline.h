@@ -0,0 +1,73 @@
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Records named spans, in milliseconds since timeline construction, up to the
+// first pass of the main loop, from any thread, so startup time can be tracked
+// and its critical path read off directly. Construct it first thing in main();
+// time spent before that (loader, static initializers) is not counted. Nothing is presented yet, so the end mark is the first event
+// poll rather than a first frame.
+class StartupTimeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Span {
+        std::string name;
+        uint32_t thread;
+        double startMs;
+        double endMs;
+    };
+
+    class Scope {
+    public:
+        Scope(StartupTimeline* timeline, std::string name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        StartupTimeline* timeline;
+        std::string name;
+        Clock::time_point start;
+    };
+
+    StartupTimeline();
+
+    // records the span from now until the returned scope is destroyed
+    [[nodiscard]] Scope scope(std::string name) { return {this, std::move(name)}; }
+
+    void record(std::string name, Clock::time_point start, Clock::time_point end);
+
+    // Marks the end of startup at the first main loop event poll; only the
+    // first call counts.
+    void markFirstPoll();
+
+    // milliseconds from construction to markFirstPoll(), or -1 if not reached yet
+    [[nodiscard]] double timeToFirstPollMs() const;
+
+    [[nodiscard]] std::vector<Span> spans() const;
+
+    void report(std::ostream& out) const;
+
+private:
+    Clock::time_point origin;
+    mutable std::mutex mutex;
+    std::vector<Span> spans_;
+    double firstPollMs = -1.0;
+
+    [[nodiscard]] double sinceOrigin(Clock::time_point time) const;
+};
+
+// null-safe helper for optional timelines
+inline StartupTimeline::Scope startupScope(StartupTimeline* timeline, std::string name) {
+    return {timeline, std::move(name)};
+}
+
+#endif //STARTUP_TIMELINE_H
@@ -0,0 +1,162 @@
+#include "Ktx2.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#include "../files.h"
+
+namespace {
+    constexpr uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    struct Header {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+
+    struct LevelIndex {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    static_assert(sizeof(Header) == 80, "KTX2 header layout mismatch");
+    static_assert(sizeof(LevelIndex) == 24, "KTX2 level index layout mismatch");
+
+    struct BlockLayout {
+        uint32_t dimension;
+        uint32_t bytes;
+    };
+
+    // Block compressed formats pack 4x4 texels per block, the rest are one texel per "block".
+    BlockLayout blockLayout(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+            case VK_FORMAT_BC4_SNORM_BLOCK:
+                return {4, 8};
+            case VK_FORMAT_BC2_UNORM_BLOCK:
+            case VK_FORMAT_BC2_SRGB_BLOCK:
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+            case VK_FORMAT_BC6H_UFLOAT_BLOCK:
+            case VK_FORMAT_BC6H_SFLOAT_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return {4, 16};
+            case VK_FORMAT_R8_UNORM:
+            case VK_FORMAT_R8_SRGB:
+                return {1, 1};
+            case VK_FORMAT_R8G8_UNORM:
+            case VK_FORMAT_R8G8_SRGB:
+            case VK_FORMAT_R16_SFLOAT:
+                return {1, 2};
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+            case VK_FORMAT_R16G16_SFLOAT:
+            case VK_FORMAT_R32_SFLOAT:
+                return {1, 4};
+            case VK_FORMAT_R16G16B16A16_SFLOAT:
+            case VK_FORMAT_R32G32_SFLOAT:
+                return {1, 8};
+            case VK_FORMAT_R32G32B32A32_SFLOAT:
+                return {1, 16};
+            default:
+                throw std::runtime_error("unsupported ktx2 texture format!");
+        }
+    }
+
+    uint64_t levelByteSize(BlockLayout layout, uint32_t width, uint32_t height) {
+        uint64_t blocksWide = (width + layout.dimension - 1) / layout.dimension;
+        uint64_t blocksHigh = (height + layout.dimension - 1) / layout.dimension;
+        return blocksWide * blocksHigh * layout.bytes;
+    }
+}
+
+uint32_t Ktx2Image::fullMipCount() const {
+    return std::bit_width(std::max(width, height));
+}
+
+namespace ktx2 {
+    Ktx2Image parse(std::vector<char> fileData) {
+        if (fileData.size() < sizeof(Header)) {
+            throw std::runtime_error("ktx2 file is truncated!");
+        }
+
+        Header header;
+        std::memcpy(&header, fileData.data(), sizeof(Header));
+        if (std::memcmp(header.identifier, identifier, sizeof(identifier)) != 0) {
+            throw std::runtime_error("not a ktx2 file!");
+        }
+        if (header.supercompressionScheme != 0) {
+            throw std::runtime_error("supercompressed ktx2 files are not supported!");
+        }
+        if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 ||
+            header.pixelWidth == 0 || header.pixelHeight == 0) {
+            throw std::runtime_error("only 2D ktx2 textures are supported!");
+        }
+
+        Ktx2Image image;
+        image.format = static_cast<VkFormat>(header.vkFormat);
+        image.width = header.pixelWidth;
+        image.height = header.pixelHeight;
+        image.generateMips = header.levelCount == 0;
+        if (header.levelCount > image.fullMipCount()) {
+            throw std::runtime_error("ktx2 file has more levels than its extent allows!");
+        }
+        BlockLayout layout = blockLayout(image.format);
+
+        uint32_t storedLevels = std::max(header.levelCount, 1u);
+        if (sizeof(Header) + storedLevels * sizeof(LevelIndex) > fileData.size()) {
+            throw std::runtime_error("ktx2 level index is truncated!");
+        }
+
+        image.levels.resize(storedLevels);
+        for (uint32_t level = 0; level < storedLevels; level++) {
+            LevelIndex index;
+            std::memcpy(&index, fileData.data() + sizeof(Header) + level * sizeof(LevelIndex), sizeof(LevelIndex));
+            if (index.byteOffset > fileData.size() || index.byteLength > fileData.size() - index.byteOffset) {
+                throw std::runtime_error("ktx2 level data is out of bounds!");
+            }
+            uint32_t levelWidth = std::max(image.width >> level, 1u);
+            uint32_t levelHeight = std::max(image.height >> level, 1u);
+            if (index.byteLength < levelByteSize(layout, levelWidth, levelHeight)) {
+                throw std::runtime_error("ktx2 level data is smaller than its extent requires!");
+            }
+            image.levels[level] = {index.byteOffset, index.byteLength};
+        }
+
+        image.data = std::move(fileData);
+        return image;
+    }
+
+    Ktx2Image load(const std::string& filename) {
+        return parse(utils::readFile(filename));
+    }
+
+    bool isBlockCompressed(VkFormat format) {
+        return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+struct Ktx2Level {
+    uint64_t offset;
+    uint64_t size;
+};
+
+// Container-level view of a KTX2 file. Only plain 2D textures without
+// supercompression, in BC1-7 or common 8/16/32-bit color formats, are
+// accepted; the payload is left untouched so block compressed levels can be
+// copied straight into a staging buffer.
+struct Ktx2Image {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    // levels[0] is the full-resolution mip
+    std::vector<Ktx2Level> levels;
+    // the file asked the loader to build the mip chain from level 0
+    bool generateMips = false;
+    std::vector<char> data;
+
+    [[nodiscard]] uint32_t fullMipCount() const;
+};
+
+namespace ktx2 {
+    Ktx2Image parse(std::vector<char> fileData);
+
+    Ktx2Image load(const std::string& filename);
+
+    bool isBlockCompressed(VkFormat format);
+}
+
+#endif //KTX2_H
@@ -0,0 +1,437 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "Ktx2.h"
+#include "../device.h"
+#include "../memory/ResidencyManager.h"
+
+namespace {
+    // satisfies both the 4-byte copy rule and the BC block size
+    constexpr VkDeviceSize stagingAlignment = 16;
+
+    VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    uint32_t mipExtent(uint32_t extent, uint32_t level) {
+        return std::max(extent >> level, 1u);
+    }
+
+    VkImageMemoryBarrier mipBarrier(VkImage image, uint32_t baseMip, uint32_t mipCount,
+                                    VkImageLayout oldLayout, VkImageLayout newLayout,
+                                    VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = oldLayout;
+        barrier.newLayout = newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = baseMip;
+        barrier.subresourceRange.levelCount = mipCount;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = srcAccess;
+        barrier.dstAccessMask = dstAccess;
+        return barrier;
+    }
+}
+
+TextureStreamer::TextureStreamer(Device& device, JobSystem& jobs) : device(device), jobs(jobs) {
+}
+
+TextureStreamer::~TextureStreamer() {
+    jobs.wait(pendingLoads);
+
+    for (auto& batch: inFlight) {
+        vkWaitForFences(device.device(), 1, &batch.fence, VK_TRUE, UINT64_MAX);
+        device.releaseSingleTimeCommands(batch.commandBuffer, batch.fence);
+    }
+    for (auto& stagedTexture: staged) {
+        releaseStaging(stagedTexture);
+    }
+    for (auto& texture: textures) {
+        if (residency && texture.residencyId != untracked) {
+            residency->untrack(texture.residencyId);
+        }
+        releaseStaging(texture.staged);
+        vkDestroyImageView(device.device(), texture.view, nullptr);
+        vkDestroyImage(device.device(), texture.image, nullptr);
+        vkFreeMemory(device.device(), texture.memory, nullptr);
+    }
+}
+
+TextureHandle TextureStreamer::request(const std::string& path) {
+    auto handle = static_cast<TextureHandle>(textures.size());
+    Texture& texture = textures.emplace_back();
+    texture.path = path;
+    enqueueLoad(handle);
+    return handle;
+}
+
+void TextureStreamer::enqueueLoad(TextureHandle handle) {
+    jobs.run([this, handle, path = textures[handle].path] {
+        StagedTexture result;
+        try {
+            result = stage(handle, path);
+        } catch (const std::exception&) {
+            result = {};
+            result.handle = handle;
+            result.failed = true;
+        }
+
+        std::lock_guard lock(mutex);
+        staged.push_back(std::move(result));
+    }, &pendingLoads);
+}
+
+void TextureStreamer::setResidencyManager(ResidencyManager* manager) {
+    residency = manager;
+}
+
+void TextureStreamer::markUsed(TextureHandle handle) {
+    if (residency && textures[handle].residencyId != untracked) {
+        residency->touch(textures[handle].residencyId);
+    }
+}
+
+VkDeviceSize TextureStreamer::evict(TextureHandle handle) {
+    Texture& texture = textures[handle];
+    if (texture.uploadInFlight || (texture.state != State::Resident && texture.state != State::Uploading)) {
+        return 0;
+    }
+
+    // frames still in flight may sample the image, so it goes the way of its view
+    DeletionQueue& deletionQueue = device.deletionQueue();
+    deletionQueue.enqueue(texture.view);
+    deletionQueue.enqueue(texture.image);
+    deletionQueue.enqueue(texture.memory);
+    releaseStaging(texture.staged);
+
+    texture.view = VK_NULL_HANDLE;
+    texture.image = VK_NULL_HANDLE;
+    texture.memory = VK_NULL_HANDLE;
+    texture.state = State::Evicted;
+    return std::exchange(texture.memorySize, 0);
+}
+
+void TextureStreamer::reload(TextureHandle handle) {
+    Texture& texture = textures[handle];
+    if (texture.state != State::Evicted) {
+        return;
+    }
+    texture.state = State::Loading;
+    enqueueLoad(handle);
+}
+
+TextureStreamer::StagedTexture TextureStreamer::stage(TextureHandle handle, const std::string& path) {
+    Ktx2Image image = ktx2::load(path);
+
+    StagedTexture result;
+    result.handle = handle;
+    result.width = image.width;
+    result.height = image.height;
+
+    const VkFormatFeatureFlags sampled = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+    const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    result.generateMips = image.generateMips && !ktx2::isBlockCompressed(image.format);
+    if (result.generateMips) {
+        try {
+            result.format = device.findSupportedFormat({image.format}, VK_IMAGE_TILING_OPTIMAL, sampled | blit);
+        } catch (const std::runtime_error&) {
+            result.generateMips = false;
+        }
+    }
+    if (!result.generateMips) {
+        result.format = device.findSupportedFormat({image.format}, VK_IMAGE_TILING_OPTIMAL, sampled);
+    }
+    result.mipLevels = result.generateMips ? image.fullMipCount() : static_cast<uint32_t>(image.levels.size());
+
+    VkDeviceSize stagingSize = 0;
+    for (const auto& level: image.levels) {
+        result.levelOffsets.push_back(stagingSize);
+        stagingSize = alignUp(stagingSize + level.size, stagingAlignment);
+    }
+
+    device.createBuffer(
+        stagingSize,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        result.stagingBuffer,
+        result.stagingMemory);
+
+    void* mapped;
+    vkMapMemory(device.device(), result.stagingMemory, 0, stagingSize, 0, &mapped);
+    for (size_t level = 0; level < image.levels.size(); level++) {
+        std::memcpy(static_cast<char*>(mapped) + result.levelOffsets[level],
+                    image.data.data() + image.levels[level].offset,
+                    image.levels[level].size);
+    }
+    vkUnmapMemory(device.device(), result.stagingMemory);
+
+    return result;
+}
+
+void TextureStreamer::update() {
+    retireCompletedBatches();
+
+    std::vector<StagedTexture> ready;
+    {
+        std::lock_guard lock(mutex);
+        ready.swap(staged);
+    }
+    for (auto& stagedTexture: ready) {
+        Texture& texture = textures[stagedTexture.handle];
+        if (stagedTexture.failed) {
+            texture.state = State::Failed;
+            continue;
+        }
+        texture.staged = std::move(stagedTexture);
+        createImage(texture);
+        texture.state = State::Uploading;
+    }
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    Batch batch{};
+    for (TextureHandle handle = 0; handle < textures.size(); handle++) {
+        Texture& texture = textures[handle];
+        if (texture.state != State::Uploading || texture.uploadInFlight) {
+            continue;
+        }
+        if (commandBuffer == VK_NULL_HANDLE) {
+            commandBuffer = device.beginSingleTimeCommands();
+        }
+
+        uint32_t mipLevels = texture.staged.mipLevels;
+        uint32_t firstMip;
+        if (texture.staged.generateMips) {
+            recordMipGeneration(commandBuffer, texture);
+            firstMip = 0;
+        } else if (texture.recordedMip == mipLevels) {
+            // first batch: the whole coarse tail at once
+            firstMip = mipLevels - 1;
+            while (firstMip > 0 &&
+                   std::max(mipExtent(texture.staged.width, firstMip - 1),
+                            mipExtent(texture.staged.height, firstMip - 1)) <= coarseMipExtent) {
+                firstMip--;
+            }
+            recordUpload(commandBuffer, texture, firstMip, mipLevels);
+        } else {
+            firstMip = texture.recordedMip - 1;
+            recordUpload(commandBuffer, texture, firstMip, texture.recordedMip);
+        }
+
+        texture.recordedMip = firstMip;
+        texture.uploadInFlight = true;
+        batch.residency.emplace_back(handle, firstMip);
+    }
+
+    if (commandBuffer != VK_NULL_HANDLE) {
+        batch.commandBuffer = commandBuffer;
+        batch.fence = device.submitSingleTimeCommands(commandBuffer);
+        inFlight.push_back(std::move(batch));
+    }
+}
+
+void TextureStreamer::retireCompletedBatches() {
+    auto completed = std::partition(inFlight.begin(), inFlight.end(), [this](const Batch& batch) {
+        return vkGetFenceStatus(device.device(), batch.fence) != VK_SUCCESS;
+    });
+
+    for (auto it = completed; it != inFlight.end(); ++it) {
+        for (auto [handle, residentMip]: it->residency) {
+            Texture& texture = textures[handle];
+            updateView(texture, residentMip);
+            texture.uploadInFlight = false;
+            if (residentMip == 0) {
+                releaseStaging(texture.staged);
+                texture.state = State::Resident;
+            }
+        }
+        device.releaseSingleTimeCommands(it->commandBuffer, it->fence);
+    }
+    inFlight.erase(completed, inFlight.end());
+}
+
+void TextureStreamer::createImage(Texture& texture) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = texture.staged.format;
+    imageInfo.extent = {texture.staged.width, texture.staged.height, 1};
+    imageInfo.mipLevels = texture.staged.mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (texture.staged.generateMips) {
+        imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, texture.image, texture.memory);
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device.device(), texture.image, &memRequirements);
+    texture.memorySize = memRequirements.size;
+    if (residency && texture.residencyId == untracked) {
+        TextureHandle handle = texture.staged.handle;
+        texture.residencyId = residency->track(
+            device.findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT),
+            texture.memorySize,
+            [this, handle](VkDeviceSize) { return evict(handle); },
+            [this, handle] { reload(handle); });
+    } else if (residency) {
+        residency->resize(texture.residencyId, texture.memorySize);
+    }
+
+    texture.residentMip = texture.staged.mipLevels;
+    texture.recordedMip = texture.staged.mipLevels;
+}
+
+void TextureStreamer::recordUpload(VkCommandBuffer commandBuffer, Texture& texture, uint32_t firstMip,
+                                   uint32_t endMip) {
+    uint32_t mipCount = endMip - firstMip;
+
+    VkImageMemoryBarrier toTransfer = mipBarrier(
+        texture.image, firstMip, mipCount,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    std::vector<VkBufferImageCopy> regions(mipCount);
+    for (uint32_t i = 0; i < mipCount; i++) {
+        uint32_t level = firstMip + i;
+        VkBufferImageCopy& region = regions[i];
+        region.bufferOffset = texture.staged.levelOffsets[level];
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageExtent = {mipExtent(texture.staged.width, level), mipExtent(texture.staged.height, level), 1};
+    }
+    vkCmdCopyBufferToImage(commandBuffer, texture.staged.stagingBuffer, texture.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()), regions.data());
+
+    VkImageMemoryBarrier toShader = mipBarrier(
+        texture.image, firstMip, mipCount,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &toShader);
+}
+
+void TextureStreamer::recordMipGeneration(VkCommandBuffer commandBuffer, Texture& texture) {
+    uint32_t mipLevels = texture.staged.mipLevels;
+
+    VkImageMemoryBarrier toTransfer = mipBarrier(
+        texture.image, 0, mipLevels,
+        VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = texture.staged.levelOffsets[0];
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {texture.staged.width, texture.staged.height, 1};
+    vkCmdCopyBufferToImage(commandBuffer, texture.staged.stagingBuffer, texture.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    for (uint32_t level = 1; level < mipLevels; level++) {
+        VkImageMemoryBarrier toSource = mipBarrier(
+            texture.image, level - 1, 1,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &toSource);
+
+        VkImageBlit blit{};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, 1};
+        blit.srcOffsets[1] = {
+            static_cast<int32_t>(mipExtent(texture.staged.width, level - 1)),
+            static_cast<int32_t>(mipExtent(texture.staged.height, level - 1)), 1
+        };
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        blit.dstOffsets[1] = {
+            static_cast<int32_t>(mipExtent(texture.staged.width, level)),
+            static_cast<int32_t>(mipExtent(texture.staged.height, level)), 1
+        };
+        vkCmdBlitImage(commandBuffer,
+                       texture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       texture.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &blit, VK_FILTER_LINEAR);
+    }
+
+    VkImageMemoryBarrier toShader[2] = {
+        mipBarrier(texture.image, 0, mipLevels - 1,
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                   VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT),
+        mipBarrier(texture.image, mipLevels - 1, 1,
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                   VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT),
+    };
+    // a single-level chain has nothing in TRANSFER_SRC
+    uint32_t first = mipLevels > 1 ? 0 : 1;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 2 - first, &toShader[first]);
+}
+
+void TextureStreamer::updateView(Texture& texture, uint32_t residentMip) {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = texture.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = texture.staged.format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.baseMipLevel = residentMip;
+    viewInfo.subresourceRange.levelCount = texture.staged.mipLevels - residentMip;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView view;
+    if (vkCreateImageView(device.device(), &viewInfo, nullptr, &view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture image view!");
+    }
+    device.deletionQueue().enqueue(texture.view);
+    texture.view = view;
+    texture.residentMip = residentMip;
+}
+
+void TextureStreamer::releaseStaging(StagedTexture& stagedTexture) {
+    if (stagedTexture.stagingBuffer == VK_NULL_HANDLE) {
+        return;
+    }
+    vkDestroyBuffer(device.device(), stagedTexture.stagingBuffer, nullptr);
+    vkFreeMemory(device.device(), stagedTexture.stagingMemory, nullptr);
+    stagedTexture.stagingBuffer = VK_NULL_HANDLE;
+    stagedTexture.stagingMemory = VK_NULL_HANDLE;
+}
+
+bool TextureStreamer::isResident(TextureHandle handle) const {
+    return textures[handle].view != VK_NULL_HANDLE;
+}
+
+bool TextureStreamer::hasFailed(TextureHandle handle) const {
+    return textures[handle].state == State::Failed;
+}
+
+uint32_t TextureStreamer::residentMip(TextureHandle handle) const {
+    return textures[handle].residentMip;
+}
+
+VkImageView TextureStreamer::view(TextureHandle handle) const {
+    return textures[handle].view;
+}
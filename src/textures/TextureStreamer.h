@@ -0,0 +1,127 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+#include "../jobs/JobSystem.h"
+
+class Device;
+class ResidencyManager;
+
+using TextureHandle = uint32_t;
+
+// Loads KTX2 textures in three stages:
+//  1. jobs on the JobSystem read and parse the file and copy every stored mip into a
+//     host-visible staging buffer;
+//  2. update() records the uploads of all textures that are ready into a single
+//     command buffer and submits it without waiting;
+//  3. once that submission's fence signals, the texture's view is widened to
+//     the newly resident mips.
+// Textures with a stored mip chain become resident coarse mips first: the
+// small tail arrives in the first batch and each following update() adds one
+// finer level. Files that ask for generated mips get their chain blitted from
+// level 0 in one go.
+class TextureStreamer {
+public:
+    // mips at or below this extent are uploaded together in the first batch
+    static constexpr uint32_t coarseMipExtent = 64;
+
+    TextureStreamer(Device& device, JobSystem& jobs);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    TextureHandle request(const std::string& path);
+
+    // Registers every texture image with the manager so it can be evicted under
+    // memory pressure and streamed back in when next used.
+    void setResidencyManager(ResidencyManager* manager);
+
+    // Records that the texture is referenced by the frame being built.
+    void markUsed(TextureHandle handle);
+
+    // Render-thread pump; call once per frame.
+    void update();
+
+    [[nodiscard]] bool isResident(TextureHandle handle) const;
+    [[nodiscard]] bool hasFailed(TextureHandle handle) const;
+    [[nodiscard]] uint32_t residentMip(TextureHandle handle) const;
+    [[nodiscard]] VkImageView view(TextureHandle handle) const;
+
+private:
+    enum class State { Loading, Uploading, Resident, Evicted, Failed };
+
+    static constexpr uint32_t untracked = UINT32_MAX;
+
+    struct StagedTexture {
+        TextureHandle handle;
+        bool failed = false;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipLevels = 0;
+        bool generateMips = false;
+        VkBuffer stagingBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+        std::vector<VkDeviceSize> levelOffsets;
+    };
+
+    struct Texture {
+        State state = State::Loading;
+        std::string path;
+        StagedTexture staged;
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDeviceSize memorySize = 0;
+        uint32_t residencyId = untracked;
+        // finest resident level; equals mipLevels while nothing is resident
+        uint32_t residentMip = 0;
+        // finest level already recorded into a batch
+        uint32_t recordedMip = 0;
+        bool uploadInFlight = false;
+    };
+
+    struct Batch {
+        VkCommandBuffer commandBuffer;
+        VkFence fence;
+        std::vector<std::pair<TextureHandle, uint32_t>> residency;
+    };
+
+    Device& device;
+    ResidencyManager* residency = nullptr;
+    std::vector<Texture> textures;
+    std::vector<Batch> inFlight;
+
+    JobSystem& jobs;
+    JobCounter pendingLoads;
+    std::mutex mutex;
+    std::vector<StagedTexture> staged;
+
+    StagedTexture stage(TextureHandle handle, const std::string& path);
+
+    void retireCompletedBatches();
+
+    void createImage(Texture& texture);
+
+    void recordUpload(VkCommandBuffer commandBuffer, Texture& texture, uint32_t firstMip, uint32_t endMip);
+
+    void recordMipGeneration(VkCommandBuffer commandBuffer, Texture& texture);
+
+    void updateView(Texture& texture, uint32_t residentMip);
+
+    void releaseStaging(StagedTexture& stagedTexture);
+
+    VkDeviceSize evict(TextureHandle handle);
+
+    void reload(TextureHandle handle);
+
+    void enqueueLoad(TextureHandle handle);
+};
+
+#endif //TEXTURE_STREAMER_H